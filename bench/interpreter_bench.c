@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "assembler.h"
+#include "code_generator.h"
+#include "interpreter.h"
+#include "jit.h"
+#include "lexer.h"
+#include "parser.h"
+
+#define BENCH_REPEATS 5
+#define BENCH_SOURCE_SIZE (1 << 18)
+
+typedef struct {
+    const char *name;
+    int depth;
+    int statements;
+} bench_program;
+
+// NOTE: f<k> calls f<k-1> twice, main runs 2^depth function bodies
+static void bench_generate(bench_program *program, char *source) {
+    source[0] = '\0';
+
+    for (int k = 0; k <= program->depth; k++) {
+        char line[256];
+
+        snprintf(line, sizeof(line), "int f%d() { int x0 = %d;", k, k + 3);
+        strcat(source, line);
+
+        // NOTE: locals are never reassigned, each step is a new one
+        int last = 0;
+
+        if (k > 0) {
+            snprintf(line, sizeof(line), " int x1 = x0 + f%d() - f%d() / 3;",
+                     k - 1, k - 1);
+            strcat(source, line);
+            last = 1;
+        }
+
+        for (int i = 0; i < program->statements; i++) {
+            snprintf(line, sizeof(line), " int x%d = x%d * %d + %d - x%d / %d;",
+                     last + 1, last, i + 3, i, last, i + 2);
+            strcat(source, line);
+            last++;
+        }
+
+        snprintf(line, sizeof(line), " return x%d; }\n", last);
+        strcat(source, line);
+    }
+
+    char line[64];
+    snprintf(line, sizeof(line), "int main() { return f%d(); }\n",
+             program->depth);
+    strcat(source, line);
+}
+
+static double bench_seconds(void) {
+    struct timespec time;
+    timespec_get(&time, TIME_UTC);
+
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static c_ast_program *bench_parse(const char *source,
+                                  c_parser **parser,
+                                  c_error_context **error_context) {
+    *error_context = c_error_context_create();
+    c_lexer *lexer = c_lexer_create(source);
+    c_token *tokens = c_lexer_lex(lexer);
+    c_lexer_free(lexer);
+    *parser = c_parser_create(tokens, *error_context, "bench.c");
+    c_ast_program *program = c_parser_parse(*parser);
+
+    if (c_error_context_has_errors(*error_context)) {
+        c_error_context_print(*error_context, stderr);
+        exit(EXIT_FAILURE);
+    }
+
+    return program;
+}
+
+static void bench_run(bench_program *program) {
+    static char source[BENCH_SOURCE_SIZE];
+    c_parser *parser;
+    c_error_context *error_context;
+
+    bench_generate(program, source);
+    c_ast_program *ast = bench_parse(source, &parser, &error_context);
+
+    double start = bench_seconds();
+    c_bytecode_module *module = c_bytecode_compile(ast);
+    double interpreter_compile = bench_seconds() - start;
+
+    start = bench_seconds();
+    c_mir_module *machine =
+        c_code_gen_select_program(ast, c_code_gen_options_for_level(2));
+    c_asm_object *object = c_asm_assemble_module(machine);
+    double native_compile = bench_seconds() - start;
+
+    int interpreted = 0;
+    int native = 0;
+    double interpreter_time = 0;
+    double native_time = 0;
+
+    for (int i = 0; i < BENCH_REPEATS; i++) {
+        start = bench_seconds();
+        c_interpreter_status status =
+            c_interpreter_run(module, C_INTERPRETER_ENTRY, &interpreted);
+        interpreter_time += bench_seconds() - start;
+
+        if (status != C_INTERPRETER_OK) {
+            fprintf(stderr, "%s: %s\n", program->name,
+                    c_interpreter_status_to_string(status));
+            exit(EXIT_FAILURE);
+        }
+
+        start = bench_seconds();
+        native = c_jit_run(object, C_JIT_ENTRY);
+        native_time += bench_seconds() - start;
+    }
+
+    // NOTE: function bodies executed per second
+    double bodies = (double)(1 << program->depth) * BENCH_REPEATS;
+
+    printf("%-8s compile: bytecode %8.3f ms, native %8.3f ms\n",
+           program->name, interpreter_compile * 1e3, native_compile * 1e3);
+    printf("%-8s run:     bytecode %8.3f ms, native %8.3f ms, "
+           "%.1fx slower, %.2f M calls/s interpreted%s\n",
+           program->name, interpreter_time * 1e3 / BENCH_REPEATS,
+           native_time * 1e3 / BENCH_REPEATS, interpreter_time / native_time,
+           bodies / interpreter_time / 1e6,
+           interpreted == native ? "" : " (RESULTS DIFFER)");
+
+    c_asm_object_free(object);
+    c_mir_module_free(machine);
+    c_bytecode_module_free(module);
+    c_parser_free_program(ast);
+    c_parser_free(parser);
+    c_error_context_free(error_context);
+
+    if (interpreted != native) {
+        exit(EXIT_FAILURE);
+    }
+}
+
+int main(void) {
+    bench_program programs[] = {
+        {"calls", 20, 0},
+        {"mixed", 16, 8},
+        {"straight", 10, 200},
+    };
+
+    for (size_t i = 0; i < sizeof(programs) / sizeof(programs[0]); i++) {
+        bench_run(&programs[i]);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,20 +1,171 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "assembler.h"
 #include "code_generator.h"
+#include "constant_folding.h"
+#include "elf64.h"
+#include "jit.h"
 #include "error.h"
+#include "evaluator.h"
+#include "inliner.h"
+#include "interprocedural.h"
+#include "interpreter.h"
 #include "lexer.h"
+#include "linker.h"
 #include "parser.h"
+#include "peephole.h"
 #include "utils.h"
 #include "stb_ds.h"
 #include "str.h"
+#include "thread_pool.h"
+
+typedef enum {
+    C_EMIT_ASM,
+    C_EMIT_OBJECT,
+    C_EMIT_EXECUTABLE,
+    // NOTE: jit compiles and calls main in this process
+    C_EMIT_RUN,
+    // NOTE: runs main on bytecode, no machine code is generated
+    C_EMIT_INTERPRET,
+} c_emit_kind;
+
+static void write_bytes(const char *path, uint8_t *bytes, int executable) {
+    FILE *file = fopen(path, "wb");
+
+    if (!file) {
+        EXIT_WITH_ERROR("Failed to open %s for writing\n", path);
+    }
+
+    fwrite(bytes, 1, arrlen(bytes), file);
+    fclose(file);
+
+    if (executable) {
+        chmod(path, 0755);
+    }
+}
+
+static void write_lines(const char *path, char **lines) {
+    FILE *file = fopen(path, "w");
+
+    if (!file) {
+        EXIT_WITH_ERROR("Failed to open %s for writing\n", path);
+    }
+
+    for (int i = 0; i < arrlen(lines); i++) {
+        fprintf(file, "%s\n", lines[i]);
+    }
+    fclose(file);
+}
 
 int main(int argc, char *argv[]) {
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s <source_file>\n", argv[0]);
+    const char *source_path = NULL;
+    int optimization_level = 0;
+    int omit_frame_pointer = -1;
+    int tail_calls = -1;
+    int schedule = -1;
+    const c_schedule_model *tune = NULL;
+    int jobs = 1;
+    int peephole_stats = 0;
+    // NOTE: -1 follows the optimization level
+    int evaluate_calls = -1;
+    int propagate_returns = -1;
+    int inline_functions = -1;
+    int inline_threshold = C_INLINE_DEFAULT_THRESHOLD;
+    c_emit_kind emit = C_EMIT_EXECUTABLE;
+    int exit_code = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "-O", 2) == 0) {
+            optimization_level = atoi(argv[i] + 2);
+        } else if (strncmp(argv[i], "-j", 2) == 0) {
+            jobs = atoi(argv[i] + 2);
+        } else if (strcmp(argv[i], "--peephole-stats") == 0) {
+            peephole_stats = 1;
+        } else if (strcmp(argv[i], "-fomit-frame-pointer") == 0) {
+            omit_frame_pointer = 1;
+        } else if (strcmp(argv[i], "-fno-omit-frame-pointer") == 0) {
+            omit_frame_pointer = 0;
+        } else if (strcmp(argv[i], "-foptimize-sibling-calls") == 0) {
+            tail_calls = 1;
+        } else if (strcmp(argv[i], "-fno-optimize-sibling-calls") == 0) {
+            tail_calls = 0;
+        } else if (strcmp(argv[i], "-fschedule-insns") == 0) {
+            schedule = 1;
+        } else if (strcmp(argv[i], "-fno-schedule-insns") == 0) {
+            schedule = 0;
+        } else if (strncmp(argv[i], "-mtune=", 7) == 0) {
+            tune = c_schedule_model_for(argv[i] + 7);
+
+            if (!tune) {
+                fprintf(stderr, "Unknown -mtune cpu: %s\n", argv[i] + 7);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "-fevaluate-calls") == 0) {
+            evaluate_calls = 1;
+        } else if (strcmp(argv[i], "-fno-evaluate-calls") == 0) {
+            evaluate_calls = 0;
+        } else if (strcmp(argv[i], "-fipa-cp") == 0) {
+            propagate_returns = 1;
+        } else if (strcmp(argv[i], "-fno-ipa-cp") == 0) {
+            propagate_returns = 0;
+        } else if (strcmp(argv[i], "-finline") == 0) {
+            inline_functions = 1;
+        } else if (strcmp(argv[i], "-fno-inline") == 0) {
+            inline_functions = 0;
+        } else if (strncmp(argv[i], "-finline-threshold=", 19) == 0) {
+            inline_threshold = atoi(argv[i] + 19);
+        } else if (strcmp(argv[i], "--emit=asm") == 0) {
+            emit = C_EMIT_ASM;
+        } else if (strcmp(argv[i], "--emit=obj") == 0) {
+            emit = C_EMIT_OBJECT;
+        } else if (strcmp(argv[i], "--emit=exe") == 0) {
+            emit = C_EMIT_EXECUTABLE;
+        } else if (strcmp(argv[i], "--run") == 0) {
+            emit = C_EMIT_RUN;
+        } else if (strcmp(argv[i], "--interpret") == 0) {
+            emit = C_EMIT_INTERPRET;
+        } else {
+            source_path = argv[i];
+        }
+    }
+
+    c_code_gen_options options =
+        c_code_gen_options_for_level(optimization_level);
+
+    if (omit_frame_pointer != -1) {
+        options.omit_frame_pointer = omit_frame_pointer;
+    }
+
+    if (tail_calls != -1) {
+        options.tail_calls = tail_calls;
+    }
+
+    if (schedule != -1) {
+        options.schedule = schedule;
+    }
+
+    if (tune) {
+        options.tune = tune;
+    }
+
+    // NOTE: -j0 uses every online cpu
+    options.jobs = jobs > 0 ? jobs : c_thread_pool_online_cpus();
+
+    if (!source_path) {
+        fprintf(stderr,
+                "Usage: %s [-O<level>] [-j<jobs>] [-f[no-]omit-frame-pointer] "
+                "[-f[no-]optimize-sibling-calls] [-f[no-]evaluate-calls] "
+                "[-f[no-]ipa-cp] [-f[no-]inline] "
+                "[-finline-threshold=<n>] [-f[no-]schedule-insns] "
+                "[-mtune=generic|skylake|znver3] [--peephole-stats] "
+                "[--emit=asm|obj|exe] [--run] [--interpret] <source_file>\n",
+                argv[0]);
         return EXIT_FAILURE;
     }
 
-    char *source = read_file_to_buffer(argv[1]);
+    char *source = read_file_to_buffer(source_path);
 
     if (!source) {
         return EXIT_FAILURE;
@@ -31,7 +182,7 @@ int main(int argc, char *argv[]) {
     c_lexer *lexer = c_lexer_create(source);
     c_token *tokens = c_lexer_lex(lexer);
 
-    c_parser *parser = c_parser_create(tokens, error_context, argv[1]);
+    c_parser *parser = c_parser_create(tokens, error_context, source_path);
 
     c_ast_program *program = c_parser_parse(parser);
 
@@ -45,32 +196,102 @@ int main(int argc, char *argv[]) {
         return EXIT_FAILURE;
     }
 
-    FILE *file = fopen("c.asm", "w");
+    if (evaluate_calls == -1) {
+        evaluate_calls = optimization_level >= 1;
+    }
 
-    if (!file) {
+    if (evaluate_calls) {
+        c_eval_program(program);
+    }
+
+    if (propagate_returns == -1) {
+        propagate_returns = optimization_level >= 2;
+    }
+
+    if (propagate_returns) {
+        c_ipa_propagate_program(program);
+    }
+
+    if (inline_functions == -1) {
+        inline_functions = optimization_level >= 1;
+    }
+
+    if (inline_functions) {
+        c_inline_program(program, inline_threshold);
+    }
+
+    c_fold_program(program, error_context, source_path);
+    c_error_context_print(error_context, stderr);
+
+    if (emit == C_EMIT_INTERPRET) {
+        c_bytecode_module *module = c_bytecode_compile(program);
+        c_interpreter_status status =
+            c_interpreter_run(module, C_INTERPRETER_ENTRY, &exit_code);
+
+        if (status != C_INTERPRETER_OK) {
+            fprintf(stderr, "Interpreter: %s\n",
+                    c_interpreter_status_to_string(status));
+            exit_code = EXIT_FAILURE;
+        }
+
+        c_bytecode_module_free(module);
+        c_lexer_free(lexer);
         c_parser_free_program(program);
+        c_error_context_free(error_context);
         c_parser_free(parser);
-        EXIT_WITH_ERROR("Failed to open file for writing\n");
+        free(source);
+        return exit_code;
     }
 
-    char **asm_lines = c_code_gen_emit(program);
+    if (peephole_stats) {
+        options.peephole_fires = calloc(c_peephole_rules_count(), sizeof(int));
+    }
+
+    c_mir_module *machine = c_code_gen_select_program(program, options);
 
-    for (int i = 0; i < arrlen(asm_lines); i++) {
-        fprintf(file, "%s\n", asm_lines[i]);
+    if (peephole_stats) {
+        for (int i = 0; i < c_peephole_rules_count(); i++) {
+            fprintf(stderr,
+                    "peephole: %s fired %d times\n",
+                    c_peephole_rule_at(i)->name,
+                    options.peephole_fires[i]);
+        }
+
+        free(options.peephole_fires);
     }
-    fclose(file);
 
-    system("nasm -f elf64 c.asm -o c.o");
-    system("ld c.o -o c");
+    if (emit == C_EMIT_ASM) {
+        char **asm_lines = NULL;
+        c_mir_print_module(machine, &asm_lines);
+        write_lines("c.asm", asm_lines);
 
-    for (int i = 0; i < arrlen(asm_lines); i++) {
-        free(asm_lines[i]);
+        for (int i = 0; i < arrlen(asm_lines); i++) {
+            free(asm_lines[i]);
+        }
+        arrfree(asm_lines);
+    } else {
+        c_asm_object *object = c_asm_assemble_module(machine);
+
+        if (emit == C_EMIT_RUN) {
+            exit_code = c_jit_run(object, C_JIT_ENTRY);
+        } else if (emit == C_EMIT_OBJECT) {
+            uint8_t *bytes = c_elf64_write_relocatable(object);
+            write_bytes("c.o", bytes, 0);
+            arrfree(bytes);
+        } else {
+            uint8_t *bytes = c_link_executable(object);
+            write_bytes("c", bytes, 1);
+            arrfree(bytes);
+        }
+
+        c_asm_object_free(object);
     }
-    arrfree(asm_lines);
+
+    c_mir_module_free(machine);
     c_lexer_free(lexer);
     c_parser_free_program(program);
     c_error_context_free(error_context);
     c_parser_free(parser);
     free(source);
-    return 0;
+    return exit_code;
 }
@@ -0,0 +1,37 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include <stdint.h>
+#include "machine_ir.h"
+
+typedef struct {
+    char *name;
+    // NOTE: offset into text, only meaningful when defined
+    int64_t offset;
+    int is_defined;
+    int is_global;
+} c_asm_symbol;
+
+// NOTE: rel32 field at offset that points at symbol + addend,
+// only calls to symbols defined elsewhere are relocated
+typedef struct {
+    int64_t offset;
+    int symbol;
+    int64_t addend;
+} c_asm_relocation;
+
+typedef struct {
+    uint8_t *text;
+    c_asm_symbol *symbols;
+    c_asm_relocation *relocations;
+} c_asm_object;
+
+// NOTE: assembles the nasm syntax subset the code generator emits
+c_asm_object *c_asm_assemble(char **lines);
+// NOTE: encodes the instructions as they are, without printing them
+c_asm_object *c_asm_assemble_module(c_mir_module *module);
+void c_asm_object_free(c_asm_object *object);
+
+int c_asm_find_symbol(c_asm_object *object, const char *name);
+
+#endif  // !ASSEMBLER_H
@@ -0,0 +1,33 @@
+#ifndef CALL_REWRITE_H
+#define CALL_REWRITE_H
+
+#include "parser.h"
+
+// NOTE: 1 and the value every call to name returns, when known
+typedef int (*c_call_value_for_call)(void *context,
+                                     const char *name,
+                                     int *value);
+// NOTE: takes the call its value replaced
+typedef void (*c_call_replaced)(void *context, c_ast_expression *call);
+// NOTE: runs once the statement at index is rewritten, returns
+// how many statements it inserted before it
+typedef int (*c_call_rewritten)(void *context, c_ast_block *block, int index);
+
+typedef struct {
+    void *context;
+    c_call_value_for_call value_for_call;
+    c_call_replaced replaced;
+    // NOTE: may be NULL
+    c_call_rewritten rewritten;
+    // NOTE: leaves a call that is a statement of its own, its
+    // result is discarded anyway
+    int keep_call_statements;
+} c_call_rewriter;
+
+// NOTE: index into the program functions, -1 when defined elsewhere
+int c_call_find_function(c_ast_program *program, const char *name);
+
+// NOTE: replaces calls in block with their value, in evaluation order
+void c_call_rewrite_block(c_call_rewriter *rewriter, c_ast_block *block);
+
+#endif  // !CALL_REWRITE_H
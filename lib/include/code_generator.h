@@ -1,27 +1,90 @@
 #ifndef CODE_GENERATOR
 #define CODE_GENERATOR
 
+#include <stdint.h>
+#include "frame.h"
+#include "instruction_selection.h"
+#include "ir.h"
+#include "machine_ir.h"
 #include "parser.h"
+#include "range_analysis.h"
+#include "scheduler.h"
+#include "register_allocator.h"
 
-// TODO: fix naming conflicts
-// (maybe should not name variabls
-// rather just identify them by
-// memory pos)
+typedef struct {
+    // NOTE: 0 keeps every local in memory,
+    // 1 and above promotes locals to ssa values
+    int optimization_level;
+    // NOTE: address slots from rsp and keep leaf
+    // function locals in the red zone, default from -O2
+    int omit_frame_pointer;
+    // NOTE: a call that is only returned becomes a jmp
+    // after the epilogue, default from -O1
+    int tail_calls;
+    // NOTE: functions optimized and emitted at once, the
+    // output does not depend on it, 1 stays on one thread
+    int jobs;
+    // NOTE: reorders the instructions of each block for the
+    // latencies of tune, default from -O2
+    int schedule;
+    const c_schedule_model *tune;
+    // NOTE: optional, one counter per peephole rule
+    int *peephole_fires;
+} c_code_gen_options;
+
+typedef struct {
+    c_ir_function *function;
+    c_mir_function *machine;
+    int *use_counts;
+    c_register_allocation *allocation;
+    c_frame_layout *frame;
+    c_isel_selection *selection;
+    // NOTE: indexed by value id, NULL below -O1
+    c_range *ranges;
+    c_code_gen_options options;
+    // NOTE: set by a tail call for the return that follows it
+    const char *tail_callee;
+    // NOTE: with several returns each jumps to one epilogue
+    // emitted after the last block
+    int has_shared_epilogue;
+} c_code_gen_context;
+
+c_code_gen_options c_code_gen_default_options(void);
+c_code_gen_options c_code_gen_options_for_level(int optimization_level);
 
 char **c_code_gen_emit(c_ast_program *program);
-char **c_code_gen_emit_function_declaration(
-    c_ast_function_declaration *function_declaration);
-char **c_code_gen_emit_function_call(c_ast_function_call *function_call,
-                                     const char *assign_to_variable);
-// TODO: maybe add some context structure
-char **c_code_gen_emit_statement(c_ast_statement *statement,
-                                 int *current_offset);
-char **c_code_gen_emit_block(c_ast_block *block, int *current_offset);
-char **c_code_gen_emit_return(c_ast_return *ret, int *current_offset);
-char **c_code_gen_emit_binary_expression(c_ast_binary_expression *binary,
-                                         int *current_offset);
-char **c_code_gen_emit_expression(c_ast_expression *expression,
-                                  int *current_offset);
-char **c_code_gen_emit_variable(c_ast_variable *variable);
+char **c_code_gen_emit_with_options(c_ast_program *program,
+                                    c_code_gen_options options);
+// NOTE: _start and every function, the emitters above print it
+c_mir_module *c_code_gen_select_program(c_ast_program *program,
+                                        c_code_gen_options options);
+c_mir_module *c_code_gen_select_module(c_ir_module *module,
+                                       c_code_gen_options options);
+// NOTE: machine code of the function, printed only by the emitters
+c_mir_function *c_code_gen_select_function(c_ir_function *function,
+                                           c_code_gen_options options);
+char **c_code_gen_emit_function(c_ir_function *function,
+                                c_code_gen_options options);
+void c_code_gen_emit_instruction(c_code_gen_context *context, int value);
+void c_code_gen_emit_binary(c_code_gen_context *context, int value);
+void c_code_gen_emit_multiply_by_constant(c_code_gen_context *context,
+                                          c_mir_operand work,
+                                          c_mir_operand factor,
+                                          int constant);
+// NOTE: leaves n / divisor, or n % divisor when remainder is set, in work.
+// is_non_negative tells a signed dividend is known to be at least 0
+void c_code_gen_emit_division_by_constant(c_code_gen_context *context,
+                                          c_mir_operand work,
+                                          c_mir_operand dividend,
+                                          int64_t divisor,
+                                          int is_unsigned,
+                                          int is_non_negative,
+                                          int remainder);
+void c_code_gen_emit_phi_copies(c_code_gen_context *context,
+                                int from_block,
+                                int to_block);
+
+void c_code_gen_optimize_function(c_ir_function *function,
+                                  c_code_gen_options options);
 
 #endif  // !CODE_GENERATOR
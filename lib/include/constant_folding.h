@@ -0,0 +1,27 @@
+#ifndef CONSTANT_FOLDING_H
+#define CONSTANT_FOLDING_H
+
+#include "error.h"
+#include "parser.h"
+
+typedef struct {
+    c_error_context *error_context;
+    const char *filename;
+    // NOTE: number of binary expressions removed
+    int folded;
+} c_fold_context;
+
+// NOTE: arithmetic follows C int semantics, so + - * wrap
+// modulo 2^32 and / truncates toward zero
+int c_fold_program(c_ast_program *program,
+                   c_error_context *error_context,
+                   const char *filename);
+void c_fold_block(c_fold_context *context, c_ast_block *block);
+c_ast_expression *c_fold_expression(c_fold_context *context,
+                                    c_ast_expression *expression);
+
+int c_fold_evaluate(char symbol, int lhs, int rhs, int *result);
+int c_fold_is_pure(c_ast_expression *expression);
+int c_fold_expressions_equal(c_ast_expression *a, c_ast_expression *b);
+
+#endif  // !CONSTANT_FOLDING_H
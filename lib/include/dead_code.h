@@ -0,0 +1,16 @@
+#ifndef DEAD_CODE_H
+#define DEAD_CODE_H
+
+#include "ir.h"
+
+// NOTE: backward liveness of every alloca across the blocks, a store
+// no load can read before the next store or the return is removed.
+// Callees can not see the locals of their caller. Returns the count
+int c_dead_store_eliminate(c_ir_function *function);
+
+// NOTE: calls, stores and terminators are live, so are the values
+// and allocas they read. Everything else is removed, including
+// unused arithmetic, loads, phis and allocas. Returns the count
+int c_dead_code_eliminate(c_ir_function *function);
+
+#endif  // !DEAD_CODE_H
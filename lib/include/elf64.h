@@ -0,0 +1,53 @@
+#ifndef ELF64_H
+#define ELF64_H
+
+#include <stdint.h>
+#include "assembler.h"
+
+#define C_ELF64_HEADER_SIZE 64
+#define C_ELF64_SECTION_HEADER_SIZE 64
+#define C_ELF64_SYMBOL_SIZE 24
+#define C_ELF64_RELA_SIZE 24
+#define C_ELF64_PROGRAM_HEADER_SIZE 56
+
+#define C_ELF64_ET_REL 1
+#define C_ELF64_ET_EXEC 2
+#define C_ELF64_EM_X86_64 62
+
+#define C_ELF64_SHT_PROGBITS 1
+#define C_ELF64_SHT_SYMTAB 2
+#define C_ELF64_SHT_STRTAB 3
+#define C_ELF64_SHT_RELA 4
+
+#define C_ELF64_SHF_ALLOC 0x2
+#define C_ELF64_SHF_EXECINSTR 0x4
+#define C_ELF64_SHF_INFO_LINK 0x40
+
+#define C_ELF64_STB_LOCAL 0
+#define C_ELF64_STB_GLOBAL 1
+#define C_ELF64_STT_NOTYPE 0
+#define C_ELF64_STT_SECTION 3
+
+#define C_ELF64_R_X86_64_PLT32 4
+
+#define C_ELF64_PT_LOAD 1
+#define C_ELF64_PF_X 0x1
+#define C_ELF64_PF_R 0x4
+
+// NOTE: ET_REL with .text, .symtab, .strtab, .rela.text and
+// .shstrtab, returns the file contents as an stb array
+uint8_t *c_elf64_write_relocatable(c_asm_object *object);
+
+// NOTE: ET_EXEC with a single read and execute PT_LOAD segment mapping
+// the whole file at base, text starts at c_elf64_executable_text_offset
+uint8_t *c_elf64_write_executable(uint8_t *text, uint64_t base, uint64_t entry);
+uint64_t c_elf64_executable_text_offset(void);
+
+void c_elf64_put16(uint8_t **bytes, uint16_t value);
+void c_elf64_put32(uint8_t **bytes, uint32_t value);
+void c_elf64_put64(uint8_t **bytes, uint64_t value);
+// NOTE: appends a nul terminated string, returns its offset
+uint32_t c_elf64_add_string(uint8_t **table, const char *string);
+void c_elf64_align(uint8_t **bytes, int alignment);
+
+#endif  // !ELF64_H
@@ -4,7 +4,13 @@
 #include <stdio.h>
 #include "lexer.h"
 
+typedef enum {
+    C_SEVERITY_ERROR,
+    C_SEVERITY_WARNING,
+} c_error_severity;
+
 typedef struct {
+    c_error_severity severity;
     const char *message;
     const char *filename;
     int line;
@@ -30,6 +36,13 @@ void c_error_report_with_token(c_error_context *ctx,
                                c_token token,
                                const char *filename);
 
+// NOTE: warnings are printed but do not stop compilation
+void c_warning_report(c_error_context *ctx,
+                      const char *message,
+                      const char *filename,
+                      int line,
+                      int column);
+
 void c_error_context_print(c_error_context *ctx, FILE *output);
 
 int c_error_context_has_errors(c_error_context *ctx);
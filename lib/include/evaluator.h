@@ -0,0 +1,55 @@
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+#include "parser.h"
+
+// NOTE: expressions and statements visited for one call site,
+// functions still unknown after that keep their calls
+#define C_EVAL_MAX_STEPS 1000000
+// NOTE: locals alive at once and nested calls being evaluated
+#define C_EVAL_MAX_LOCALS 4096
+#define C_EVAL_MAX_DEPTH 256
+
+typedef enum {
+    C_EVAL_UNKNOWN,
+    // NOTE: a call back into it never returns, there are no parameters
+    C_EVAL_RUNNING,
+    C_EVAL_CONSTANT,
+    // NOTE: traps, recursion, undefined callees or a limit hit
+    C_EVAL_FAILED,
+} c_eval_state;
+
+typedef struct {
+    c_ast_function_declaration *declaration;
+    c_eval_state state;
+    int value;
+} c_eval_function;
+
+typedef struct {
+    char *name;
+    int value;
+} c_eval_local;
+
+typedef struct {
+    c_ast_program *program;
+    // NOTE: one per program function, in the same order
+    c_eval_function *functions;
+    c_eval_local *locals;
+    int steps;
+    int depth;
+    // NOTE: number of calls replaced
+    int replaced;
+} c_eval_context;
+
+// NOTE: functions take no arguments, one that returns without
+// trapping always returns the same value. Calls to those become
+// that value, runs before inlining and folding
+int c_eval_program(c_ast_program *program);
+
+// NOTE: 1 and the result when name returns within the limits,
+// a call from outside any evaluation starts a new step budget
+int c_eval_function_value(c_eval_context *context,
+                          const char *name,
+                          int *value);
+
+#endif  // !EVALUATOR_H
@@ -0,0 +1,48 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include "ir.h"
+#include "register_allocator.h"
+
+#define C_FRAME_STACK_ALIGNMENT 16
+#define C_FRAME_PUSH_SIZE 8
+#define C_FRAME_RED_ZONE_SIZE 128
+
+typedef struct {
+    int value;
+    int size;
+    int alignment;
+    // NOTE: the slot lives at [rbp-offset]
+    int offset;
+} c_frame_slot;
+
+// NOTE: rbp is 16 byte aligned after the prologue, below it sit the
+// pushed callee saved registers and then every slot of the function.
+// Without a frame pointer the same layout is addressed from rsp
+typedef struct {
+    c_frame_slot *slots;
+    // NOTE: indexed by value id, -1 when the value has no slot
+    int *slot_of;
+    int saved_size;
+    int locals_size;
+    // NOTE: the single sub rsp of the prologue
+    int allocation_size;
+    int has_calls;
+    int omit_frame_pointer;
+    // NOTE: leaf function without frame pointer whose slots
+    // fit below rsp, rsp is never adjusted
+    int uses_red_zone;
+} c_frame_layout;
+
+c_frame_layout *c_frame_layout_create(c_ir_function *function,
+                                      c_register_allocation *allocation,
+                                      int omit_frame_pointer,
+                                      int tail_calls);
+void c_frame_layout_free(c_frame_layout *frame);
+
+c_frame_slot *c_frame_slot_of(c_frame_layout *frame, int value);
+c_x86_register c_frame_base_register(c_frame_layout *frame);
+// NOTE: the slot lives at [base + displacement]
+int c_frame_displacement(c_frame_layout *frame, c_frame_slot *slot);
+
+#endif  // !FRAME_H
@@ -0,0 +1,44 @@
+#ifndef INLINER_H
+#define INLINER_H
+
+#include "parser.h"
+
+#define C_INLINE_DEFAULT_THRESHOLD 16
+// NOTE: a call, its frame and the return, saved at every inlined site
+#define C_INLINE_CALL_BENEFIT 4
+// NOTE: summaries are only built to be compared with the threshold,
+// larger ones are never worth inlining
+#define C_INLINE_MAX_SUMMARY_SIZE 256
+
+typedef struct {
+    c_ast_function_declaration *declaration;
+    // NOTE: indices into the program functions, one per call site
+    int *callees;
+    int is_recursive;
+    int is_visited;
+    // NOTE: the body reduced to the returned expression, with
+    // locals substituted, NULL when it can not be inlined
+    c_ast_expression *summary;
+    int cost;
+} c_inline_function;
+
+typedef struct {
+    c_ast_program *program;
+    c_inline_function *functions;
+    int threshold;
+    // NOTE: number of call sites replaced
+    int inlined;
+} c_inline_context;
+
+// NOTE: runs before folding, so constants returned by small
+// callees fold into their callers
+int c_inline_program(c_ast_program *program, int threshold);
+
+c_ast_expression *c_inline_summarize(c_ast_function_declaration *declaration);
+// NOTE: size minus the benefit of removing the call, a summary
+// without variables or calls folds to a single constant
+int c_inline_cost(c_ast_expression *summary);
+int c_inline_expression_size(c_ast_expression *expression);
+c_ast_expression *c_inline_copy_expression(c_ast_expression *expression);
+
+#endif  // !INLINER_H
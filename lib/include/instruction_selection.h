@@ -0,0 +1,54 @@
+#ifndef INSTRUCTION_SELECTION_H
+#define INSTRUCTION_SELECTION_H
+
+#include "ir.h"
+#include "register_allocator.h"
+
+// NOTE: rough latencies, only ever compared with each other
+typedef enum {
+    C_ISEL_MOVE,
+    C_ISEL_ALU,
+    C_ISEL_SHIFT,
+    C_ISEL_IMUL,
+    C_ISEL_LEA,
+    // NOTE: base, index and displacement all present
+    C_ISEL_LEA_COMPLEX,
+    C_ISEL_KINDS_COUNT,
+} c_isel_kind;
+
+typedef enum {
+    // NOTE: the default two address code of the instruction
+    C_ISEL_EMIT,
+    // NOTE: computed inside its only user, emits nothing itself.
+    // A folded load becomes a memory operand of the user
+    C_ISEL_FOLDED,
+    // NOTE: an add tree computed by one lea
+    C_ISEL_ADDRESS,
+} c_isel_form;
+
+// NOTE: [base + index * scale + displacement], base and
+// index are values in registers or C_IR_NO_VALUE
+typedef struct {
+    int base;
+    int index;
+    int scale;
+    int displacement;
+} c_isel_address;
+
+typedef struct {
+    // NOTE: both indexed by value id
+    c_isel_form *forms;
+    c_isel_address *addresses;
+} c_isel_selection;
+
+int c_isel_cost(c_isel_kind kind);
+
+// NOTE: patterns only cover operands computed right before their
+// user, so no register changes between the two and the operands
+// still hold their values when the user reads them
+c_isel_selection *c_isel_select(c_ir_function *function,
+                                int *use_counts,
+                                c_register_allocation *allocation);
+void c_isel_selection_free(c_isel_selection *selection);
+
+#endif  // !INSTRUCTION_SELECTION_H
@@ -0,0 +1,66 @@
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include <stdint.h>
+#include "ir.h"
+#include "parser.h"
+
+#define C_INTERPRETER_ENTRY "main"
+// NOTE: deep enough for any program the native stack runs
+#define C_INTERPRETER_MAX_FRAMES 100000
+
+// NOTE: operands follow the opcode in the code stream,
+// r is a register of the current frame, k an immediate
+typedef enum {
+    // r, k
+    C_BYTECODE_CONSTANT,
+    // r, r
+    C_BYTECODE_MOVE,
+    // r, r, r
+    C_BYTECODE_ADD,
+    C_BYTECODE_SUBTRACT,
+    C_BYTECODE_MULTIPLY,
+    C_BYTECODE_DIVIDE,
+    // r, function
+    C_BYTECODE_CALL,
+    // target
+    C_BYTECODE_JUMP,
+    // r, target, taken when r is zero
+    C_BYTECODE_BRANCH_ZERO,
+    // r
+    C_BYTECODE_RETURN,
+    C_BYTECODE_RETURN_ZERO,
+    C_BYTECODE_OPCODES_COUNT,
+} c_bytecode_opcode;
+
+typedef struct {
+    char *name;
+    int32_t *code;
+    int registers_count;
+} c_bytecode_function;
+
+typedef struct {
+    c_bytecode_function *functions;
+} c_bytecode_module;
+
+typedef enum {
+    C_INTERPRETER_OK,
+    // NOTE: division by zero or INT_MIN / -1, both trap natively
+    C_INTERPRETER_ARITHMETIC_ERROR,
+    C_INTERPRETER_STACK_OVERFLOW,
+    C_INTERPRETER_UNDEFINED_ENTRY,
+} c_interpreter_status;
+
+c_bytecode_module *c_bytecode_compile(c_ast_program *program);
+c_bytecode_module *c_bytecode_compile_module(c_ir_module *module);
+int c_bytecode_find_function(c_bytecode_module *module, const char *name);
+void c_bytecode_module_free(c_bytecode_module *module);
+
+// NOTE: int arithmetic wraps at 32 bits like the native code,
+// result is only written when the status is C_INTERPRETER_OK
+c_interpreter_status c_interpreter_run(c_bytecode_module *module,
+                                       const char *entry,
+                                       int *result);
+const char *c_interpreter_status_to_string(c_interpreter_status status);
+
+#endif  // !INTERPRETER_H
@@ -0,0 +1,53 @@
+#ifndef INTERPROCEDURAL_H
+#define INTERPROCEDURAL_H
+
+#include "parser.h"
+
+// NOTE: nested callees analyzed at once, deeper ones stay varying
+#define C_IPA_MAX_DEPTH 256
+
+typedef enum {
+    C_IPA_UNKNOWN,
+    C_IPA_RUNNING,
+    // NOTE: the first return only reads constants, constant
+    // locals and constant returning calls
+    C_IPA_CONSTANT,
+    C_IPA_VARYING,
+} c_ipa_state;
+
+typedef struct {
+    c_ast_function_declaration *declaration;
+    c_ipa_state state;
+    int value;
+} c_ipa_function;
+
+typedef struct {
+    char *name;
+    int is_constant;
+    int value;
+} c_ipa_local;
+
+typedef struct {
+    c_ast_program *program;
+    // NOTE: one per program function, in the same order
+    c_ipa_function *functions;
+    c_ipa_local *locals;
+    // NOTE: calls replaced in the statement being rewritten,
+    // in evaluation order
+    c_ast_expression **hoisted;
+    int depth;
+    // NOTE: number of call results replaced
+    int replaced;
+} c_ipa_context;
+
+// NOTE: a callee whose return value is known but which may still
+// call out or trap keeps its call, moved to a statement of its own
+// before the one that used the result. Operands of one expression
+// are unordered, so the call may run earlier than its siblings.
+// Functions have no parameters yet, so only returns propagate
+int c_ipa_propagate_program(c_ast_program *program);
+
+// NOTE: 1 and the value every call to name returns, when known
+int c_ipa_return_value(c_ipa_context *context, const char *name, int *value);
+
+#endif  // !INTERPROCEDURAL_H
@@ -0,0 +1,132 @@
+#ifndef IR_H
+#define IR_H
+
+#include "parser.h"
+
+// NOTE: value ids and block ids are plain indices into the
+// function arrays, so they stay valid when stb arrays grow
+#define C_IR_NO_VALUE (-1)
+
+typedef enum {
+    C_IR_CONSTANT,
+    C_IR_ALLOCA,
+    C_IR_LOAD,
+    C_IR_STORE,
+    C_IR_ADD,
+    C_IR_SUBTRACT,
+    C_IR_MULTIPLY,
+    C_IR_DIVIDE,
+    C_IR_CALL,
+    C_IR_PHI,
+    C_IR_JUMP,
+    C_IR_BRANCH,
+    C_IR_RETURN,
+    // NOTE: removed instructions keep their id
+    C_IR_NOP,
+} c_ir_opcode;
+
+// NOTE: every source level int is C_IR_TYPE_I32, the backend
+// picks register and memory widths from the type
+typedef enum {
+    C_IR_TYPE_I32,
+    C_IR_TYPE_I64,
+} c_ir_type;
+
+typedef struct {
+    int block;
+    int value;
+} c_ir_phi_operand;
+
+typedef struct {
+    c_ir_opcode opcode;
+    // NOTE: for allocas the type of the slot
+    c_ir_type type;
+    int block;
+
+    // load: {alloca}, store: {alloca, value},
+    // binary: {lhs, rhs}, branch: {condition}, return: {value}
+    int operands[2];
+    // jump: {target}, branch: {then, else}
+    int targets[2];
+
+    int constant;
+    char *function_name;
+    char *variable_name;
+    c_ir_phi_operand *phi_operands;
+} c_ir_instruction;
+
+typedef struct {
+    int *instructions;
+    int *predecessors;
+    int *successors;
+
+    int immediate_dominator;
+    int *dominator_children;
+    int *dominance_frontier;
+} c_ir_block;
+
+typedef struct {
+    char *name;
+    c_ir_instruction *instructions;
+    c_ir_block *blocks;
+} c_ir_function;
+
+typedef struct {
+    c_ir_function **functions;
+} c_ir_module;
+
+c_ir_module *c_ir_lower_program(c_ast_program *program);
+// NOTE: appends the function and then the ones declared in its body
+void c_ir_lower_function_declaration(
+    c_ir_module *module,
+    c_ast_function_declaration *function_declaration);
+int c_ir_expression_register_need(c_ast_expression *expression);
+
+c_ir_function *c_ir_function_create(const char *name);
+int c_ir_function_add_block(c_ir_function *function);
+int c_ir_function_append(c_ir_function *function,
+                         int block,
+                         c_ir_instruction instruction);
+int c_ir_function_insert(c_ir_function *function,
+                         int block,
+                         int position,
+                         c_ir_instruction instruction);
+void c_ir_function_remove(c_ir_function *function, int value);
+void c_ir_function_compute_cfg(c_ir_function *function);
+// NOTE: blocks keep their ids, a block that the entry can not
+// reach is left empty. Returns the number of removed instructions
+int c_ir_function_remove_unreachable(c_ir_function *function);
+
+int c_ir_module_find_function(c_ir_module *module, const char *name);
+// NOTE: keeps the functions reachable through calls from entry,
+// a module without entry is left as is. Returns the number removed
+int c_ir_module_remove_dead_functions(c_ir_module *module, const char *entry);
+
+c_ir_instruction c_ir_make(c_ir_opcode opcode, int lhs, int rhs);
+c_ir_instruction c_ir_make_constant(int value);
+c_ir_instruction c_ir_make_call(const char *function_name);
+c_ir_instruction c_ir_make_jump(int target);
+c_ir_instruction c_ir_make_branch(int condition, int then_block,
+                                  int else_block);
+
+// NOTE: size in bytes
+int c_ir_type_size(c_ir_type type);
+int c_ir_is_terminator(c_ir_opcode opcode);
+int c_ir_is_binary(c_ir_opcode opcode);
+int c_ir_block_terminator(c_ir_function *function, int block);
+// NOTE: collects operands that are values (not allocas),
+// phi operands are not included
+int c_ir_value_operands(c_ir_instruction *instruction, int operands[2]);
+int *c_ir_use_counts(c_ir_function *function);
+// NOTE: calls take no arguments, so a call whose result is only
+// returned can reuse the frame of its caller. Anything between it
+// and the return must be unused and free of side effects
+int c_ir_is_tail_call(c_ir_function *function, int value, int *use_counts);
+
+char **c_ir_print_function(c_ir_function *function);
+const char *c_ir_opcode_to_string(c_ir_opcode opcode);
+
+void c_ir_function_free(c_ir_function *function);
+void c_ir_module_free(c_ir_module *module);
+
+#endif  // !IR_H
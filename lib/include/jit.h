@@ -0,0 +1,12 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "assembler.h"
+
+#define C_JIT_ENTRY "main"
+
+// NOTE: maps the object text, calls entry in this process and returns
+// its result. The mapping is never writable and executable at once
+int c_jit_run(c_asm_object *object, const char *entry);
+
+#endif  // !JIT_H
@@ -0,0 +1,14 @@
+#ifndef LINKER_H
+#define LINKER_H
+
+#include <stdint.h>
+#include "assembler.h"
+
+#define C_LINK_BASE_ADDRESS 0x400000
+#define C_LINK_ENTRY "_start"
+
+// NOTE: static ET_EXEC image of a single object, every relocation must
+// resolve inside it. Returns the file contents as an stb array
+uint8_t *c_link_executable(c_asm_object *object);
+
+#endif  // !LINKER_H
@@ -0,0 +1,140 @@
+#ifndef MACHINE_IR_H
+#define MACHINE_IR_H
+
+#include <stdint.h>
+#include "x86.h"
+
+#define C_MIR_MAX_OPERANDS 3
+#define C_MIR_NO_LABEL -1
+#define C_MIR_MAX_OPERAND_LENGTH 64
+
+typedef enum {
+    C_MIR_MOV,
+    C_MIR_LEA,
+    C_MIR_ADD,
+    C_MIR_SUB,
+    C_MIR_IMUL,
+    C_MIR_AND,
+    C_MIR_XOR,
+    C_MIR_NEG,
+    C_MIR_SHL,
+    C_MIR_SHR,
+    C_MIR_SAR,
+    C_MIR_CMP,
+    C_MIR_TEST,
+    // NOTE: one operand forms, rdx:rax = rax * operand
+    C_MIR_MUL,
+    C_MIR_DIV,
+    C_MIR_IDIV,
+    C_MIR_CDQ,
+    C_MIR_CQO,
+    C_MIR_PUSH,
+    C_MIR_POP,
+    C_MIR_CALL,
+    C_MIR_JMP,
+    C_MIR_JZ,
+    C_MIR_JNZ,
+    C_MIR_RET,
+    C_MIR_SYSCALL,
+    C_MIR_OPCODES_COUNT,
+} c_mir_opcode;
+
+typedef enum {
+    C_MIR_NONE,
+    C_MIR_REGISTER,
+    C_MIR_IMMEDIATE,
+    C_MIR_MEMORY,
+    C_MIR_LABEL,
+} c_mir_operand_kind;
+
+typedef struct {
+    c_x86_register base;
+    c_x86_register index;
+    int scale;
+    int displacement;
+} c_mir_address;
+
+typedef struct {
+    c_mir_operand_kind kind;
+    // NOTE: bytes accessed, 4 or 8. 0 for immediates, labels and
+    // the address computed by lea
+    int size;
+    union {
+        c_x86_register reg;
+        int64_t immediate;
+        c_mir_address memory;
+        // NOTE: index into the labels of the function
+        int label;
+    };
+} c_mir_operand;
+
+typedef struct {
+    c_mir_opcode opcode;
+    int operands_count;
+    c_mir_operand operands[C_MIR_MAX_OPERANDS];
+} c_mir_instruction;
+
+// NOTE: blocks without a label are only separated
+// from the previous one, the epilogue starts one
+typedef struct {
+    int label;
+    c_mir_instruction *instructions;
+} c_mir_block;
+
+typedef struct {
+    // NOTE: block labels and call or jump targets outside the
+    // function, labels[0] is the function itself
+    char **labels;
+    c_mir_block *blocks;
+} c_mir_function;
+
+typedef struct {
+    // NOTE: symbols the object exports
+    char **globals;
+    c_mir_function **functions;
+} c_mir_module;
+
+c_mir_function *c_mir_function_create(const char *name);
+void c_mir_function_free(c_mir_function *function);
+void c_mir_module_free(c_mir_module *module);
+
+// NOTE: the same name always gives the same label
+int c_mir_label(c_mir_function *function, const char *format, ...);
+void c_mir_begin_block(c_mir_function *function, int label);
+void c_mir_append(c_mir_function *function, c_mir_instruction instruction);
+
+c_mir_operand c_mir_register(c_x86_register reg, int size);
+c_mir_operand c_mir_immediate(int64_t value);
+c_mir_operand c_mir_memory(c_x86_register base,
+                           c_x86_register index,
+                           int scale,
+                           int displacement,
+                           int size);
+c_mir_operand c_mir_label_operand(int label);
+
+c_mir_instruction c_mir_make0(c_mir_opcode opcode);
+c_mir_instruction c_mir_make1(c_mir_opcode opcode, c_mir_operand operand);
+c_mir_instruction c_mir_make2(c_mir_opcode opcode,
+                              c_mir_operand destination,
+                              c_mir_operand source);
+c_mir_instruction c_mir_make3(c_mir_opcode opcode,
+                              c_mir_operand destination,
+                              c_mir_operand source,
+                              c_mir_operand immediate);
+
+int c_mir_operand_equal(c_mir_operand a, c_mir_operand b);
+int c_mir_is_register(c_mir_operand operand);
+int c_mir_is_memory(c_mir_operand operand);
+
+const char *c_mir_opcode_to_string(c_mir_opcode opcode);
+// NOTE: buffer holds at least C_MIR_MAX_OPERAND_LENGTH bytes
+const char *c_mir_print_operand(c_mir_function *function,
+                                c_mir_operand operand,
+                                char *buffer);
+char *c_mir_print_instruction(c_mir_function *function,
+                              c_mir_instruction *instruction);
+// NOTE: nasm syntax, appended to lines and ending in a blank line
+void c_mir_print_function(c_mir_function *function, char ***lines);
+void c_mir_print_module(c_mir_module *module, char ***lines);
+
+#endif  // !MACHINE_IR_H
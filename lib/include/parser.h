@@ -33,6 +33,9 @@ typedef struct {
     char symbol;
     c_ast_expression *lhs;
     c_ast_expression *rhs;
+    // NOTE: position of the operator, for diagnostics
+    int line;
+    int column;
 } c_ast_binary_expression;
 
 typedef struct c_ast_expression {
@@ -101,6 +104,9 @@ typedef struct {
     c_token current_token;
     size_t current_position;
     size_t read_position;
+    // NOTE: every function declared so far, nested ones included,
+    // they are lowered as functions of their own under the same name
+    char **function_names;
 } c_parser;
 
 c_parser *c_parser_create(c_token *tokens,
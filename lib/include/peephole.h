@@ -0,0 +1,45 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include "machine_ir.h"
+
+#define C_PEEPHOLE_MAX_WINDOW 2
+
+typedef enum {
+    C_PEEPHOLE_INSTRUCTION,
+    C_PEEPHOLE_LABEL,
+    // NOTE: start of a block without a label, windows skip it
+    C_PEEPHOLE_SEPARATOR,
+} c_peephole_entry_kind;
+
+// NOTE: the blocks of a function flattened in order, so patterns
+// can reach over the label that starts the next block
+typedef struct {
+    c_peephole_entry_kind kind;
+    // NOTE: index into the function labels, for labels only
+    int label;
+    c_mir_instruction instruction;
+} c_peephole_entry;
+
+typedef struct {
+    c_mir_function *function;
+    c_peephole_entry *entries;
+} c_peephole_stream;
+
+// NOTE: window holds the entry indices of the next `window` entries
+// that are not separators, a rewrite returns 1 when it changed the stream
+typedef int (*c_peephole_rewrite)(c_peephole_stream *stream, int *window);
+
+typedef struct {
+    const char *name;
+    int window;
+    c_peephole_rewrite rewrite;
+} c_peephole_rule;
+
+int c_peephole_rules_count(void);
+const c_peephole_rule *c_peephole_rule_at(int index);
+
+// NOTE: fires, when not NULL, has one counter per rule
+int c_peephole_optimize_function(c_mir_function *function, int *fires);
+
+#endif  // !PEEPHOLE_H
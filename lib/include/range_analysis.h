@@ -0,0 +1,38 @@
+#ifndef RANGE_ANALYSIS_H
+#define RANGE_ANALYSIS_H
+
+#include <stdint.h>
+#include "ir.h"
+
+// NOTE: a phi whose range still grows after this many
+// visits is widened to its whole type
+#define C_RANGE_MAX_VISITS 4
+
+// NOTE: inclusive bounds of the value read as a signed integer
+// of its type, min > max for a value not reached yet
+typedef struct {
+    int64_t min;
+    int64_t max;
+} c_range;
+
+c_range c_range_full(c_ir_type type);
+c_range c_range_constant(int64_t value);
+c_range c_range_union(c_range a, c_range b);
+int c_range_is_empty(c_range range);
+int c_range_is_non_negative(c_range range);
+
+// NOTE: results that could wrap around the type take its whole range
+c_range c_range_of_binary(c_ir_opcode opcode,
+                          c_ir_type type,
+                          c_range lhs,
+                          c_range rhs);
+
+// NOTE: needs SSA form and the cfg. Loads and calls may return any
+// value, everything else follows from constants through arithmetic
+// and phis. Indexed by value id, freed with arrfree
+c_range *c_range_analyze(c_ir_function *function);
+// NOTE: arithmetic with a single possible value becomes that
+// constant, a division that may trap is kept. Returns the count
+int c_range_simplify_function(c_ir_function *function);
+
+#endif  // !RANGE_ANALYSIS_H
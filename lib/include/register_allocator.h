@@ -0,0 +1,38 @@
+#ifndef REGISTER_ALLOCATOR_H
+#define REGISTER_ALLOCATOR_H
+
+#include "ir.h"
+#include "x86.h"
+
+// NOTE: rax, rdx and r11 are never allocated, the emitter
+// needs them for return values, idiv and shuffling spills
+#define C_REGISTER_ALLOCATOR_SCRATCH C_X86_R11
+
+typedef struct {
+    int value;
+    int start;
+    int end;
+    int crosses_call;
+    c_x86_register reg;
+} c_live_interval;
+
+typedef struct {
+    // NOTE: indexed by value id, spilled values get
+    // C_X86_NO_REGISTER and a stack slot from the frame layout
+    c_x86_register *registers;
+    // NOTE: linear position of every instruction
+    int *positions;
+
+    c_live_interval *intervals;
+    c_x86_register *saved_registers;
+    int spilled_count;
+} c_register_allocation;
+
+c_register_allocation *c_register_allocate(c_ir_function *function);
+void c_register_allocation_free(c_register_allocation *allocation);
+
+c_live_interval *c_register_build_intervals(c_ir_function *function,
+                                            int *positions);
+int c_register_needs_location(c_ir_function *function, int value);
+
+#endif  // !REGISTER_ALLOCATOR_H
@@ -0,0 +1,37 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "machine_ir.h"
+
+// NOTE: longer runs are scheduled in pieces to keep the
+// quadratic dependence graph small
+#define C_SCHEDULE_MAX_REGION 256
+
+typedef struct {
+    // NOTE: cycles until the result can be read
+    int latency;
+    // NOTE: cycles the unit stays busy, above 1 only for
+    // the dividers that are not pipelined
+    int occupancy;
+} c_schedule_cost;
+
+typedef struct {
+    const char *name;
+    // NOTE: instructions started in one cycle
+    int issue_width;
+    // NOTE: added to the latency of an instruction reading memory
+    int load_latency;
+    c_schedule_cost costs[C_MIR_OPCODES_COUNT];
+} c_schedule_model;
+
+// NOTE: generic, skylake or znver3, NULL for any other name
+const c_schedule_model *c_schedule_model_for(const char *name);
+
+// NOTE: reorders the instructions between calls, stack and control
+// flow instructions of each block so long latency results are read
+// as late as the dependences allow. Registers, flags and memory keep
+// their order of reads and writes
+void c_schedule_function(c_mir_function *function,
+                         const c_schedule_model *model);
+
+#endif  // !SCHEDULER_H
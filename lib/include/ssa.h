@@ -0,0 +1,19 @@
+#ifndef SSA_H
+#define SSA_H
+
+#include "ir.h"
+
+// NOTE: dominators use the Cooper-Harvey-Kennedy iterative
+// algorithm, phi placement follows Cytron et al.
+void c_ssa_compute_dominators(c_ir_function *function);
+void c_ssa_compute_dominance_frontiers(c_ir_function *function);
+int c_ssa_dominates(c_ir_function *function, int dominator, int block);
+int *c_ssa_reverse_postorder(c_ir_function *function);
+
+// NOTE: one flag per value, set when it is used other than as the
+// address of a load or store, collected in a single pass
+int *c_ssa_escaped_values(c_ir_function *function);
+// NOTE: returns the number of promoted allocas
+int c_ssa_promote_allocas(c_ir_function *function);
+
+#endif  // !SSA_H
@@ -0,0 +1,31 @@
+#ifndef STRENGTH_REDUCTION_H
+#define STRENGTH_REDUCTION_H
+
+#include <stdint.h>
+
+// NOTE: quotient of n / d is derived from the high half of n * multiplier,
+// see Hacker's Delight chapter 10
+typedef struct {
+    // NOTE: bits wide two's complement value, sign extended
+    int64_t multiplier;
+    int shift;
+    // NOTE: unsigned only, the multiplier needed bits + 1 bits
+    int add;
+} c_magic_number;
+
+int c_strength_is_power_of_two(uint64_t value);
+int c_strength_log2(uint64_t value);
+
+// NOTE: divisor must not be 0, 1 or -1, bits is 32 or 64
+c_magic_number c_strength_signed_magic(int64_t divisor, int bits);
+// NOTE: divisor must not be 0 or 1, bits is 32 or 64
+c_magic_number c_strength_unsigned_magic(uint64_t divisor, int bits);
+
+// NOTE: factor == (1 + lea_scale) * 2^shift * (negate ? -1 : 1),
+// lea_scale is 0 when no lea is needed
+int c_strength_decompose_multiply(int64_t factor,
+                                  int *lea_scale,
+                                  int *shift,
+                                  int *negate);
+
+#endif  // !STRENGTH_REDUCTION_H
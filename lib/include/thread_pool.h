@@ -0,0 +1,16 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// NOTE: called once for every index, from whichever worker takes it
+typedef void (*c_thread_pool_task)(void *data, int index);
+
+// NOTE: runs task for every index below tasks_count on up to jobs
+// threads and returns when all of them are done, jobs <= 1 runs
+// everything in order on the calling thread
+void c_thread_pool_run(int jobs,
+                       int tasks_count,
+                       c_thread_pool_task task,
+                       void *data);
+int c_thread_pool_online_cpus(void);
+
+#endif  // !THREAD_POOL_H
@@ -0,0 +1,25 @@
+#ifndef VALUE_NUMBERING_H
+#define VALUE_NUMBERING_H
+
+#include "ir.h"
+
+// NOTE: constant operands compare by value, so two equal
+// constants are the same operand wherever they were emitted
+typedef struct {
+    c_ir_opcode opcode;
+    c_ir_type type;
+    int is_constant[2];
+    // NOTE: value id, or the constant itself when is_constant
+    int operands[2];
+} c_value_key;
+
+// NOTE: ADD and MULTIPLY order their operands first
+c_value_key c_value_key_of(c_ir_function *function, int value);
+int c_value_key_equal(c_value_key *a, c_value_key *b);
+
+// NOTE: walks the dominator tree with a scoped table of pure
+// expressions, a value computed again below its first definition
+// is replaced by it. Needs SSA form, returns the removed count
+int c_value_number_function(c_ir_function *function);
+
+#endif  // !VALUE_NUMBERING_H
@@ -0,0 +1,37 @@
+#ifndef X86_H
+#define X86_H
+
+// NOTE: numbered like the hardware encoding
+typedef enum {
+    C_X86_NO_REGISTER = -1,
+    C_X86_RAX = 0,
+    C_X86_RCX,
+    C_X86_RDX,
+    C_X86_RBX,
+    C_X86_RSP,
+    C_X86_RBP,
+    C_X86_RSI,
+    C_X86_RDI,
+    C_X86_R8,
+    C_X86_R9,
+    C_X86_R10,
+    C_X86_R11,
+    C_X86_R12,
+    C_X86_R13,
+    C_X86_R14,
+    C_X86_R15,
+    C_X86_REGISTERS_COUNT,
+} c_x86_register;
+
+const char *c_x86_register_name(c_x86_register reg);
+const char *c_x86_register_name32(c_x86_register reg);
+// NOTE: size in bytes, 4 or 8
+const char *c_x86_register_name_sized(c_x86_register reg, int size);
+// NOTE: accepts 32 and 64 bit names,
+// C_X86_NO_REGISTER when name is not a register
+c_x86_register c_x86_register_from_name(const char *name);
+// NOTE: size in bytes of the named register, 0 when not a register
+int c_x86_register_size(const char *name);
+int c_x86_is_callee_saved(c_x86_register reg);
+
+#endif  // !X86_H
@@ -0,0 +1,1196 @@
+#include "assembler.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stb_ds.h"
+#include "str.h"
+#include "utils.h"
+#include "x86.h"
+
+#define C_ASM_MAX_OPERANDS 3
+#define C_ASM_MAX_NAME_LENGTH 64
+#define C_ASM_MAX_LINE_LENGTH 128
+
+#define C_ASM_REX 0x40
+#define C_ASM_REX_W 0x08
+#define C_ASM_REX_R 0x04
+#define C_ASM_REX_X 0x02
+#define C_ASM_REX_B 0x01
+
+typedef enum {
+    C_ASM_OPERAND_REGISTER,
+    C_ASM_OPERAND_IMMEDIATE,
+    C_ASM_OPERAND_MEMORY,
+    C_ASM_OPERAND_LABEL,
+} c_asm_operand_kind;
+
+typedef struct {
+    c_asm_operand_kind kind;
+    // NOTE: in bytes, 0 when the operand does not say
+    int size;
+    c_x86_register reg;
+    int64_t immediate;
+    c_x86_register base;
+    c_x86_register index;
+    int scale;
+    int64_t displacement;
+    char label[C_ASM_MAX_NAME_LENGTH];
+} c_asm_operand;
+
+typedef struct {
+    int is_label;
+    // NOTE: label name or mnemonic
+    char name[C_ASM_MAX_NAME_LENGTH];
+    c_asm_operand operands[C_ASM_MAX_OPERANDS];
+    int operands_count;
+    int64_t offset;
+    // NOTE: -1 until measured, jumps are measured every layout
+    int size;
+    // NOTE: jumps start with rel8 and only ever grow to rel32,
+    // so relaxation always terminates
+    int is_near;
+    // NOTE: jumps and calls, index of the label item or -1
+    int target;
+} c_asm_item;
+
+typedef struct {
+    const char *name;
+    int item;
+} c_asm_label;
+
+typedef struct {
+    c_asm_item *items;
+    // NOTE: sorted by name
+    c_asm_label *labels;
+    char **globals;
+    c_asm_object *object;
+} c_asm_context;
+
+typedef struct {
+    const char *mnemonic;
+    int extension;
+} c_asm_opcode_extension;
+
+static const c_asm_opcode_extension c_asm_arithmetic[] = {
+    {"add", 0}, {"or", 1}, {"and", 4}, {"sub", 5}, {"xor", 6}, {"cmp", 7},
+};
+
+static const c_asm_opcode_extension c_asm_unary[] = {
+    {"not", 2}, {"neg", 3}, {"mul", 4}, {"div", 6}, {"idiv", 7},
+};
+
+static const c_asm_opcode_extension c_asm_shifts[] = {
+    {"shl", 4}, {"sal", 4}, {"shr", 5}, {"sar", 7},
+};
+
+static const c_asm_opcode_extension c_asm_conditions[] = {
+    {"jo", 0x0},   {"jno", 0x1}, {"jb", 0x2},   {"jc", 0x2},   {"jnae", 0x2},
+    {"jae", 0x3},  {"jnb", 0x3}, {"jnc", 0x3},  {"je", 0x4},   {"jz", 0x4},
+    {"jne", 0x5},  {"jnz", 0x5}, {"jbe", 0x6},  {"jna", 0x6},  {"ja", 0x7},
+    {"jnbe", 0x7}, {"js", 0x8},  {"jns", 0x9},  {"jp", 0xa},   {"jpe", 0xa},
+    {"jnp", 0xb},  {"jpo", 0xb}, {"jl", 0xc},   {"jnge", 0xc}, {"jge", 0xd},
+    {"jnl", 0xd},  {"jle", 0xe}, {"jng", 0xe},  {"jg", 0xf},   {"jnle", 0xf},
+};
+
+#define C_ASM_LOOKUP(table, mnemonic) \
+    c_asm_lookup(table, sizeof(table) / sizeof(table[0]), mnemonic)
+
+static int c_asm_lookup(const c_asm_opcode_extension *table,
+                        size_t count,
+                        const char *mnemonic) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(table[i].mnemonic, mnemonic) == 0) {
+            return table[i].extension;
+        }
+    }
+
+    return -1;
+}
+
+static int c_asm_fits_int8(int64_t value) {
+    return value >= INT8_MIN && value <= INT8_MAX;
+}
+
+static int c_asm_fits_int32(int64_t value) {
+    return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+static char *c_asm_trim(char *text) {
+    while (isspace((unsigned char)*text)) {
+        text++;
+    }
+
+    char *end = text + strlen(text);
+
+    while (end > text && isspace((unsigned char)end[-1])) {
+        *--end = '\0';
+    }
+
+    return text;
+}
+
+static void c_asm_parse_memory(char *text, c_asm_operand *operand) {
+    char compact[C_ASM_MAX_LINE_LENGTH];
+    int length = 0;
+
+    for (char *c = text; *c && *c != ']'; c++) {
+        if (!isspace((unsigned char)*c) && length < C_ASM_MAX_LINE_LENGTH - 1) {
+            compact[length++] = *c;
+        }
+    }
+    compact[length] = '\0';
+
+    operand->kind = C_ASM_OPERAND_MEMORY;
+    operand->base = C_X86_NO_REGISTER;
+    operand->index = C_X86_NO_REGISTER;
+    operand->scale = 1;
+    operand->displacement = 0;
+
+    char *term = compact;
+
+    while (*term) {
+        int sign = 1;
+
+        if (*term == '+' || *term == '-') {
+            sign = *term == '-' ? -1 : 1;
+            term++;
+        }
+
+        char *end = term;
+
+        while (*end && *end != '+' && *end != '-') {
+            end++;
+        }
+
+        char saved = *end;
+        *end = '\0';
+
+        char *star = strchr(term, '*');
+
+        if (star) {
+            *star = '\0';
+            c_x86_register reg = c_x86_register_from_name(term);
+            char *scale = star + 1;
+
+            if (reg == C_X86_NO_REGISTER) {
+                reg = c_x86_register_from_name(star + 1);
+                scale = term;
+            }
+
+            if (reg == C_X86_NO_REGISTER || sign < 0) {
+                EXIT_WITH_ERROR("Got invalid index in memory operand: %s\n",
+                                text);
+            }
+
+            operand->index = reg;
+            operand->scale = atoi(scale);
+        } else if (c_x86_register_from_name(term) != C_X86_NO_REGISTER) {
+            c_x86_register reg = c_x86_register_from_name(term);
+
+            if (sign < 0) {
+                EXIT_WITH_ERROR("Got negated register in memory operand: %s\n",
+                                text);
+            }
+
+            if (operand->base == C_X86_NO_REGISTER) {
+                operand->base = reg;
+            } else {
+                operand->index = reg;
+            }
+        } else {
+            operand->displacement += sign * strtoll(term, NULL, 0);
+        }
+
+        *end = saved;
+        term = end;
+    }
+
+    if (operand->scale != 1 && operand->scale != 2 && operand->scale != 4
+        && operand->scale != 8) {
+        EXIT_WITH_ERROR("Got invalid scale in memory operand: %s\n", text);
+    }
+
+    if (!c_asm_fits_int32(operand->displacement)) {
+        EXIT_WITH_ERROR("Got displacement out of range: %s\n", text);
+    }
+}
+
+static void c_asm_parse_operand(char *text, c_asm_operand *operand) {
+    memset(operand, 0, sizeof(c_asm_operand));
+    operand->reg = C_X86_NO_REGISTER;
+    text = c_asm_trim(text);
+
+    if (strncmp(text, "qword", 5) == 0 || strncmp(text, "dword", 5) == 0) {
+        operand->size = text[0] == 'q' ? 8 : 4;
+        text = c_asm_trim(text + 5);
+    }
+
+    if (text[0] == '[') {
+        int size = operand->size;
+        c_asm_parse_memory(text + 1, operand);
+        operand->size = size;
+    } else if (c_x86_register_from_name(text) != C_X86_NO_REGISTER) {
+        operand->kind = C_ASM_OPERAND_REGISTER;
+        operand->reg = c_x86_register_from_name(text);
+        operand->size = c_x86_register_size(text);
+    } else if (isdigit((unsigned char)text[0]) || text[0] == '-'
+               || text[0] == '+') {
+        operand->kind = C_ASM_OPERAND_IMMEDIATE;
+        operand->immediate = strtoll(text, NULL, 0);
+    } else {
+        if (strlen(text) >= C_ASM_MAX_NAME_LENGTH) {
+            EXIT_WITH_ERROR("Got label that is too long: %s\n", text);
+        }
+
+        operand->kind = C_ASM_OPERAND_LABEL;
+        strcpy(operand->label, text);
+    }
+}
+
+// NOTE: returns 0 for lines that produce nothing
+static int c_asm_parse_line(c_asm_context *context,
+                            const char *line,
+                            c_asm_item *item) {
+    char buffer[C_ASM_MAX_LINE_LENGTH];
+    snprintf(buffer, sizeof(buffer), "%s", line);
+
+    char *comment = strchr(buffer, ';');
+
+    if (comment) {
+        *comment = '\0';
+    }
+
+    char *text = c_asm_trim(buffer);
+
+    if (*text == '\0') {
+        return 0;
+    }
+
+    memset(item, 0, sizeof(c_asm_item));
+    item->size = -1;
+
+    size_t length = strlen(text);
+
+    if (text[length - 1] == ':') {
+        text[length - 1] = '\0';
+
+        if (length - 1 >= C_ASM_MAX_NAME_LENGTH) {
+            EXIT_WITH_ERROR("Got label that is too long: %s\n", text);
+        }
+
+        item->is_label = 1;
+        strcpy(item->name, text);
+        return 1;
+    }
+
+    char *operands = text;
+
+    while (*operands && !isspace((unsigned char)*operands)) {
+        operands++;
+    }
+
+    if (*operands) {
+        *operands++ = '\0';
+    }
+
+    operands = c_asm_trim(operands);
+
+    if (strcmp(text, "global") == 0) {
+        arrput(context->globals, strdup(operands));
+        return 0;
+    }
+
+    if (strcmp(text, "extern") == 0) {
+        return 0;
+    }
+
+    if (strcmp(text, "section") == 0) {
+        if (strcmp(operands, ".text") != 0) {
+            EXIT_WITH_ERROR("Got unsupported section: %s\n", operands);
+        }
+        return 0;
+    }
+
+    if (strlen(text) >= C_ASM_MAX_NAME_LENGTH) {
+        EXIT_WITH_ERROR("Got mnemonic that is too long: %s\n", text);
+    }
+
+    strcpy(item->name, text);
+
+    while (*operands) {
+        if (item->operands_count == C_ASM_MAX_OPERANDS) {
+            EXIT_WITH_ERROR("Got too many operands: %s\n", line);
+        }
+
+        char *end = operands;
+        int depth = 0;
+
+        while (*end && (*end != ',' || depth > 0)) {
+            depth += *end == '[' ? 1 : (*end == ']' ? -1 : 0);
+            end++;
+        }
+
+        char saved = *end;
+        *end = '\0';
+        c_asm_parse_operand(operands, &item->operands[item->operands_count++]);
+        operands = saved ? end + 1 : end;
+    }
+
+    return 1;
+}
+
+static void c_asm_immediate(uint8_t **bytes, int64_t value, int size) {
+    for (int i = 0; i < size; i++) {
+        arrput(*bytes, (uint8_t)((uint64_t)value >> (8 * i)));
+    }
+}
+
+static int c_asm_is(c_asm_item *item, int index, c_asm_operand_kind kind) {
+    return index < item->operands_count && item->operands[index].kind == kind;
+}
+
+static int c_asm_is_register_or_memory(c_asm_item *item, int index) {
+    return c_asm_is(item, index, C_ASM_OPERAND_REGISTER)
+           || c_asm_is(item, index, C_ASM_OPERAND_MEMORY);
+}
+
+static void c_asm_unsupported(c_asm_item *item) {
+    EXIT_WITH_ERROR("Got unsupported operands for %s\n", item->name);
+}
+
+// NOTE: operation size from the register and sized memory operands,
+// immediates and lea addresses take the size of the other operand
+static int c_asm_operation_size(c_asm_item *item) {
+    int size = 0;
+
+    for (int i = 0; i < item->operands_count; i++) {
+        c_asm_operand *operand = &item->operands[i];
+
+        if (operand->size == 0) {
+            continue;
+        }
+
+        if (size != 0 && operand->size != size) {
+            c_asm_unsupported(item);
+        }
+
+        size = operand->size;
+    }
+
+    if (size != 4 && size != 8) {
+        EXIT_WITH_ERROR("Got operation without a size: %s\n", item->name);
+    }
+
+    return size;
+}
+
+// NOTE: 32 bit operations also accept unsigned 32 bit immediates
+static int64_t c_asm_operation_immediate(c_asm_item *item,
+                                         int index,
+                                         int size) {
+    int64_t value = item->operands[index].immediate;
+
+    if (size == 4 && value > INT32_MAX && value <= (int64_t)UINT32_MAX) {
+        value -= (int64_t)UINT32_MAX + 1;
+    }
+
+    if (!c_asm_fits_int32(value)) {
+        EXIT_WITH_ERROR("Got immediate out of range for %s: %lld\n",
+                        item->name,
+                        (long long)item->operands[index].immediate);
+    }
+
+    return value;
+}
+
+static void c_asm_rex(uint8_t **bytes, int rex) {
+    if (rex != C_ASM_REX) {
+        arrput(*bytes, (uint8_t)rex);
+    }
+}
+
+// NOTE: REX, opcode, ModRM, SIB and displacement for an instruction
+// whose reg field is a register or an opcode extension
+static void c_asm_encode_rm(uint8_t **bytes,
+                            int wide,
+                            const uint8_t *opcode,
+                            int opcode_length,
+                            int reg,
+                            c_asm_operand *rm) {
+    int rex = C_ASM_REX | (wide ? C_ASM_REX_W : 0) | (reg & 8 ? C_ASM_REX_R : 0);
+
+    if (rm->kind == C_ASM_OPERAND_REGISTER) {
+        rex |= rm->reg & 8 ? C_ASM_REX_B : 0;
+        c_asm_rex(bytes, rex);
+
+        for (int i = 0; i < opcode_length; i++) {
+            arrput(*bytes, opcode[i]);
+        }
+
+        arrput(*bytes, (uint8_t)(0xc0 | (reg & 7) << 3 | (rm->reg & 7)));
+        return;
+    }
+
+    if (rm->kind != C_ASM_OPERAND_MEMORY || rm->index == C_X86_RSP
+        || (rm->base == C_X86_NO_REGISTER && rm->index == C_X86_NO_REGISTER)) {
+        EXIT_WITH_ERROR("Got unsupported addressing mode\n");
+    }
+
+    // NOTE: an index without base is SIB base 101 with mod 00,
+    // which always carries a 32 bit displacement
+    if (rm->base == C_X86_NO_REGISTER) {
+        int scale = rm->scale == 8 ? 3 : rm->scale / 2;
+
+        c_asm_rex(bytes, rex | (rm->index & 8 ? C_ASM_REX_X : 0));
+
+        for (int i = 0; i < opcode_length; i++) {
+            arrput(*bytes, opcode[i]);
+        }
+
+        arrput(*bytes, (uint8_t)((reg & 7) << 3 | 4));
+        arrput(*bytes, (uint8_t)(scale << 6 | (rm->index & 7) << 3 | 5));
+        c_asm_immediate(bytes, rm->displacement, 4);
+        return;
+    }
+
+    rex |= rm->base & 8 ? C_ASM_REX_B : 0;
+
+    if (rm->index != C_X86_NO_REGISTER) {
+        rex |= rm->index & 8 ? C_ASM_REX_X : 0;
+    }
+
+    c_asm_rex(bytes, rex);
+
+    for (int i = 0; i < opcode_length; i++) {
+        arrput(*bytes, opcode[i]);
+    }
+
+    // NOTE: rbp and r13 as base always need a displacement,
+    // rsp and r12 as base always need a SIB byte
+    int mod;
+
+    if (rm->displacement == 0 && (rm->base & 7) != C_X86_RBP) {
+        mod = 0;
+    } else if (c_asm_fits_int8(rm->displacement)) {
+        mod = 1;
+    } else {
+        mod = 2;
+    }
+
+    if (rm->index != C_X86_NO_REGISTER || (rm->base & 7) == C_X86_RSP) {
+        int index = rm->index == C_X86_NO_REGISTER ? C_X86_RSP : rm->index;
+        int scale = rm->scale == 8 ? 3 : rm->scale / 2;
+
+        arrput(*bytes, (uint8_t)(mod << 6 | (reg & 7) << 3 | 4));
+        arrput(*bytes, (uint8_t)(scale << 6 | (index & 7) << 3 | (rm->base & 7)));
+    } else {
+        arrput(*bytes, (uint8_t)(mod << 6 | (reg & 7) << 3 | (rm->base & 7)));
+    }
+
+    if (mod == 1) {
+        c_asm_immediate(bytes, rm->displacement, 1);
+    } else if (mod == 2) {
+        c_asm_immediate(bytes, rm->displacement, 4);
+    }
+}
+
+#define C_ASM_OPCODE(...) (const uint8_t[]){__VA_ARGS__}
+
+static void c_asm_encode_arithmetic(c_asm_item *item,
+                                    int extension,
+                                    uint8_t **bytes) {
+    if (item->operands_count != 2 || !c_asm_is_register_or_memory(item, 0)) {
+        c_asm_unsupported(item);
+    }
+
+    int size = c_asm_operation_size(item);
+    int wide = size == 8;
+    c_asm_operand *destination = &item->operands[0];
+    c_asm_operand *source = &item->operands[1];
+
+    if (source->kind == C_ASM_OPERAND_REGISTER) {
+        c_asm_encode_rm(bytes,
+                        wide,
+                        C_ASM_OPCODE((uint8_t)(extension * 8 + 1)),
+                        1,
+                        source->reg,
+                        destination);
+    } else if (source->kind == C_ASM_OPERAND_MEMORY
+               && destination->kind == C_ASM_OPERAND_REGISTER) {
+        c_asm_encode_rm(bytes,
+                        wide,
+                        C_ASM_OPCODE((uint8_t)(extension * 8 + 3)),
+                        1,
+                        destination->reg,
+                        source);
+    } else if (source->kind == C_ASM_OPERAND_IMMEDIATE) {
+        int64_t immediate = c_asm_operation_immediate(item, 1, size);
+
+        if (c_asm_fits_int8(immediate)) {
+            c_asm_encode_rm(
+                bytes, wide, C_ASM_OPCODE(0x83), 1, extension, destination);
+            c_asm_immediate(bytes, immediate, 1);
+        } else if (destination->kind == C_ASM_OPERAND_REGISTER
+                   && destination->reg == C_X86_RAX) {
+            c_asm_rex(bytes, C_ASM_REX | (wide ? C_ASM_REX_W : 0));
+            arrput(*bytes, (uint8_t)(extension * 8 + 5));
+            c_asm_immediate(bytes, immediate, 4);
+        } else {
+            c_asm_encode_rm(
+                bytes, wide, C_ASM_OPCODE(0x81), 1, extension, destination);
+            c_asm_immediate(bytes, immediate, 4);
+        }
+    } else {
+        c_asm_unsupported(item);
+    }
+}
+
+static void c_asm_encode_mov(c_asm_item *item, uint8_t **bytes) {
+    if (item->operands_count != 2 || !c_asm_is_register_or_memory(item, 0)) {
+        c_asm_unsupported(item);
+    }
+
+    int size = c_asm_operation_size(item);
+    int wide = size == 8;
+    c_asm_operand *destination = &item->operands[0];
+    c_asm_operand *source = &item->operands[1];
+
+    if (source->kind == C_ASM_OPERAND_REGISTER) {
+        c_asm_encode_rm(
+            bytes, wide, C_ASM_OPCODE(0x89), 1, source->reg, destination);
+        return;
+    }
+
+    if (source->kind == C_ASM_OPERAND_MEMORY
+        && destination->kind == C_ASM_OPERAND_REGISTER) {
+        c_asm_encode_rm(
+            bytes, wide, C_ASM_OPCODE(0x8b), 1, destination->reg, source);
+        return;
+    }
+
+    if (source->kind != C_ASM_OPERAND_IMMEDIATE) {
+        c_asm_unsupported(item);
+    }
+
+    int64_t value = source->immediate;
+
+    if (destination->kind == C_ASM_OPERAND_REGISTER) {
+        int reg = destination->reg;
+
+        // NOTE: writing the 32 bit register zero extends,
+        // so small positive 64 bit immediates take the short form
+        if (!wide || (value >= 0 && value <= (int64_t)UINT32_MAX)) {
+            if (!wide) {
+                value = c_asm_operation_immediate(item, 1, size);
+            }
+
+            c_asm_rex(bytes, C_ASM_REX | (reg & 8 ? C_ASM_REX_B : 0));
+            arrput(*bytes, (uint8_t)(0xb8 + (reg & 7)));
+            c_asm_immediate(bytes, value, 4);
+        } else if (c_asm_fits_int32(value)) {
+            c_asm_encode_rm(bytes, 1, C_ASM_OPCODE(0xc7), 1, 0, destination);
+            c_asm_immediate(bytes, value, 4);
+        } else {
+            c_asm_rex(bytes,
+                      C_ASM_REX | C_ASM_REX_W | (reg & 8 ? C_ASM_REX_B : 0));
+            arrput(*bytes, (uint8_t)(0xb8 + (reg & 7)));
+            c_asm_immediate(bytes, value, 8);
+        }
+        return;
+    }
+
+    c_asm_encode_rm(bytes, wide, C_ASM_OPCODE(0xc7), 1, 0, destination);
+    c_asm_immediate(bytes, c_asm_operation_immediate(item, 1, size), 4);
+}
+
+static void c_asm_encode_imul(c_asm_item *item, uint8_t **bytes) {
+    if (!c_asm_is_register_or_memory(item, 0)) {
+        c_asm_unsupported(item);
+    }
+
+    int size = c_asm_operation_size(item);
+    int wide = size == 8;
+
+    if (item->operands_count == 1) {
+        c_asm_encode_rm(
+            bytes, wide, C_ASM_OPCODE(0xf7), 1, 5, &item->operands[0]);
+        return;
+    }
+
+    if (!c_asm_is(item, 0, C_ASM_OPERAND_REGISTER)) {
+        c_asm_unsupported(item);
+    }
+
+    int reg = item->operands[0].reg;
+    c_asm_operand *source = &item->operands[1];
+    int immediate_index = 2;
+
+    // NOTE: imul r, imm is imul r, r, imm
+    if (item->operands_count == 2 && c_asm_is(item, 1, C_ASM_OPERAND_IMMEDIATE)) {
+        source = &item->operands[0];
+        immediate_index = 1;
+    } else if (!c_asm_is_register_or_memory(item, 1)) {
+        c_asm_unsupported(item);
+    }
+
+    if (item->operands_count == 2 && immediate_index == 2) {
+        c_asm_encode_rm(bytes, wide, C_ASM_OPCODE(0x0f, 0xaf), 2, reg, source);
+        return;
+    }
+
+    if (!c_asm_is(item, immediate_index, C_ASM_OPERAND_IMMEDIATE)) {
+        c_asm_unsupported(item);
+    }
+
+    int64_t immediate = c_asm_operation_immediate(item, immediate_index, size);
+
+    if (c_asm_fits_int8(immediate)) {
+        c_asm_encode_rm(bytes, wide, C_ASM_OPCODE(0x6b), 1, reg, source);
+        c_asm_immediate(bytes, immediate, 1);
+    } else {
+        c_asm_encode_rm(bytes, wide, C_ASM_OPCODE(0x69), 1, reg, source);
+        c_asm_immediate(bytes, immediate, 4);
+    }
+}
+
+static void c_asm_encode_shift(c_asm_item *item,
+                               int extension,
+                               uint8_t **bytes) {
+    if (item->operands_count != 2 || !c_asm_is_register_or_memory(item, 0)
+        || !c_asm_is(item, 1, C_ASM_OPERAND_IMMEDIATE)) {
+        c_asm_unsupported(item);
+    }
+
+    int wide = c_asm_operation_size(item) == 8;
+    int64_t count = item->operands[1].immediate;
+
+    if (count < 0 || count > (wide ? 63 : 31)) {
+        EXIT_WITH_ERROR("Got shift count out of range: %lld\n",
+                        (long long)count);
+    }
+
+    if (count == 1) {
+        c_asm_encode_rm(
+            bytes, wide, C_ASM_OPCODE(0xd1), 1, extension, &item->operands[0]);
+        return;
+    }
+
+    c_asm_encode_rm(
+        bytes, wide, C_ASM_OPCODE(0xc1), 1, extension, &item->operands[0]);
+    c_asm_immediate(bytes, count, 1);
+}
+
+static void c_asm_encode_stack(c_asm_item *item,
+                               uint8_t opcode,
+                               uint8_t **bytes) {
+    if (item->operands_count != 1 || !c_asm_is(item, 0, C_ASM_OPERAND_REGISTER)
+        || item->operands[0].size != 8) {
+        c_asm_unsupported(item);
+    }
+
+    int reg = item->operands[0].reg;
+    c_asm_rex(bytes, C_ASM_REX | (reg & 8 ? C_ASM_REX_B : 0));
+    arrput(*bytes, (uint8_t)(opcode + (reg & 7)));
+}
+
+static int c_asm_is_jump(c_asm_item *item) {
+    return !item->is_label
+           && (strcmp(item->name, "jmp") == 0
+               || C_ASM_LOOKUP(c_asm_conditions, item->name) != -1);
+}
+
+static int c_asm_jump_size(c_asm_item *item) {
+    if (!item->is_near) {
+        return 2;
+    }
+
+    return strcmp(item->name, "jmp") == 0 ? 5 : 6;
+}
+
+static int64_t c_asm_target_offset(c_asm_context *context,
+                                   c_asm_item *item) {
+    return item->target == -1 ? -1 : context->items[item->target].offset;
+}
+
+static const char *c_asm_target(c_asm_item *item) {
+    if (item->operands_count != 1 || !c_asm_is(item, 0, C_ASM_OPERAND_LABEL)) {
+        c_asm_unsupported(item);
+    }
+
+    return item->operands[0].label;
+}
+
+int c_asm_find_symbol(c_asm_object *object, const char *name) {
+    for (int i = 0; i < arrlen(object->symbols); i++) {
+        if (strcmp(object->symbols[i].name, name) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static int c_asm_add_symbol(c_asm_object *object, const char *name) {
+    int index = c_asm_find_symbol(object, name);
+
+    if (index != -1) {
+        return index;
+    }
+
+    c_asm_symbol symbol = {
+        .name = strdup(name), .offset = 0, .is_defined = 0, .is_global = 0};
+    arrput(object->symbols, symbol);
+    return (int)arrlen(object->symbols) - 1;
+}
+
+// NOTE: pc relative to a symbol defined outside this object,
+// only the final pass has an object to record it in
+static void c_asm_relocate(c_asm_context *context,
+                           const char *name,
+                           int64_t offset) {
+    if (context->object) {
+        c_asm_relocation relocation = {
+            .offset = offset,
+            .symbol = c_asm_add_symbol(context->object, name),
+            .addend = -4,
+        };
+        arrput(context->object->relocations, relocation);
+    }
+}
+
+static void c_asm_encode_jump(c_asm_context *context,
+                              c_asm_item *item,
+                              uint8_t **bytes) {
+    int64_t target = c_asm_target_offset(context, item);
+    int64_t next = item->offset + c_asm_jump_size(item);
+    int condition = C_ASM_LOOKUP(c_asm_conditions, item->name);
+
+    // NOTE: a tail call jumps to a function that may live elsewhere
+    if (target < 0 && condition == -1 && c_asm_target(item)[0] != '.') {
+        arrput(*bytes, 0xe9);
+        c_asm_relocate(context, c_asm_target(item), item->offset + 1);
+        c_asm_immediate(bytes, 0, 4);
+        return;
+    }
+
+    if (target < 0) {
+        EXIT_WITH_ERROR("Got jump to undefined label: %s\n", c_asm_target(item));
+    }
+
+    if (!item->is_near) {
+        arrput(*bytes, condition == -1 ? 0xeb : (uint8_t)(0x70 + condition));
+        c_asm_immediate(bytes, target - next, 1);
+        return;
+    }
+
+    if (condition == -1) {
+        arrput(*bytes, 0xe9);
+    } else {
+        arrput(*bytes, 0x0f);
+        arrput(*bytes, (uint8_t)(0x80 + condition));
+    }
+
+    c_asm_immediate(bytes, target - next, 4);
+}
+
+static void c_asm_encode_call(c_asm_context *context,
+                              c_asm_item *item,
+                              uint8_t **bytes) {
+    const char *name = c_asm_target(item);
+    int64_t target = c_asm_target_offset(context, item);
+
+    arrput(*bytes, 0xe8);
+
+    if (target >= 0) {
+        c_asm_immediate(bytes, target - (item->offset + 5), 4);
+        return;
+    }
+
+    c_asm_relocate(context, name, item->offset + 1);
+    c_asm_immediate(bytes, 0, 4);
+}
+
+static void c_asm_encode(c_asm_context *context,
+                         c_asm_item *item,
+                         uint8_t **bytes) {
+    const char *mnemonic = item->name;
+    int extension;
+
+    if (c_asm_is_jump(item)) {
+        c_asm_encode_jump(context, item, bytes);
+    } else if (strcmp(mnemonic, "call") == 0) {
+        c_asm_encode_call(context, item, bytes);
+    } else if (strcmp(mnemonic, "mov") == 0) {
+        c_asm_encode_mov(item, bytes);
+    } else if ((extension = C_ASM_LOOKUP(c_asm_arithmetic, mnemonic)) != -1) {
+        c_asm_encode_arithmetic(item, extension, bytes);
+    } else if (strcmp(mnemonic, "test") == 0) {
+        if (item->operands_count != 2 || !c_asm_is_register_or_memory(item, 0)) {
+            c_asm_unsupported(item);
+        }
+
+        int size = c_asm_operation_size(item);
+
+        if (c_asm_is(item, 1, C_ASM_OPERAND_REGISTER)) {
+            c_asm_encode_rm(bytes,
+                            size == 8,
+                            C_ASM_OPCODE(0x85),
+                            1,
+                            item->operands[1].reg,
+                            &item->operands[0]);
+        } else if (c_asm_is(item, 1, C_ASM_OPERAND_IMMEDIATE)) {
+            c_asm_encode_rm(
+                bytes, size == 8, C_ASM_OPCODE(0xf7), 1, 0, &item->operands[0]);
+            c_asm_immediate(bytes, c_asm_operation_immediate(item, 1, size), 4);
+        } else {
+            c_asm_unsupported(item);
+        }
+    } else if (strcmp(mnemonic, "lea") == 0) {
+        if (item->operands_count != 2
+            || !c_asm_is(item, 0, C_ASM_OPERAND_REGISTER)
+            || !c_asm_is(item, 1, C_ASM_OPERAND_MEMORY)) {
+            c_asm_unsupported(item);
+        }
+
+        c_asm_encode_rm(bytes,
+                        item->operands[0].size == 8,
+                        C_ASM_OPCODE(0x8d),
+                        1,
+                        item->operands[0].reg,
+                        &item->operands[1]);
+    } else if (strcmp(mnemonic, "movsxd") == 0) {
+        if (item->operands_count != 2
+            || !c_asm_is(item, 0, C_ASM_OPERAND_REGISTER)
+            || item->operands[0].size != 8
+            || !c_asm_is_register_or_memory(item, 1)
+            || item->operands[1].size != 4) {
+            c_asm_unsupported(item);
+        }
+
+        c_asm_encode_rm(bytes,
+                        1,
+                        C_ASM_OPCODE(0x63),
+                        1,
+                        item->operands[0].reg,
+                        &item->operands[1]);
+    } else if (strcmp(mnemonic, "imul") == 0) {
+        c_asm_encode_imul(item, bytes);
+    } else if ((extension = C_ASM_LOOKUP(c_asm_unary, mnemonic)) != -1) {
+        if (item->operands_count != 1 || !c_asm_is_register_or_memory(item, 0)) {
+            c_asm_unsupported(item);
+        }
+
+        c_asm_encode_rm(bytes,
+                        c_asm_operation_size(item) == 8,
+                        C_ASM_OPCODE(0xf7),
+                        1,
+                        extension,
+                        &item->operands[0]);
+    } else if ((extension = C_ASM_LOOKUP(c_asm_shifts, mnemonic)) != -1) {
+        c_asm_encode_shift(item, extension, bytes);
+    } else if (strcmp(mnemonic, "push") == 0) {
+        c_asm_encode_stack(item, 0x50, bytes);
+    } else if (strcmp(mnemonic, "pop") == 0) {
+        c_asm_encode_stack(item, 0x58, bytes);
+    } else if (strcmp(mnemonic, "cdq") == 0) {
+        arrput(*bytes, 0x99);
+    } else if (strcmp(mnemonic, "cqo") == 0) {
+        arrput(*bytes, C_ASM_REX | C_ASM_REX_W);
+        arrput(*bytes, 0x99);
+    } else if (strcmp(mnemonic, "ret") == 0) {
+        arrput(*bytes, 0xc3);
+    } else if (strcmp(mnemonic, "syscall") == 0) {
+        arrput(*bytes, 0x0f);
+        arrput(*bytes, 0x05);
+    } else if (strcmp(mnemonic, "nop") == 0) {
+        arrput(*bytes, 0x90);
+    } else {
+        EXIT_WITH_ERROR("Got unsupported instruction: %s\n", mnemonic);
+    }
+}
+
+static void c_asm_layout(c_asm_context *context) {
+    int64_t offset = 0;
+    uint8_t *scratch = NULL;
+
+    for (int i = 0; i < arrlen(context->items); i++) {
+        c_asm_item *item = &context->items[i];
+        item->offset = offset;
+
+        if (item->is_label) {
+            continue;
+        }
+
+        if (c_asm_is_jump(item)) {
+            item->size = c_asm_jump_size(item);
+        } else if (item->size == -1) {
+            // NOTE: everything but jumps has the same size
+            // wherever it ends up
+            size_t start = arrlenu(scratch);
+            c_asm_encode(context, item, &scratch);
+            item->size = (int)(arrlenu(scratch) - start);
+        }
+
+        offset += item->size;
+    }
+
+    arrfree(scratch);
+}
+
+// NOTE: grows rel8 jumps whose target is out of reach until
+// the layout no longer changes
+static void c_asm_relax(c_asm_context *context) {
+    int changed = 1;
+
+    while (changed) {
+        changed = 0;
+        c_asm_layout(context);
+
+        for (int i = 0; i < arrlen(context->items); i++) {
+            c_asm_item *item = &context->items[i];
+
+            if (!c_asm_is_jump(item) || item->is_near) {
+                continue;
+            }
+
+            int64_t target = c_asm_target_offset(context, item);
+
+            // NOTE: jumps out of the object are always rel32
+            if ((target < 0 && c_asm_target(item)[0] != '.')
+                || (target >= 0
+                    && !c_asm_fits_int8(target - (item->offset + 2)))) {
+                item->is_near = 1;
+                changed = 1;
+            }
+        }
+    }
+}
+
+static int c_asm_compare_labels(const void *a, const void *b) {
+    return strcmp(((const c_asm_label *)a)->name,
+                  ((const c_asm_label *)b)->name);
+}
+
+// NOTE: binds every jump and call to its label item once,
+// layouts then only read item offsets
+static void c_asm_resolve_labels(c_asm_context *context) {
+    for (int i = 0; i < arrlen(context->items); i++) {
+        if (context->items[i].is_label) {
+            c_asm_label label = {.name = context->items[i].name, .item = i};
+            arrput(context->labels, label);
+        }
+    }
+
+    if (arrlen(context->labels) > 0) {
+        qsort(context->labels,
+              arrlen(context->labels),
+              sizeof(c_asm_label),
+              c_asm_compare_labels);
+    }
+
+    for (int i = 1; i < arrlen(context->labels); i++) {
+        if (strcmp(context->labels[i - 1].name, context->labels[i].name) == 0) {
+            EXIT_WITH_ERROR("Got duplicate label: %s\n", context->labels[i].name);
+        }
+    }
+
+    for (int i = 0; i < arrlen(context->items); i++) {
+        c_asm_item *item = &context->items[i];
+        item->target = -1;
+
+        if (item->is_label
+            || (!c_asm_is_jump(item) && strcmp(item->name, "call") != 0)) {
+            continue;
+        }
+
+        c_asm_label key = {.name = c_asm_target(item), .item = -1};
+        c_asm_label *label = NULL;
+
+        if (arrlen(context->labels) > 0) {
+            label = bsearch(&key,
+                            context->labels,
+                            arrlen(context->labels),
+                            sizeof(c_asm_label),
+                            c_asm_compare_labels);
+        }
+
+        if (label) {
+            item->target = label->item;
+        }
+    }
+}
+
+static c_asm_object *c_asm_assemble_items(c_asm_context *context) {
+    c_asm_resolve_labels(context);
+
+    c_asm_relax(context);
+
+    c_asm_object *object = malloc(sizeof(c_asm_object));
+
+    if (!object) {
+        EXIT_WITH_ERROR("Failed to allocate memory for object\n");
+    }
+
+    object->text = NULL;
+    object->symbols = NULL;
+    object->relocations = NULL;
+    context->object = object;
+
+    for (int i = 0; i < arrlen(context->items); i++) {
+        c_asm_item *item = &context->items[i];
+
+        if (item->is_label) {
+            // NOTE: .L labels are assembler local like in gas
+            // and never reach the symbol table
+            if (strncmp(item->name, ".L", 2) != 0) {
+                int symbol = c_asm_add_symbol(object, item->name);
+                object->symbols[symbol].offset = item->offset;
+                object->symbols[symbol].is_defined = 1;
+            }
+            continue;
+        }
+
+        c_asm_encode(context, item, &object->text);
+    }
+
+    for (int i = 0; i < arrlen(context->globals); i++) {
+        int symbol = c_asm_add_symbol(object, context->globals[i]);
+        object->symbols[symbol].is_global = 1;
+        free(context->globals[i]);
+    }
+
+    // NOTE: symbols only ever referenced come from other objects
+    for (int i = 0; i < arrlen(object->symbols); i++) {
+        if (!object->symbols[i].is_defined) {
+            object->symbols[i].is_global = 1;
+        }
+    }
+
+    arrfree(context->globals);
+    arrfree(context->items);
+    arrfree(context->labels);
+
+    return object;
+}
+
+static void c_asm_copy_name(char *name, const char *text) {
+    if (strlen(text) >= C_ASM_MAX_NAME_LENGTH) {
+        EXIT_WITH_ERROR("Got name that is too long: %s\n", text);
+    }
+
+    strcpy(name, text);
+}
+
+static void c_asm_operand_from_mir(c_mir_function *function,
+                                   c_mir_operand *source,
+                                   c_asm_operand *operand) {
+    memset(operand, 0, sizeof(c_asm_operand));
+    operand->reg = C_X86_NO_REGISTER;
+    operand->size = source->size;
+
+    switch (source->kind) {
+        case C_MIR_REGISTER:
+            operand->kind = C_ASM_OPERAND_REGISTER;
+            operand->reg = source->reg;
+            break;
+        case C_MIR_IMMEDIATE:
+            operand->kind = C_ASM_OPERAND_IMMEDIATE;
+            operand->immediate = source->immediate;
+            break;
+        case C_MIR_MEMORY:
+            operand->kind = C_ASM_OPERAND_MEMORY;
+            operand->base = source->memory.base;
+            operand->index = source->memory.index;
+            operand->displacement = source->memory.displacement;
+            // NOTE: printed without a scale, so parsed back as 1
+            operand->scale =
+                source->memory.scale > 1 ? source->memory.scale : 1;
+
+            if (operand->scale != 1 && operand->scale != 2
+                && operand->scale != 4 && operand->scale != 8) {
+                EXIT_WITH_ERROR("Got invalid scale in memory operand: %d\n",
+                                operand->scale);
+            }
+            break;
+        case C_MIR_LABEL:
+            operand->kind = C_ASM_OPERAND_LABEL;
+            c_asm_copy_name(operand->label, function->labels[source->label]);
+            break;
+        default:
+            EXIT_WITH_ERROR("Got unknown machine operand kind: %d\n",
+                            source->kind);
+    }
+}
+
+static void c_asm_add_function(c_asm_context *context,
+                               c_mir_function *function) {
+    for (int b = 0; b < arrlen(function->blocks); b++) {
+        c_mir_block *block = &function->blocks[b];
+
+        if (block->label != C_MIR_NO_LABEL) {
+            c_asm_item label = {.is_label = 1, .size = -1};
+            c_asm_copy_name(label.name, function->labels[block->label]);
+            arrput(context->items, label);
+        }
+
+        for (int i = 0; i < arrlen(block->instructions); i++) {
+            c_mir_instruction *instruction = &block->instructions[i];
+            c_asm_item item = {.size = -1};
+
+            c_asm_copy_name(item.name,
+                            c_mir_opcode_to_string(instruction->opcode));
+            item.operands_count = instruction->operands_count;
+
+            for (int o = 0; o < instruction->operands_count; o++) {
+                c_asm_operand_from_mir(
+                    function, &instruction->operands[o], &item.operands[o]);
+            }
+
+            arrput(context->items, item);
+        }
+    }
+}
+
+c_asm_object *c_asm_assemble(char **lines) {
+    c_asm_context context = {0};
+
+    for (int i = 0; i < arrlen(lines); i++) {
+        c_asm_item item;
+
+        if (c_asm_parse_line(&context, lines[i], &item)) {
+            arrput(context.items, item);
+        }
+    }
+
+    return c_asm_assemble_items(&context);
+}
+
+c_asm_object *c_asm_assemble_module(c_mir_module *module) {
+    c_asm_context context = {0};
+
+    for (int i = 0; i < arrlen(module->globals); i++) {
+        arrput(context.globals, strdup(module->globals[i]));
+    }
+
+    for (int i = 0; i < arrlen(module->functions); i++) {
+        c_asm_add_function(&context, module->functions[i]);
+    }
+
+    return c_asm_assemble_items(&context);
+}
+
+void c_asm_object_free(c_asm_object *object) {
+    if (!object) {
+        return;
+    }
+
+    for (int i = 0; i < arrlen(object->symbols); i++) {
+        free(object->symbols[i].name);
+    }
+
+    arrfree(object->text);
+    arrfree(object->symbols);
+    arrfree(object->relocations);
+    free(object);
+}
@@ -0,0 +1,87 @@
+#include "call_rewrite.h"
+#include <stdlib.h>
+#include <string.h>
+#include "stb_ds.h"
+#include "utils.h"
+
+int c_call_find_function(c_ast_program *program, const char *name) {
+    for (int i = 0; i < arrlen(program->function_declarations); i++) {
+        if (strcmp(program->function_declarations[i]->function_name, name)
+            == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static c_ast_expression *c_call_rewrite(c_call_rewriter *rewriter,
+                                        c_ast_expression *expression) {
+    if (!expression) {
+        return expression;
+    }
+
+    if (expression->type == C_BINARY_EXPRESSION) {
+        expression->binary->lhs =
+            c_call_rewrite(rewriter, expression->binary->lhs);
+        expression->binary->rhs =
+            c_call_rewrite(rewriter, expression->binary->rhs);
+        return expression;
+    }
+
+    int value;
+
+    if (expression->type != C_FUNCTION_CALL
+        || !rewriter->value_for_call(rewriter->context,
+                                     expression->function_call->function_name,
+                                     &value)) {
+        return expression;
+    }
+
+    c_ast_expression *constant = malloc(sizeof(c_ast_expression));
+
+    if (!constant) {
+        EXIT_WITH_ERROR("Failed to allocate memory for expression\n");
+    }
+
+    constant->type = C_CONSTANT;
+    constant->constant = malloc(sizeof(c_ast_constant));
+    constant->constant->value = value;
+
+    rewriter->replaced(rewriter->context, expression);
+
+    return constant;
+}
+
+void c_call_rewrite_block(c_call_rewriter *rewriter, c_ast_block *block) {
+    for (int i = 0; i < arrlen(block->statements); i++) {
+        c_ast_statement *statement = block->statements[i];
+
+        switch (statement->type) {
+            case C_STATEMENT_BLOCK:
+                c_call_rewrite_block(rewriter, statement->block);
+                break;
+            case C_STATEMENT_RETURN:
+                statement->return_statement->value = c_call_rewrite(
+                    rewriter, statement->return_statement->value);
+                break;
+            case C_STATEMENT_EXPRESSION:
+                if (!rewriter->keep_call_statements
+                    || statement->expression->type != C_FUNCTION_CALL) {
+                    statement->expression =
+                        c_call_rewrite(rewriter, statement->expression);
+                }
+                break;
+            case C_STATEMENT_ASSIGNMENT:
+                statement->assignment->expression = c_call_rewrite(
+                    rewriter, statement->assignment->expression);
+                break;
+            default:
+                break;
+        }
+
+        if (rewriter->rewritten) {
+            i += rewriter->rewritten(rewriter->context, block, i);
+        }
+    }
+}
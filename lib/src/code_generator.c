@@ -1,369 +1,1086 @@
 #include "code_generator.h"
 #include <string.h>
+#include "dead_code.h"
+#include "frame.h"
+#include "ir.h"
+#include "machine_ir.h"
 #include "parser.h"
+#include "peephole.h"
+#include "range_analysis.h"
+#include "register_allocator.h"
+#include "ssa.h"
 #include "stb_ds.h"
+#include "strength_reduction.h"
+#include "thread_pool.h"
 #include "utils.h"
 #include "str.h"
+#include "value_numbering.h"
+#include "x86.h"
 
-#define MAX_LITERAL_LENGTH 64
+static void c_code_gen_append(c_code_gen_context *context,
+                              c_mir_instruction instruction) {
+    c_mir_append(context->machine, instruction);
+}
 
-#define ADD_TO_LINES(new_lines)                   \
-    for (int i = 0; i < arrlen(new_lines); i++) { \
-        arrput(lines, new_lines[i]);              \
-    }
+static void c_code_gen_emit1(c_code_gen_context *context,
+                             c_mir_opcode opcode,
+                             c_mir_operand operand) {
+    c_code_gen_append(context, c_mir_make1(opcode, operand));
+}
+
+static void c_code_gen_emit2(c_code_gen_context *context,
+                             c_mir_opcode opcode,
+                             c_mir_operand destination,
+                             c_mir_operand source) {
+    c_code_gen_append(context, c_mir_make2(opcode, destination, source));
+}
+
+static c_mir_operand c_code_gen_block_label(c_code_gen_context *context,
+                                            const char *format,
+                                            int block) {
+    return c_mir_label_operand(c_mir_label(context->machine, format, block));
+}
+
+static c_mir_operand c_code_gen_symbol(c_code_gen_context *context,
+                                       const char *name) {
+    return c_mir_label_operand(c_mir_label(context->machine, "%s", name));
+}
+
+c_code_gen_options c_code_gen_default_options(void) {
+    return c_code_gen_options_for_level(0);
+}
+
+c_code_gen_options c_code_gen_options_for_level(int optimization_level) {
+    c_code_gen_options options = {
+        .optimization_level = optimization_level,
+        .omit_frame_pointer = optimization_level >= 2,
+        .tail_calls = optimization_level >= 1,
+        .jobs = 1,
+        .schedule = optimization_level >= 2,
+        .tune = c_schedule_model_for("generic"),
+        .peephole_fires = NULL,
+    };
+    return options;
+}
+
+// NOTE: functions share nothing while they are optimized and
+// emitted, so each one can go to a different worker
+typedef struct {
+    c_ir_module *module;
+    c_code_gen_options options;
+    // NOTE: one machine function each, filled by the workers
+    c_mir_function **machine_functions;
+} c_code_gen_module_task;
+
+static void c_code_gen_optimize_task(void *data, int index) {
+    c_code_gen_module_task *task = data;
+
+    c_code_gen_optimize_function(task->module->functions[index],
+                                 task->options);
+}
+
+static void c_code_gen_emit_task(void *data, int index) {
+    c_code_gen_module_task *task = data;
+
+    task->machine_functions[index] =
+        c_code_gen_select_function(task->module->functions[index],
+                                   task->options);
+}
 
 char **c_code_gen_emit(c_ast_program *program) {
+    return c_code_gen_emit_with_options(program, c_code_gen_default_options());
+}
+
+char **c_code_gen_emit_with_options(c_ast_program *program,
+                                    c_code_gen_options options) {
     char **lines = NULL;
+    c_mir_module *machine = c_code_gen_select_program(program, options);
 
-    arrput(lines, strdup("global _start"));
-    arrput(lines, strdup(""));
-    arrput(lines, strdup("section .text"));
-    arrput(lines, strdup("_start:"));
-    arrput(lines, strdup("    call main"));
-    arrput(lines, strdup(""));
-    arrput(lines, strdup("    mov rdi, rax"));
-    arrput(lines, strdup("    mov rax, 60"));
-    arrput(lines, strdup("    syscall"));
-    arrput(lines, strdup(""));
+    c_mir_print_module(machine, &lines);
+    c_mir_module_free(machine);
 
-    for (int i = 0; i < arrlen(program->function_declarations); i++) {
-        char **function_lines = c_code_gen_emit_function_declaration(
-            program->function_declarations[i]);
+    return lines;
+}
 
-        for (int i = 0; i < arrlen(function_lines); i++) {
-            arrput(lines, function_lines[i]);
-        }
+c_mir_module *c_code_gen_select_program(c_ast_program *program,
+                                        c_code_gen_options options) {
+    c_ir_module *module = c_ir_lower_program(program);
+
+    // NOTE: _start only calls main, nothing else can reach the rest
+    c_ir_module_remove_dead_functions(module, "main");
 
-        arrfree(function_lines);
+    c_code_gen_module_task task = {.module = module, .options = options};
+    c_thread_pool_run(options.jobs,
+                      (int)arrlen(module->functions),
+                      c_code_gen_optimize_task,
+                      &task);
+
+    c_mir_module *machine = c_code_gen_select_module(module, options);
+    c_ir_module_free(module);
+
+    return machine;
+}
+
+void c_code_gen_optimize_function(c_ir_function *function,
+                                  c_code_gen_options options) {
+    if (options.optimization_level >= 1) {
+        // NOTE: dead locals then get no phis during promotion
+        c_dead_store_eliminate(function);
+        c_ssa_promote_allocas(function);
+        c_value_number_function(function);
+        c_range_simplify_function(function);
+        c_dead_code_eliminate(function);
     }
+}
 
-    return lines;
+c_mir_module *c_code_gen_select_module(c_ir_module *module,
+                                       c_code_gen_options options) {
+    c_mir_module *machine = calloc(1, sizeof(c_mir_module));
+
+    if (!machine) {
+        EXIT_WITH_ERROR("Failed to allocate memory for machine module\n");
+    }
+
+    arrput(machine->globals, strdup("_start"));
+
+    c_mir_function *start = c_mir_function_create("_start");
+    c_mir_append(start,
+                 c_mir_make1(C_MIR_CALL,
+                             c_mir_label_operand(c_mir_label(start, "main"))));
+    c_mir_begin_block(start, C_MIR_NO_LABEL);
+    c_mir_append(start,
+                 c_mir_make2(C_MIR_MOV,
+                             c_mir_register(C_X86_RDI, 4),
+                             c_mir_register(C_X86_RAX, 4)));
+    c_mir_append(start,
+                 c_mir_make2(C_MIR_MOV,
+                             c_mir_register(C_X86_RAX, 4),
+                             c_mir_immediate(60)));
+    c_mir_append(start, c_mir_make0(C_MIR_SYSCALL));
+    arrput(machine->functions, start);
+
+    int count = (int)arrlen(module->functions);
+    c_code_gen_module_task task = {.module = module, .options = options};
+    task.machine_functions =
+        calloc(count ? count : 1, sizeof(c_mir_function *));
+
+    c_thread_pool_run(options.jobs, count, c_code_gen_emit_task, &task);
+
+    // NOTE: declaration order, whichever worker finished first
+    for (int f = 0; f < count; f++) {
+        arrput(machine->functions, task.machine_functions[f]);
+    }
+
+    free(task.machine_functions);
+
+    // NOTE: after the workers, so the rule counters are not shared
+    if (options.optimization_level >= 1) {
+        for (int f = 0; f < arrlen(machine->functions); f++) {
+            c_peephole_optimize_function(machine->functions[f],
+                                         options.peephole_fires);
+        }
+    }
+
+    return machine;
 }
 
-char **c_code_gen_emit_constant(c_ast_constant *constant) {
-    char **lines = NULL;
+typedef struct {
+    c_mir_operand destination;
+    c_mir_operand source;
+    int size;
+} c_code_gen_move;
 
-    char *line = malloc(MAX_LITERAL_LENGTH);
-    snprintf(line, MAX_LITERAL_LENGTH, "    mov rax, %d", constant->value);
-    arrput(lines, line);
+static int c_code_gen_is_constant(c_code_gen_context *context, int value) {
+    return context->function->instructions[value].opcode == C_IR_CONSTANT;
+}
 
-    return lines;
+static c_x86_register c_code_gen_register(c_code_gen_context *context,
+                                          int value) {
+    return context->allocation->registers[value];
 }
 
-char **c_code_gen_emit_function_call(c_ast_function_call *function_call,
-                                     const char *assign_to_variable) {
-    char **lines = NULL;
+// NOTE: size in bytes of the value, registers and
+// memory operands are picked to match it
+static int c_code_gen_size(c_code_gen_context *context, int value) {
+    return c_ir_type_size(context->function->instructions[value].type);
+}
 
-    char *function_label = malloc(strlen(function_call->function_name) + 10);
-    snprintf(function_label,
-             strlen(function_call->function_name) + 10,
-             "    call %s",
-             function_call->function_name);
-    arrput(lines, function_label);
+// NOTE: ranges are only known from -O1, in SSA form
+static int c_code_gen_is_non_negative(c_code_gen_context *context,
+                                      int value) {
+    return context->ranges && c_range_is_non_negative(context->ranges[value]);
+}
 
-    if (assign_to_variable) {
-        char *assignment_line = malloc(strlen(assign_to_variable) + 20);
-        snprintf(assignment_line,
-                 strlen(assign_to_variable) + 20,
-                 "    mov qword %s, rax",
-                 assign_to_variable);
-        arrput(lines, assignment_line);
+static c_mir_operand c_code_gen_sized(c_x86_register reg, int size) {
+    return c_mir_register(reg, size);
+}
+
+static c_mir_operand c_code_gen_slot(c_code_gen_context *context, int value) {
+    c_frame_slot *slot = c_frame_slot_of(context->frame, value);
+
+    return c_mir_memory(c_frame_base_register(context->frame),
+                        C_X86_NO_REGISTER,
+                        1,
+                        c_frame_displacement(context->frame, slot),
+                        slot->size);
+}
+
+// NOTE: where a value lives, constants are always immediates
+// and values without a location go through the scratch
+static c_mir_operand c_code_gen_operand(c_code_gen_context *context,
+                                        int value) {
+    c_ir_instruction *instruction = &context->function->instructions[value];
+    c_x86_register reg = c_code_gen_register(context, value);
+    int size = c_code_gen_size(context, value);
+
+    if (instruction->opcode == C_IR_CONSTANT) {
+        return c_mir_immediate(instruction->constant);
     }
 
-    return lines;
+    if (context->selection->forms[value] == C_ISEL_FOLDED) {
+        // NOTE: only loads are folded into the operands of their user
+        return c_code_gen_slot(context, instruction->operands[0]);
+    }
+
+    if (reg != C_X86_NO_REGISTER) {
+        return c_code_gen_sized(reg, size);
+    }
+
+    if (c_frame_slot_of(context->frame, value)) {
+        return c_code_gen_slot(context, value);
+    }
+
+    if (context->use_counts[value] == 0) {
+        return c_code_gen_sized(C_REGISTER_ALLOCATOR_SCRATCH, size);
+    }
+
+    EXIT_WITH_ERROR("Value %%%d has no location in %s\n",
+                    value,
+                    context->function->name);
 }
 
-// global _start
-//
-// section .text
-// _start:
-//     call main
-//     mov edi, eax
-//     mov eax, 60
-//     syscall
-//
-// main:
-//     push rbp
-//     mov rbp, rsp
-//
-//     sub rsp, 4
-//     %define myVar [rbp-4]
-//
-//     sub rsp, 4
-//     %define anotherVar [rbp-8]
-//
-//     mov dword myVar, 42
-//     mov dword anotherVar, 100
-//
-//     mov eax, myVar
-//     add eax, anotherVar
-//
-//     mov rsp, rbp
-//     pop rbp
-//     ret
-
-char **c_code_gen_emit_variable_assignment(
-    c_ast_variable_assignment *assignment,
-    int *current_offset) {
-    char **lines = NULL;
+static void c_code_gen_move_operand(c_code_gen_context *context,
+                                    c_mir_operand destination,
+                                    c_mir_operand source) {
+    if (c_mir_operand_equal(destination, source)) {
+        return;
+    }
 
-    arrput(lines, strdup(""));
-    // TODO: get size of the variable type
-    arrput(lines, strdup("    sub rsp, 8"));
+    if (c_mir_is_memory(destination) && c_mir_is_memory(source)) {
+        c_mir_operand scratch =
+            c_code_gen_sized(C_REGISTER_ALLOCATOR_SCRATCH, source.size);
+        c_code_gen_emit2(context, C_MIR_MOV, scratch, source);
+        c_code_gen_emit2(context, C_MIR_MOV, destination, scratch);
+        return;
+    }
 
-    *current_offset += 8;
+    c_code_gen_emit2(context, C_MIR_MOV, destination, source);
+}
 
-    int offset_digits = snprintf(NULL, 0, "%d", *current_offset);
-    size_t length = strlen(assignment->variable_name) + 20 + offset_digits;
-    char *variable_label = malloc(length);
+// NOTE: register the result is computed in, spilled
+// values are computed in the scratch and stored after
+static c_mir_operand c_code_gen_work_register(c_code_gen_context *context,
+                                              int value) {
+    c_x86_register reg = c_code_gen_register(context, value);
 
-    snprintf(variable_label,
-             length,
-             "    %%define %s [rbp-%d]",
-             assignment->variable_name,
-             *current_offset);
-    arrput(lines, variable_label);
-    arrput(lines, strdup(""));
+    if (reg == C_X86_NO_REGISTER) {
+        reg = C_REGISTER_ALLOCATOR_SCRATCH;
+    }
 
-    return lines;
+    return c_code_gen_sized(reg, c_code_gen_size(context, value));
 }
 
-char **c_code_gen_emit_expression(c_ast_expression *expression,
-                                  int *current_offset) {
-    char **lines = NULL;
+static void c_code_gen_define(c_code_gen_context *context,
+                              int value,
+                              c_mir_operand work) {
+    c_code_gen_move_operand(context, c_code_gen_operand(context, value), work);
+}
 
-    switch (expression->type) {
-        case C_CONSTANT: {
-            char **constant_lines =
-                c_code_gen_emit_constant(expression->constant);
-            ADD_TO_LINES(constant_lines);
-            arrfree(constant_lines);
-            break;
+void c_code_gen_emit_multiply_by_constant(c_code_gen_context *context,
+                                          c_mir_operand work,
+                                          c_mir_operand factor,
+                                          int constant) {
+    int lea_scale;
+    int shift;
+    int negate;
+
+    if (constant == 0) {
+        c_code_gen_emit2(context, C_MIR_MOV, work, c_mir_immediate(0));
+        return;
+    }
+
+    if (!c_strength_decompose_multiply(constant, &lea_scale, &shift, &negate)) {
+        if (!c_mir_is_register(factor) && !c_mir_is_memory(factor)) {
+            c_code_gen_move_operand(context, work, factor);
+            factor = work;
         }
-        case C_FUNCTION_CALL: {
-            char **function_call_lines =
-                c_code_gen_emit_function_call(expression->function_call, NULL);
-            ADD_TO_LINES(function_call_lines);
-            arrfree(function_call_lines);
-            break;
+
+        c_code_gen_append(
+            context,
+            c_mir_make3(C_MIR_IMUL, work, factor, c_mir_immediate(constant)));
+        return;
+    }
+
+    if (lea_scale > 0) {
+        if (!c_mir_is_register(factor)) {
+            c_code_gen_move_operand(context, work, factor);
+            factor = work;
         }
-        case C_VARIABLE: {
-            char **variable_lines =
-                c_code_gen_emit_variable(expression->variable);
-            ADD_TO_LINES(variable_lines);
-            arrfree(variable_lines);
-            break;
+
+        // NOTE: addresses are always 64 bit, the low half
+        // of the result only depends on the low halves
+        c_code_gen_emit2(
+            context,
+            C_MIR_LEA,
+            work,
+            c_mir_memory(factor.reg, factor.reg, lea_scale, 0, 0));
+    } else {
+        c_code_gen_move_operand(context, work, factor);
+    }
+
+    if (shift > 0) {
+        c_code_gen_emit2(context, C_MIR_SHL, work, c_mir_immediate(shift));
+    }
+
+    if (negate) {
+        c_code_gen_emit1(context, C_MIR_NEG, work);
+    }
+}
+
+// NOTE: rounds toward zero by adding divisor - 1 to negative
+// dividends before the arithmetic shift
+static void c_code_gen_emit_signed_power_of_two_division(
+    c_code_gen_context *context,
+    c_mir_operand work,
+    c_mir_operand dividend,
+    int64_t divisor,
+    int remainder) {
+    uint64_t magnitude = divisor < 0 ? 0 - (uint64_t)divisor : (uint64_t)divisor;
+    int k = c_strength_log2(magnitude);
+    int size = work.size;
+    int bits = size * 8;
+    c_mir_operand ax = c_code_gen_sized(C_X86_RAX, size);
+    c_mir_operand dx = c_code_gen_sized(C_X86_RDX, size);
+
+    if (k == 0) {
+        if (remainder) {
+            c_code_gen_emit2(context, C_MIR_MOV, work, c_mir_immediate(0));
+            return;
         }
-        case C_BINARY_EXPRESSION: {
-            char **binary_expression_lines = c_code_gen_emit_binary_expression(
-                expression->binary, current_offset);
-            ADD_TO_LINES(binary_expression_lines);
-            arrfree(binary_expression_lines);
-            break;
+
+        c_code_gen_move_operand(context, work, dividend);
+
+        if (divisor < 0) {
+            c_code_gen_emit1(context, C_MIR_NEG, work);
         }
-        default:
-            arrfree(lines);
-            EXIT_WITH_ERROR("Got unsupported type for expression emit: %d\n",
-                            expression->type);
+        return;
     }
 
-    return lines;
+    c_code_gen_move_operand(context, ax, dividend);
+    c_code_gen_emit2(context, C_MIR_MOV, dx, ax);
+    c_code_gen_emit2(context, C_MIR_SAR, dx, c_mir_immediate(bits - 1));
+    c_code_gen_emit2(context, C_MIR_SHR, dx, c_mir_immediate(bits - k));
+    c_code_gen_emit2(context, C_MIR_ADD, ax, dx);
+
+    if (remainder) {
+        c_code_gen_emit2(
+            context, C_MIR_AND, ax, c_mir_immediate(-(int64_t)magnitude));
+        c_code_gen_emit1(context, C_MIR_NEG, ax);
+        c_code_gen_emit2(context, C_MIR_ADD, ax, dividend);
+    } else {
+        c_code_gen_emit2(context, C_MIR_SAR, ax, c_mir_immediate(k));
+
+        if (divisor < 0) {
+            c_code_gen_emit1(context, C_MIR_NEG, ax);
+        }
+    }
+
+    c_code_gen_move_operand(context, work, ax);
 }
 
-char **c_code_gen_emit_binary_expression(c_ast_binary_expression *binary,
-                                         int *current_offset) {
-    char **lines = NULL;
+static void c_code_gen_emit_unsigned_power_of_two_division(
+    c_code_gen_context *context,
+    c_mir_operand work,
+    c_mir_operand dividend,
+    uint64_t divisor,
+    int remainder) {
+    int k = c_strength_log2(divisor);
+    c_mir_operand ax = c_code_gen_sized(C_X86_RAX, work.size);
+    c_mir_operand dx = c_code_gen_sized(C_X86_RDX, work.size);
 
-    char **lhs_lines = c_code_gen_emit_expression(binary->lhs, current_offset);
-    ADD_TO_LINES(lhs_lines);
-    arrfree(lhs_lines);
+    c_code_gen_move_operand(context, ax, dividend);
 
-    arrput(lines, strdup("    push rax"));
+    if (remainder) {
+        c_mir_operand mask = c_mir_immediate((int64_t)(divisor - 1));
 
-    char **rhs_lines = c_code_gen_emit_expression(binary->rhs, current_offset);
-    ADD_TO_LINES(rhs_lines);
-    arrfree(rhs_lines);
+        if (divisor - 1 <= INT32_MAX) {
+            c_code_gen_emit2(context, C_MIR_AND, ax, mask);
+        } else {
+            c_code_gen_emit2(context, C_MIR_MOV, dx, mask);
+            c_code_gen_emit2(context, C_MIR_AND, ax, dx);
+        }
+    } else if (k > 0) {
+        c_code_gen_emit2(context, C_MIR_SHR, ax, c_mir_immediate(k));
+    }
 
-    arrput(lines, strdup("    pop rbx"));
+    c_code_gen_move_operand(context, work, ax);
+}
 
-    switch (binary->symbol) {
-        case '+': {
-            arrput(lines, strdup("    add rax, rbx"));
-            break;
+void c_code_gen_emit_division_by_constant(c_code_gen_context *context,
+                                          c_mir_operand work,
+                                          c_mir_operand dividend,
+                                          int64_t divisor,
+                                          int is_unsigned,
+                                          int is_non_negative,
+                                          int remainder) {
+    uint64_t magnitude = divisor < 0 && !is_unsigned ? 0 - (uint64_t)divisor
+                                                     : (uint64_t)divisor;
+    int size = work.size;
+    int bits = size * 8;
+    // NOTE: a non-negative quotient is already rounded toward zero
+    int needs_rounding = 1;
+
+    // NOTE: both operands non-negative give the same quotient read as
+    // unsigned, which skips the sign handling. Divisors whose unsigned
+    // magic needs the extra add keep the shorter signed multiply
+    if (!is_unsigned && is_non_negative && divisor > 0) {
+        needs_rounding = 0;
+        is_unsigned =
+            c_strength_is_power_of_two(magnitude)
+            || !c_strength_unsigned_magic(divisor, bits).add;
+    }
+
+    c_mir_operand ax = c_code_gen_sized(C_X86_RAX, size);
+    c_mir_operand dx = c_code_gen_sized(C_X86_RDX, size);
+
+    if (magnitude == 0) {
+        EXIT_WITH_ERROR("Got division by constant zero in %s\n",
+                        context->function->name);
+    }
+
+    // NOTE: one operand mul and add need the dividend in a register
+    // or memory, never as an immediate
+    if (!c_mir_is_register(dividend) && !c_mir_is_memory(dividend)) {
+        c_mir_operand scratch =
+            c_code_gen_sized(C_REGISTER_ALLOCATOR_SCRATCH, size);
+        c_code_gen_emit2(context, C_MIR_MOV, scratch, dividend);
+        dividend = scratch;
+    }
+
+    if (c_strength_is_power_of_two(magnitude)) {
+        if (is_unsigned) {
+            c_code_gen_emit_unsigned_power_of_two_division(
+                context, work, dividend, magnitude, remainder);
+        } else {
+            c_code_gen_emit_signed_power_of_two_division(
+                context, work, dividend, divisor, remainder);
         }
-        case '-': {
-            arrput(lines, strdup("    sub rbx, rax"));
-            arrput(lines, strdup("    mov rax, rbx"));
+        return;
+    }
+
+    if (is_unsigned) {
+        c_magic_number magic = c_strength_unsigned_magic(divisor, bits);
+
+        c_code_gen_emit2(
+            context, C_MIR_MOV, ax, c_mir_immediate(magic.multiplier));
+        c_code_gen_emit1(context, C_MIR_MUL, dividend);
+
+        if (magic.add) {
+            c_code_gen_move_operand(context, ax, dividend);
+            c_code_gen_emit2(context, C_MIR_SUB, ax, dx);
+            c_code_gen_emit2(context, C_MIR_SHR, ax, c_mir_immediate(1));
+            c_code_gen_emit2(context, C_MIR_ADD, dx, ax);
+
+            if (magic.shift > 1) {
+                c_code_gen_emit2(
+                    context, C_MIR_SHR, dx, c_mir_immediate(magic.shift - 1));
+            }
+        } else if (magic.shift > 0) {
+            c_code_gen_emit2(
+                context, C_MIR_SHR, dx, c_mir_immediate(magic.shift));
+        }
+    } else {
+        c_magic_number magic = c_strength_signed_magic(divisor, bits);
+
+        c_code_gen_emit2(
+            context, C_MIR_MOV, ax, c_mir_immediate(magic.multiplier));
+        c_code_gen_emit1(context, C_MIR_IMUL, dividend);
+
+        if (divisor > 0 && magic.multiplier < 0) {
+            c_code_gen_emit2(context, C_MIR_ADD, dx, dividend);
+        } else if (divisor < 0 && magic.multiplier > 0) {
+            c_code_gen_emit2(context, C_MIR_SUB, dx, dividend);
+        }
+
+        if (magic.shift > 0) {
+            c_code_gen_emit2(
+                context, C_MIR_SAR, dx, c_mir_immediate(magic.shift));
+        }
+
+        // NOTE: add one for negative quotients to round toward zero
+        if (needs_rounding) {
+            c_code_gen_emit2(context, C_MIR_MOV, ax, dx);
+            c_code_gen_emit2(
+                context, C_MIR_SHR, ax, c_mir_immediate(bits - 1));
+            c_code_gen_emit2(context, C_MIR_ADD, dx, ax);
+        }
+    }
+
+    if (remainder) {
+        if (divisor >= INT32_MIN && divisor <= INT32_MAX) {
+            c_code_gen_append(
+                context,
+                c_mir_make3(C_MIR_IMUL, dx, dx, c_mir_immediate(divisor)));
+        } else {
+            c_code_gen_emit2(
+                context, C_MIR_MOV, ax, c_mir_immediate(divisor));
+            c_code_gen_emit2(context, C_MIR_IMUL, dx, ax);
+        }
+
+        c_code_gen_move_operand(context, ax, dividend);
+        c_code_gen_emit2(context, C_MIR_SUB, ax, dx);
+        c_code_gen_move_operand(context, work, ax);
+        return;
+    }
+
+    c_code_gen_move_operand(context, work, dx);
+}
+
+static c_x86_register c_code_gen_address_register(c_code_gen_context *context,
+                                                  int value) {
+    return value == C_IR_NO_VALUE ? C_X86_NO_REGISTER
+                                  : c_code_gen_register(context, value);
+}
+
+// NOTE: one lea for the whole add tree picked by the selector
+static void c_code_gen_emit_address(c_code_gen_context *context,
+                                    c_mir_operand work,
+                                    c_isel_address *address) {
+    c_code_gen_emit2(
+        context,
+        C_MIR_LEA,
+        work,
+        c_mir_memory(c_code_gen_address_register(context, address->base),
+                     c_code_gen_address_register(context, address->index),
+                     address->scale,
+                     address->displacement,
+                     0));
+}
+
+void c_code_gen_emit_binary(c_code_gen_context *context, int value) {
+    c_ir_instruction *instruction = &context->function->instructions[value];
+    c_mir_operand work = c_code_gen_work_register(context, value);
+    int lhs = instruction->operands[0];
+    int rhs = instruction->operands[1];
+
+    if (context->selection->forms[value] == C_ISEL_ADDRESS) {
+        c_code_gen_emit_address(
+            context, work, &context->selection->addresses[value]);
+        c_code_gen_define(context, value, work);
+        return;
+    }
+
+    switch (instruction->opcode) {
+        case C_IR_ADD:
+        case C_IR_MULTIPLY: {
+            // NOTE: two address form, make the operand that already
+            // sits in the destination the one that gets overwritten
+            if (c_mir_operand_equal(c_code_gen_operand(context, rhs), work)
+                || (c_code_gen_is_constant(context, lhs)
+                    && !c_code_gen_is_constant(context, rhs))) {
+                int tmp = lhs;
+                lhs = rhs;
+                rhs = tmp;
+            }
+
+            c_mir_operand lhs_operand = c_code_gen_operand(context, lhs);
+            c_mir_operand rhs_operand = c_code_gen_operand(context, rhs);
+
+            if (instruction->opcode == C_IR_MULTIPLY
+                && c_code_gen_is_constant(context, rhs)
+                && context->options.optimization_level >= 1) {
+                c_code_gen_emit_multiply_by_constant(
+                    context,
+                    work,
+                    lhs_operand,
+                    context->function->instructions[rhs].constant);
+                break;
+            }
+
+            if (instruction->opcode == C_IR_MULTIPLY
+                && c_code_gen_is_constant(context, rhs)
+                && !c_code_gen_is_constant(context, lhs)) {
+                c_code_gen_append(
+                    context,
+                    c_mir_make3(C_MIR_IMUL, work, lhs_operand, rhs_operand));
+                break;
+            }
+
+            c_code_gen_move_operand(context, work, lhs_operand);
+            c_code_gen_emit2(
+                context,
+                instruction->opcode == C_IR_ADD ? C_MIR_ADD : C_MIR_IMUL,
+                work,
+                rhs_operand);
             break;
         }
-        case '*': {
-            arrput(lines, strdup("    imul rax, rbx"));
+        case C_IR_SUBTRACT: {
+            c_mir_operand lhs_operand = c_code_gen_operand(context, lhs);
+            c_mir_operand rhs_operand = c_code_gen_operand(context, rhs);
+
+            if (c_mir_operand_equal(rhs_operand, work)
+                && !c_mir_operand_equal(lhs_operand, work)) {
+                c_code_gen_emit1(context, C_MIR_NEG, work);
+                c_code_gen_emit2(context, C_MIR_ADD, work, lhs_operand);
+                break;
+            }
+
+            c_code_gen_move_operand(context, work, lhs_operand);
+            c_code_gen_emit2(context, C_MIR_SUB, work, rhs_operand);
             break;
         }
-        case '/': {
-            arrput(lines, strdup("    mov rdx, 0"));
-            arrput(lines, strdup("    mov rcx, rax"));
-            arrput(lines, strdup("    mov rax, rbx"));
-            // NOTE: remainder in rdx
-            arrput(lines, strdup("    idiv rcx"));
+        case C_IR_DIVIDE: {
+            c_mir_operand lhs_operand = c_code_gen_operand(context, lhs);
+            c_mir_operand rhs_operand = c_code_gen_operand(context, rhs);
+
+            // NOTE: a zero divisor keeps idiv so it still traps
+            if (c_code_gen_is_constant(context, rhs)
+                && context->function->instructions[rhs].constant != 0
+                && context->options.optimization_level >= 1) {
+                c_code_gen_emit_division_by_constant(
+                    context,
+                    work,
+                    lhs_operand,
+                    context->function->instructions[rhs].constant,
+                    0,
+                    c_code_gen_is_non_negative(context, lhs),
+                    0);
+                break;
+            }
+
+            int size = c_code_gen_size(context, value);
+            c_mir_operand ax = c_code_gen_sized(C_X86_RAX, size);
+            c_mir_operand dx = c_code_gen_sized(C_X86_RDX, size);
+            int is_unsigned = c_code_gen_is_non_negative(context, lhs)
+                              && c_code_gen_is_non_negative(context, rhs);
+
+            c_code_gen_move_operand(context, ax, lhs_operand);
+
+            // NOTE: cdq sign extends eax into edx, cqo rax into rdx,
+            // a non-negative dividend only needs edx cleared
+            if (is_unsigned) {
+                c_code_gen_emit2(context, C_MIR_XOR, dx, dx);
+            } else {
+                c_code_gen_append(
+                    context, c_mir_make0(size == 8 ? C_MIR_CQO : C_MIR_CDQ));
+            }
+
+            c_mir_opcode divide = is_unsigned ? C_MIR_DIV : C_MIR_IDIV;
+
+            if (c_code_gen_is_constant(context, rhs)) {
+                c_mir_operand scratch =
+                    c_code_gen_sized(C_REGISTER_ALLOCATOR_SCRATCH, size);
+                c_code_gen_emit2(context, C_MIR_MOV, scratch, rhs_operand);
+                c_code_gen_emit1(context, divide, scratch);
+            } else {
+                c_code_gen_emit1(context, divide, rhs_operand);
+            }
+
+            c_code_gen_move_operand(context, work, ax);
             break;
         }
         default:
-            EXIT_WITH_ERROR("Received inproper binary operator symbol: %c",
-                            binary->symbol);
+            EXIT_WITH_ERROR("Received inproper binary opcode: %d\n",
+                            instruction->opcode);
     }
 
-    return lines;
+    c_code_gen_define(context, value, work);
 }
 
-char **c_code_gen_emit_variable(c_ast_variable *variable) {
-    char **lines = NULL;
+static int c_code_gen_is_move_source(c_code_gen_move *moves,
+                                     c_mir_operand operand) {
+    for (int i = 0; i < arrlen(moves); i++) {
+        if (c_mir_operand_equal(moves[i].source, operand)) {
+            return 1;
+        }
+    }
 
-    size_t length = strlen(variable->name) + 30;
-    char *load_line = malloc(length);
+    return 0;
+}
 
-    snprintf(load_line, length, "    mov rax, qword %s", variable->name);
-    arrput(lines, load_line);
+void c_code_gen_emit_phi_copies(c_code_gen_context *context,
+                                int from_block,
+                                int to_block) {
+    c_ir_function *function = context->function;
+    int *instructions = function->blocks[to_block].instructions;
+    c_code_gen_move *moves = NULL;
 
-    return lines;
+    for (int i = 0; i < arrlen(instructions); i++) {
+        c_ir_instruction *instruction = &function->instructions[instructions[i]];
+
+        if (instruction->opcode != C_IR_PHI) {
+            break;
+        }
+
+        if (context->use_counts[instructions[i]] == 0) {
+            continue;
+        }
+
+        for (int p = 0; p < arrlen(instruction->phi_operands); p++) {
+            if (instruction->phi_operands[p].block == from_block) {
+                c_code_gen_move move;
+                move.size = c_code_gen_size(context, instructions[i]);
+                move.destination = c_code_gen_operand(context, instructions[i]);
+                move.source = c_code_gen_operand(
+                    context, instruction->phi_operands[p].value);
+
+                if (!c_mir_operand_equal(move.destination, move.source)) {
+                    arrput(moves, move);
+                }
+                break;
+            }
+        }
+    }
+
+    // NOTE: phis read their operands in parallel, emit a move only once
+    // nothing else still reads its destination and break cycles through rax
+    while (arrlen(moves) > 0) {
+        int ready = -1;
+
+        for (int i = 0; i < arrlen(moves); i++) {
+            if (!c_code_gen_is_move_source(moves, moves[i].destination)) {
+                ready = i;
+                break;
+            }
+        }
+
+        if (ready == -1) {
+            c_mir_operand blocked = moves[0].destination;
+            c_mir_operand ax = c_code_gen_sized(C_X86_RAX, moves[0].size);
+            c_code_gen_move_operand(context, ax, blocked);
+
+            for (int i = 0; i < arrlen(moves); i++) {
+                if (c_mir_operand_equal(moves[i].source, blocked)) {
+                    moves[i].source = ax;
+                }
+            }
+            continue;
+        }
+
+        c_code_gen_move_operand(
+            context, moves[ready].destination, moves[ready].source);
+        arrdel(moves, ready);
+    }
+
+    arrfree(moves);
 }
 
-char **c_code_gen_emit_return(c_ast_return *ret, int *current_offset) {
-    char **lines = NULL;
+static void c_code_gen_emit_exit(c_code_gen_context *context,
+                                 const char *tail_callee) {
+    if (tail_callee) {
+        c_code_gen_emit1(
+            context, C_MIR_JMP, c_code_gen_symbol(context, tail_callee));
+        return;
+    }
+
+    c_code_gen_append(context, c_mir_make0(C_MIR_RET));
+}
+
+// NOTE: a tail call tears the frame down like a return and
+// jumps, the callee returns straight to our caller
+static void c_code_gen_emit_epilogue(c_code_gen_context *context,
+                                     const char *tail_callee) {
+    c_x86_register *saved = context->allocation->saved_registers;
+    c_mir_operand rsp = c_code_gen_sized(C_X86_RSP, 8);
+
+    c_mir_begin_block(context->machine, C_MIR_NO_LABEL);
 
-    if (ret->value) {
-        char **expression_lines =
-            c_code_gen_emit_expression(ret->value, current_offset);
-        ADD_TO_LINES(expression_lines);
-        arrfree(expression_lines);
+    if (context->frame->omit_frame_pointer) {
+        if (context->frame->allocation_size > 0) {
+            c_code_gen_emit2(
+                context,
+                C_MIR_ADD,
+                rsp,
+                c_mir_immediate(context->frame->allocation_size));
+        }
+
+        for (int i = (int)arrlen(saved) - 1; i >= 0; i--) {
+            c_code_gen_emit1(
+                context, C_MIR_POP, c_code_gen_sized(saved[i], 8));
+        }
+
+        c_code_gen_emit_exit(context, tail_callee);
+        return;
     }
 
-    return lines;
+    if (arrlen(saved) > 0) {
+        c_code_gen_emit2(context,
+                         C_MIR_LEA,
+                         rsp,
+                         c_mir_memory(C_X86_RBP,
+                                      C_X86_NO_REGISTER,
+                                      1,
+                                      -8 * (int)arrlen(saved),
+                                      0));
+
+        for (int i = (int)arrlen(saved) - 1; i >= 0; i--) {
+            c_code_gen_emit1(
+                context, C_MIR_POP, c_code_gen_sized(saved[i], 8));
+        }
+    } else if (context->frame->allocation_size > 0) {
+        c_code_gen_emit2(
+            context, C_MIR_MOV, rsp, c_code_gen_sized(C_X86_RBP, 8));
+    }
+
+    c_code_gen_emit1(context, C_MIR_POP, c_code_gen_sized(C_X86_RBP, 8));
+    c_code_gen_emit_exit(context, tail_callee);
 }
 
-char **c_code_gen_emit_statement(c_ast_statement *statement,
-                                 int *current_offset) {
-    char **lines = NULL;
+static void c_code_gen_emit_condition(c_code_gen_context *context, int value) {
+    c_mir_operand operand = c_code_gen_operand(context, value);
+
+    if (c_mir_is_memory(operand)) {
+        c_code_gen_emit2(context, C_MIR_CMP, operand, c_mir_immediate(0));
+    } else if (c_code_gen_is_constant(context, value)) {
+        c_mir_operand scratch = c_code_gen_sized(
+            C_REGISTER_ALLOCATOR_SCRATCH, c_code_gen_size(context, value));
+        c_code_gen_emit2(context, C_MIR_MOV, scratch, operand);
+        c_code_gen_emit2(context, C_MIR_TEST, scratch, scratch);
+    } else {
+        c_code_gen_emit2(context, C_MIR_TEST, operand, operand);
+    }
+}
 
-    switch (statement->type) {
-        case C_STATEMENT_BLOCK: {
-            char **block_lines =
-                c_code_gen_emit_block(statement->block, current_offset);
-            ADD_TO_LINES(block_lines);
-            arrfree(block_lines);
+void c_code_gen_emit_instruction(c_code_gen_context *context, int value) {
+    c_ir_instruction *instruction = &context->function->instructions[value];
+
+    // NOTE: emitted as part of its user
+    if (context->selection->forms[value] == C_ISEL_FOLDED) {
+        return;
+    }
+
+    switch (instruction->opcode) {
+        case C_IR_CONSTANT:
+        case C_IR_ALLOCA:
+        case C_IR_PHI:
+        case C_IR_NOP:
             break;
-        }
-        case C_STATEMENT_RETURN: {
-            char **return_lines = c_code_gen_emit_return(
-                statement->return_statement, current_offset);
-            ADD_TO_LINES(return_lines);
-            arrfree(return_lines);
+        case C_IR_LOAD: {
+            if (context->use_counts[value] == 0) {
+                break;
+            }
+
+            c_mir_operand work = c_code_gen_work_register(context, value);
+            c_mir_operand slot =
+                c_code_gen_slot(context, instruction->operands[0]);
+            c_code_gen_emit2(context, C_MIR_MOV, work, slot);
+            c_code_gen_define(context, value, work);
             break;
         }
-        case C_STATEMENT_FUNCTION_DECLARATION: {
-            char **function_declaration_lines =
-                c_code_gen_emit_function_declaration(
-                    statement->function_declaration);
-            ADD_TO_LINES(function_declaration_lines);
-            arrfree(function_declaration_lines);
+        case C_IR_STORE:
+            c_code_gen_move_operand(
+                context,
+                c_code_gen_slot(context, instruction->operands[0]),
+                c_code_gen_operand(context, instruction->operands[1]));
             break;
-        }
-        case C_STATEMENT_EXPRESSION: {
-            char **expression_lines = c_code_gen_emit_expression(
-                statement->expression, current_offset);
-            ADD_TO_LINES(expression_lines);
-            arrfree(expression_lines);
+        case C_IR_CALL:
+            if (context->options.tail_calls
+                && c_ir_is_tail_call(
+                    context->function, value, context->use_counts)) {
+                context->tail_callee = instruction->function_name;
+                break;
+            }
+
+            c_code_gen_emit1(
+                context,
+                C_MIR_CALL,
+                c_code_gen_symbol(context, instruction->function_name));
+
+            if (context->use_counts[value] > 0) {
+                c_mir_operand ax =
+                    c_code_gen_sized(C_X86_RAX, c_code_gen_size(context, value));
+                c_code_gen_define(context, value, ax);
+            }
             break;
-        }
-        case C_STATEMENT_ASSIGNMENT: {
-            char **assignment_lines = c_code_gen_emit_variable_assignment(
-                statement->assignment, current_offset);
-            ADD_TO_LINES(assignment_lines);
-            arrfree(assignment_lines);
-
-            if (statement->assignment->expression) {
-                switch (statement->assignment->expression->type) {
-                    case C_FUNCTION_CALL: {
-                        char **function_call_lines =
-                            c_code_gen_emit_function_call(
-                                statement->assignment->expression
-                                    ->function_call,
-                                statement->assignment->variable_name);
-                        ADD_TO_LINES(function_call_lines);
-                        arrfree(function_call_lines);
-                        break;
-                    }
-                    default: {
-                        char **expression_lines = c_code_gen_emit_expression(
-                            statement->assignment->expression, current_offset);
-                        ADD_TO_LINES(expression_lines);
-                        arrfree(expression_lines);
-
-                        char *assignment_line = malloc(
-                            strlen(statement->assignment->variable_name) + 30);
-                        snprintf(
-                            assignment_line,
-                            strlen(statement->assignment->variable_name) + 30,
-                            "    mov qword %s, rax",
-                            statement->assignment->variable_name);
-                        arrput(lines, assignment_line);
-                    }
-                }
+        case C_IR_JUMP: {
+            int target = instruction->targets[0];
+            c_code_gen_emit_phi_copies(context, instruction->block, target);
+
+            if (target != instruction->block + 1) {
+                c_code_gen_emit1(
+                    context,
+                    C_MIR_JMP,
+                    c_code_gen_block_label(context, ".L%d", target));
             }
             break;
         }
-        case C_STATEMENT_NOOP: {
+        case C_IR_BRANCH: {
+            int block = instruction->block;
+            int then_block = instruction->targets[0];
+            int else_block = instruction->targets[1];
+            c_mir_operand else_label =
+                c_code_gen_block_label(context, ".L%d_else", block);
+
+            c_code_gen_emit_condition(context, instruction->operands[0]);
+            c_code_gen_emit1(context, C_MIR_JZ, else_label);
+            c_code_gen_emit_phi_copies(context, block, then_block);
+            c_code_gen_emit1(
+                context,
+                C_MIR_JMP,
+                c_code_gen_block_label(context, ".L%d", then_block));
+            c_mir_begin_block(context->machine, else_label.label);
+            c_code_gen_emit_phi_copies(context, block, else_block);
+            c_code_gen_emit1(
+                context,
+                C_MIR_JMP,
+                c_code_gen_block_label(context, ".L%d", else_block));
             break;
         }
+        case C_IR_RETURN:
+            if (context->tail_callee) {
+                c_code_gen_emit_epilogue(context, context->tail_callee);
+                context->tail_callee = NULL;
+                break;
+            }
+
+            if (instruction->operands[0] != C_IR_NO_VALUE) {
+                int returned = instruction->operands[0];
+                c_mir_operand ax = c_code_gen_sized(
+                    C_X86_RAX, c_code_gen_size(context, returned));
+                c_code_gen_move_operand(
+                    context, ax, c_code_gen_operand(context, returned));
+            }
+
+            if (context->has_shared_epilogue) {
+                c_code_gen_emit1(context,
+                                 C_MIR_JMP,
+                                 c_code_gen_symbol(context, ".Lreturn"));
+            } else {
+                c_code_gen_emit_epilogue(context, NULL);
+            }
+            break;
         default:
-            arrfree(lines);
-            EXIT_WITH_ERROR("Got unsupported type for statement emit: %d\n",
-                            statement->type);
+            if (c_ir_is_binary(instruction->opcode)) {
+                // NOTE: arithmetic has no side effects, unused results
+                // are not worth computing
+                if (context->use_counts[value] > 0) {
+                    c_code_gen_emit_binary(context, value);
+                }
+                break;
+            }
+
+            EXIT_WITH_ERROR("Got unsupported ir opcode for emit: %d\n",
+                            instruction->opcode);
     }
+}
 
-    return lines;
+// NOTE: returns that end in a tail call keep their own epilogue
+static int c_code_gen_count_returns(c_code_gen_context *context) {
+    c_ir_function *function = context->function;
+    int count = 0;
+
+    for (int v = 0; v < arrlen(function->instructions); v++) {
+        c_ir_instruction *instruction = &function->instructions[v];
+
+        if (instruction->opcode == C_IR_RETURN) {
+            count++;
+        } else if (instruction->opcode == C_IR_CALL
+                   && context->options.tail_calls
+                   && c_ir_is_tail_call(function, v, context->use_counts)) {
+            count--;
+        }
+    }
+
+    return count;
 }
 
-char **c_code_gen_emit_block(c_ast_block *block, int *current_offset) {
-    char **lines = NULL;
+c_mir_function *c_code_gen_select_function(c_ir_function *function,
+                                           c_code_gen_options options) {
+    c_code_gen_context context = {0};
+    context.function = function;
+    context.machine = c_mir_function_create(function->name);
+    context.options = options;
+    context.use_counts = c_ir_use_counts(function);
+    context.allocation = c_register_allocate(function);
+    context.frame = c_frame_layout_create(function,
+                                          context.allocation,
+                                          options.omit_frame_pointer,
+                                          options.tail_calls);
+    context.selection = c_isel_select(
+        function, context.use_counts, context.allocation);
+
+    if (options.optimization_level >= 1) {
+        context.ranges = c_range_analyze(function);
+    }
 
-    for (int i = 0; i < arrlen(block->statements); i++) {
-        char **statement_lines =
-            c_code_gen_emit_statement(block->statements[i], current_offset);
+    c_x86_register *saved = context.allocation->saved_registers;
 
-        ADD_TO_LINES(statement_lines);
-        arrfree(statement_lines);
+    if (!options.omit_frame_pointer) {
+        c_code_gen_emit1(
+            &context, C_MIR_PUSH, c_code_gen_sized(C_X86_RBP, 8));
+        c_code_gen_emit2(&context,
+                         C_MIR_MOV,
+                         c_code_gen_sized(C_X86_RBP, 8),
+                         c_code_gen_sized(C_X86_RSP, 8));
     }
 
-    return lines;
+    for (int i = 0; i < arrlen(saved); i++) {
+        c_code_gen_emit1(&context, C_MIR_PUSH, c_code_gen_sized(saved[i], 8));
+    }
+
+    if (context.frame->allocation_size > 0) {
+        c_code_gen_emit2(&context,
+                         C_MIR_SUB,
+                         c_code_gen_sized(C_X86_RSP, 8),
+                         c_mir_immediate(context.frame->allocation_size));
+    }
+
+    context.has_shared_epilogue = c_code_gen_count_returns(&context) > 1;
+
+    for (int b = 0; b < arrlen(function->blocks); b++) {
+        int *instructions = function->blocks[b].instructions;
+
+        // NOTE: unreachable blocks are left empty and nothing jumps there
+        if (b > 0 && arrlen(instructions) == 0) {
+            continue;
+        }
+
+        if (b > 0) {
+            c_mir_begin_block(context.machine,
+                              c_mir_label(context.machine, ".L%d", b));
+        }
+
+        for (int i = 0; i < arrlen(instructions); i++) {
+            c_code_gen_emit_instruction(&context, instructions[i]);
+        }
+    }
+
+    if (context.has_shared_epilogue) {
+        c_mir_begin_block(context.machine,
+                          c_mir_label(context.machine, ".Lreturn"));
+        c_code_gen_emit_epilogue(&context, NULL);
+    }
+
+    if (options.schedule) {
+        c_schedule_function(context.machine, options.tune);
+    }
+
+    arrfree(context.use_counts);
+    arrfree(context.ranges);
+    c_isel_selection_free(context.selection);
+    c_frame_layout_free(context.frame);
+    c_register_allocation_free(context.allocation);
+
+    return context.machine;
 }
 
-char **c_code_gen_emit_function_declaration(
-    c_ast_function_declaration *function_declaration) {
+char **c_code_gen_emit_function(c_ir_function *function,
+                                c_code_gen_options options) {
     char **lines = NULL;
+    c_mir_function *machine = c_code_gen_select_function(function, options);
 
-    char *function_label =
-        malloc(strlen(function_declaration->function_name) + 2);
-    snprintf(function_label,
-             strlen(function_declaration->function_name) + 2,
-             "%s:",
-             function_declaration->function_name);
-    arrput(lines, function_label);
-
-    arrput(lines, strdup("    push rbp"));
-    arrput(lines, strdup("    mov rbp, rsp"));
-
-    int current_offset = 0;
-    char **body_lines =
-        c_code_gen_emit_block(function_declaration->body, &current_offset);
-    ADD_TO_LINES(body_lines);
-    arrfree(body_lines);
-
-    arrput(lines, strdup(""));
-    arrput(lines, strdup("    mov rsp, rbp"));
-    arrput(lines, strdup("    pop rbp"));
-    arrput(lines, strdup("    ret"));
-    arrput(lines, strdup(""));
+    c_mir_print_function(machine, &lines);
+    c_mir_function_free(machine);
 
     return lines;
 }
@@ -0,0 +1,287 @@
+#include "constant_folding.h"
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "error.h"
+#include "parser.h"
+#include "stb_ds.h"
+#include "utils.h"
+
+static int c_fold_wrap(uint32_t value) {
+    if (value <= INT_MAX) {
+        return (int)value;
+    }
+
+    return (int)(value - 0x80000000u) + INT_MIN;
+}
+
+int c_fold_evaluate(char symbol, int lhs, int rhs, int *result) {
+    uint32_t a = (uint32_t)lhs;
+    uint32_t b = (uint32_t)rhs;
+
+    switch (symbol) {
+        case '+':
+            *result = c_fold_wrap(a + b);
+            return 1;
+        case '-':
+            *result = c_fold_wrap(a - b);
+            return 1;
+        case '*':
+            *result = c_fold_wrap(a * b);
+            return 1;
+        case '/':
+            // NOTE: both trap at run time, leave them there
+            if (rhs == 0 || (lhs == INT_MIN && rhs == -1)) {
+                return 0;
+            }
+
+            *result = lhs / rhs;
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+int c_fold_is_pure(c_ast_expression *expression) {
+    switch (expression->type) {
+        case C_CONSTANT:
+        case C_VARIABLE:
+            return 1;
+        case C_FUNCTION_CALL:
+            return 0;
+        case C_BINARY_EXPRESSION:
+            return c_fold_is_pure(expression->binary->lhs)
+                   && c_fold_is_pure(expression->binary->rhs);
+        default:
+            return 0;
+    }
+}
+
+int c_fold_expressions_equal(c_ast_expression *a, c_ast_expression *b) {
+    if (a->type != b->type) {
+        return 0;
+    }
+
+    switch (a->type) {
+        case C_CONSTANT:
+            return a->constant->value == b->constant->value;
+        case C_VARIABLE:
+            return strcmp(a->variable->name, b->variable->name) == 0;
+        case C_FUNCTION_CALL:
+            return strcmp(a->function_call->function_name,
+                          b->function_call->function_name)
+                   == 0;
+        case C_BINARY_EXPRESSION:
+            return a->binary->symbol == b->binary->symbol
+                   && c_fold_expressions_equal(a->binary->lhs, b->binary->lhs)
+                   && c_fold_expressions_equal(a->binary->rhs, b->binary->rhs);
+        default:
+            return 0;
+    }
+}
+
+static int c_fold_is_constant(c_ast_expression *expression, int value) {
+    return expression->type == C_CONSTANT
+           && expression->constant->value == value;
+}
+
+static c_ast_expression *c_fold_make_constant(int value) {
+    c_ast_expression *expression = malloc(sizeof(c_ast_expression));
+    expression->type = C_CONSTANT;
+    expression->constant = malloc(sizeof(c_ast_constant));
+    expression->constant->value = value;
+    return expression;
+}
+
+// NOTE: drops the binary node and the other operand
+static c_ast_expression *c_fold_keep_operand(c_fold_context *context,
+                                             c_ast_expression *expression,
+                                             int keep_lhs) {
+    c_ast_binary_expression *binary = expression->binary;
+    c_ast_expression *kept = keep_lhs ? binary->lhs : binary->rhs;
+
+    if (keep_lhs) {
+        binary->lhs = NULL;
+    } else {
+        binary->rhs = NULL;
+    }
+
+    c_ast_free_expression(expression);
+    context->folded++;
+
+    return kept;
+}
+
+static c_ast_expression *c_fold_replace_with_constant(
+    c_fold_context *context,
+    c_ast_expression *expression,
+    int value) {
+    c_ast_free_expression(expression);
+    context->folded++;
+
+    return c_fold_make_constant(value);
+}
+
+// NOTE: (x + c1) + c2 -> x + (c1 + c2), same for * and for
+// (x - c1) - c2 -> x - (c1 + c2), all exact under wrapping
+static c_ast_expression *c_fold_reassociate(c_fold_context *context,
+                                            c_ast_expression *expression) {
+    c_ast_binary_expression *binary = expression->binary;
+    c_ast_expression *inner = binary->lhs;
+
+    if (inner->type != C_BINARY_EXPRESSION || binary->rhs->type != C_CONSTANT
+        || inner->binary->rhs->type != C_CONSTANT
+        || inner->binary->symbol != binary->symbol) {
+        return expression;
+    }
+
+    char combine;
+
+    switch (binary->symbol) {
+        case '+':
+        case '-':
+            combine = '+';
+            break;
+        case '*':
+            combine = '*';
+            break;
+        default:
+            return expression;
+    }
+
+    int combined;
+    c_fold_evaluate(combine,
+                    inner->binary->rhs->constant->value,
+                    binary->rhs->constant->value,
+                    &combined);
+    inner->binary->rhs->constant->value = combined;
+
+    return c_fold_keep_operand(context, expression, 1);
+}
+
+c_ast_expression *c_fold_expression(c_fold_context *context,
+                                    c_ast_expression *expression) {
+    if (!expression || expression->type != C_BINARY_EXPRESSION) {
+        return expression;
+    }
+
+    c_ast_binary_expression *binary = expression->binary;
+    binary->lhs = c_fold_expression(context, binary->lhs);
+    binary->rhs = c_fold_expression(context, binary->rhs);
+
+    c_ast_expression *lhs = binary->lhs;
+    c_ast_expression *rhs = binary->rhs;
+
+    if (binary->symbol == '/' && c_fold_is_constant(rhs, 0)) {
+        c_warning_report(context->error_context,
+                         "division by zero",
+                         context->filename,
+                         binary->line,
+                         binary->column);
+        return expression;
+    }
+
+    if (lhs->type == C_CONSTANT && rhs->type == C_CONSTANT) {
+        int result;
+
+        if (c_fold_evaluate(binary->symbol,
+                            lhs->constant->value,
+                            rhs->constant->value,
+                            &result)) {
+            return c_fold_replace_with_constant(context, expression, result);
+        }
+
+        return expression;
+    }
+
+    switch (binary->symbol) {
+        case '+':
+            if (c_fold_is_constant(rhs, 0)) {
+                return c_fold_keep_operand(context, expression, 1);
+            }
+            if (c_fold_is_constant(lhs, 0)) {
+                return c_fold_keep_operand(context, expression, 0);
+            }
+            break;
+        case '-':
+            if (c_fold_is_constant(rhs, 0)) {
+                return c_fold_keep_operand(context, expression, 1);
+            }
+            if (c_fold_is_pure(lhs) && c_fold_expressions_equal(lhs, rhs)) {
+                return c_fold_replace_with_constant(context, expression, 0);
+            }
+            break;
+        case '*':
+            if (c_fold_is_constant(rhs, 1)) {
+                return c_fold_keep_operand(context, expression, 1);
+            }
+            if (c_fold_is_constant(lhs, 1)) {
+                return c_fold_keep_operand(context, expression, 0);
+            }
+            // NOTE: calls still have to run
+            if ((c_fold_is_constant(rhs, 0) && c_fold_is_pure(lhs))
+                || (c_fold_is_constant(lhs, 0) && c_fold_is_pure(rhs))) {
+                return c_fold_replace_with_constant(context, expression, 0);
+            }
+            break;
+        case '/':
+            if (c_fold_is_constant(rhs, 1)) {
+                return c_fold_keep_operand(context, expression, 1);
+            }
+            break;
+        default:
+            break;
+    }
+
+    return c_fold_reassociate(context, expression);
+}
+
+static void c_fold_statement(c_fold_context *context,
+                             c_ast_statement *statement) {
+    switch (statement->type) {
+        case C_STATEMENT_BLOCK:
+            c_fold_block(context, statement->block);
+            break;
+        case C_STATEMENT_RETURN:
+            statement->return_statement->value = c_fold_expression(
+                context, statement->return_statement->value);
+            break;
+        case C_STATEMENT_FUNCTION_DECLARATION:
+            c_fold_block(context, statement->function_declaration->body);
+            break;
+        case C_STATEMENT_EXPRESSION:
+            statement->expression =
+                c_fold_expression(context, statement->expression);
+            break;
+        case C_STATEMENT_ASSIGNMENT:
+            statement->assignment->expression = c_fold_expression(
+                context, statement->assignment->expression);
+            break;
+        case C_STATEMENT_NOOP:
+            break;
+        default:
+            EXIT_WITH_ERROR("Got unsupported type for statement fold: %d\n",
+                            statement->type);
+    }
+}
+
+void c_fold_block(c_fold_context *context, c_ast_block *block) {
+    for (int i = 0; i < arrlen(block->statements); i++) {
+        c_fold_statement(context, block->statements[i]);
+    }
+}
+
+int c_fold_program(c_ast_program *program,
+                   c_error_context *error_context,
+                   const char *filename) {
+    c_fold_context context = {.error_context = error_context,
+                              .filename = filename,
+                              .folded = 0};
+
+    for (int i = 0; i < arrlen(program->function_declarations); i++) {
+        c_fold_block(&context, program->function_declarations[i]->body);
+    }
+
+    return context.folded;
+}
@@ -0,0 +1,278 @@
+#include "dead_code.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stb_ds.h"
+#include "utils.h"
+
+#define BITS_PER_WORD 64
+
+typedef struct {
+    int words;
+    // NOTE: one set of allocas per block, words each
+    uint64_t *gen;
+    uint64_t *kill;
+    uint64_t *live_in;
+    uint64_t *live_out;
+} c_dead_liveness;
+
+static int c_dead_test(uint64_t *set, int index) {
+    return (set[index / BITS_PER_WORD] >> (index % BITS_PER_WORD)) & 1;
+}
+
+static void c_dead_set(uint64_t *set, int index) {
+    set[index / BITS_PER_WORD] |= (uint64_t)1 << (index % BITS_PER_WORD);
+}
+
+static void c_dead_clear(uint64_t *set, int index) {
+    set[index / BITS_PER_WORD] &= ~((uint64_t)1 << (index % BITS_PER_WORD));
+}
+
+static uint64_t *c_dead_sets(int blocks, int words) {
+    uint64_t *sets = calloc((size_t)(blocks ? blocks : 1) * words,
+                            sizeof(uint64_t));
+
+    if (!sets) {
+        EXIT_WITH_ERROR("Failed to allocate memory for liveness sets\n");
+    }
+
+    return sets;
+}
+
+// NOTE: removes every marked value with one pass over each block
+static int c_dead_sweep(c_ir_function *function, int *dead) {
+    int removed = 0;
+
+    for (int b = 0; b < arrlen(function->blocks); b++) {
+        int *instructions = function->blocks[b].instructions;
+        int kept = 0;
+
+        for (int i = 0; i < arrlen(instructions); i++) {
+            int value = instructions[i];
+
+            if (!dead[value]) {
+                instructions[kept++] = value;
+                continue;
+            }
+
+            arrfree(function->instructions[value].phi_operands);
+            function->instructions[value].opcode = C_IR_NOP;
+            removed++;
+        }
+
+        if (instructions) {
+            arrsetlen(function->blocks[b].instructions, (size_t)kept);
+        }
+    }
+
+    return removed;
+}
+
+static void c_dead_compute_liveness(c_ir_function *function,
+                                    int *alloca_index,
+                                    c_dead_liveness *liveness) {
+    int blocks = (int)arrlen(function->blocks);
+    int words = liveness->words;
+
+    for (int b = 0; b < blocks; b++) {
+        int *instructions = function->blocks[b].instructions;
+        uint64_t *gen = &liveness->gen[b * words];
+        uint64_t *kill = &liveness->kill[b * words];
+
+        for (int i = 0; i < arrlen(instructions); i++) {
+            c_ir_instruction *instruction =
+                &function->instructions[instructions[i]];
+            int index;
+
+            switch (instruction->opcode) {
+                case C_IR_LOAD:
+                    index = alloca_index[instruction->operands[0]];
+
+                    if (!c_dead_test(kill, index)) {
+                        c_dead_set(gen, index);
+                    }
+                    break;
+                case C_IR_STORE:
+                    c_dead_set(kill, alloca_index[instruction->operands[0]]);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    // NOTE: blocks are mostly laid out forward, visiting them
+    // backward settles most sets in the first round
+    int changed = 1;
+
+    while (changed) {
+        changed = 0;
+
+        for (int b = blocks - 1; b >= 0; b--) {
+            uint64_t *live_in = &liveness->live_in[b * words];
+            uint64_t *live_out = &liveness->live_out[b * words];
+            int *successors = function->blocks[b].successors;
+
+            for (int s = 0; s < arrlen(successors); s++) {
+                uint64_t *successor_in =
+                    &liveness->live_in[successors[s] * words];
+
+                for (int w = 0; w < words; w++) {
+                    live_out[w] |= successor_in[w];
+                }
+            }
+
+            for (int w = 0; w < words; w++) {
+                uint64_t in = liveness->gen[b * words + w]
+                              | (live_out[w] & ~liveness->kill[b * words + w]);
+
+                if (in != live_in[w]) {
+                    live_in[w] = in;
+                    changed = 1;
+                }
+            }
+        }
+    }
+}
+
+int c_dead_store_eliminate(c_ir_function *function) {
+    int count = (int)arrlen(function->instructions);
+    int blocks = (int)arrlen(function->blocks);
+    int *alloca_index = malloc((count ? count : 1) * sizeof(int));
+    int *dead = calloc(count ? count : 1, sizeof(int));
+    int allocas = 0;
+
+    if (!alloca_index || !dead) {
+        EXIT_WITH_ERROR("Failed to allocate memory for dead stores\n");
+    }
+
+    for (int v = 0; v < count; v++) {
+        alloca_index[v] = function->instructions[v].opcode == C_IR_ALLOCA
+                              ? allocas++
+                              : -1;
+    }
+
+    if (allocas == 0) {
+        free(alloca_index);
+        free(dead);
+        return 0;
+    }
+
+    c_dead_liveness liveness = {
+        .words = (allocas + BITS_PER_WORD - 1) / BITS_PER_WORD};
+    liveness.gen = c_dead_sets(blocks, liveness.words);
+    liveness.kill = c_dead_sets(blocks, liveness.words);
+    liveness.live_in = c_dead_sets(blocks, liveness.words);
+    liveness.live_out = c_dead_sets(blocks, liveness.words);
+
+    c_dead_compute_liveness(function, alloca_index, &liveness);
+
+    uint64_t *live = c_dead_sets(1, liveness.words);
+
+    for (int b = 0; b < blocks; b++) {
+        int *instructions = function->blocks[b].instructions;
+
+        memcpy(live,
+               &liveness.live_out[b * liveness.words],
+               liveness.words * sizeof(uint64_t));
+
+        for (int i = (int)arrlen(instructions) - 1; i >= 0; i--) {
+            c_ir_instruction *instruction =
+                &function->instructions[instructions[i]];
+
+            if (instruction->opcode == C_IR_LOAD) {
+                c_dead_set(live, alloca_index[instruction->operands[0]]);
+            } else if (instruction->opcode == C_IR_STORE) {
+                int index = alloca_index[instruction->operands[0]];
+
+                if (!c_dead_test(live, index)) {
+                    dead[instructions[i]] = 1;
+                }
+
+                c_dead_clear(live, index);
+            }
+        }
+    }
+
+    int removed = c_dead_sweep(function, dead);
+
+    free(live);
+    free(liveness.gen);
+    free(liveness.kill);
+    free(liveness.live_in);
+    free(liveness.live_out);
+    free(alloca_index);
+    free(dead);
+
+    return removed;
+}
+
+static int c_dead_is_root(c_ir_opcode opcode) {
+    return opcode == C_IR_CALL || opcode == C_IR_STORE
+           || c_ir_is_terminator(opcode);
+}
+
+static void c_dead_mark(int *live, int **worklist, int value) {
+    if (value == C_IR_NO_VALUE || live[value]) {
+        return;
+    }
+
+    live[value] = 1;
+    arrput(*worklist, value);
+}
+
+int c_dead_code_eliminate(c_ir_function *function) {
+    int count = (int)arrlen(function->instructions);
+    int *live = calloc(count ? count : 1, sizeof(int));
+    int *worklist = NULL;
+
+    if (!live) {
+        EXIT_WITH_ERROR("Failed to allocate memory for dead code\n");
+    }
+
+    for (int b = 0; b < arrlen(function->blocks); b++) {
+        int *instructions = function->blocks[b].instructions;
+
+        for (int i = 0; i < arrlen(instructions); i++) {
+            int value = instructions[i];
+
+            if (c_dead_is_root(function->instructions[value].opcode)) {
+                c_dead_mark(live, &worklist, value);
+            }
+        }
+    }
+
+    while (arrlen(worklist) > 0) {
+        int value = arrlast(worklist);
+        arrsetlen(worklist, arrlenu(worklist) - 1);
+
+        c_ir_instruction *instruction = &function->instructions[value];
+        int operands[2];
+        int operands_count = c_ir_value_operands(instruction, operands);
+
+        for (int o = 0; o < operands_count; o++) {
+            c_dead_mark(live, &worklist, operands[o]);
+        }
+
+        for (int p = 0; p < arrlen(instruction->phi_operands); p++) {
+            c_dead_mark(live, &worklist, instruction->phi_operands[p].value);
+        }
+
+        // NOTE: the alloca a load or store goes through
+        if (instruction->opcode == C_IR_LOAD
+            || instruction->opcode == C_IR_STORE) {
+            c_dead_mark(live, &worklist, instruction->operands[0]);
+        }
+    }
+
+    for (int v = 0; v < count; v++) {
+        live[v] = !live[v];
+    }
+
+    int removed = c_dead_sweep(function, live);
+
+    arrfree(worklist);
+    free(live);
+
+    return removed;
+}
@@ -0,0 +1,293 @@
+#include "elf64.h"
+#include <string.h>
+#include "stb_ds.h"
+
+// NOTE: .text, .symtab, .strtab, .rela.text, .shstrtab after the null one
+#define C_ELF64_TEXT_INDEX 1
+#define C_ELF64_SYMTAB_INDEX 2
+#define C_ELF64_STRTAB_INDEX 3
+#define C_ELF64_RELA_INDEX 4
+#define C_ELF64_SHSTRTAB_INDEX 5
+#define C_ELF64_SECTIONS_COUNT 6
+
+typedef struct {
+    uint32_t name;
+    uint32_t type;
+    uint64_t flags;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t link;
+    uint32_t info;
+    uint64_t alignment;
+    uint64_t entry_size;
+} c_elf64_section;
+
+void c_elf64_put16(uint8_t **bytes, uint16_t value) {
+    for (int i = 0; i < 2; i++) {
+        arrput(*bytes, (uint8_t)(value >> (8 * i)));
+    }
+}
+
+void c_elf64_put32(uint8_t **bytes, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        arrput(*bytes, (uint8_t)(value >> (8 * i)));
+    }
+}
+
+void c_elf64_put64(uint8_t **bytes, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        arrput(*bytes, (uint8_t)(value >> (8 * i)));
+    }
+}
+
+uint32_t c_elf64_add_string(uint8_t **table, const char *string) {
+    uint32_t offset = (uint32_t)arrlen(*table);
+
+    for (const char *c = string; *c; c++) {
+        arrput(*table, (uint8_t)*c);
+    }
+    arrput(*table, 0);
+
+    return offset;
+}
+
+void c_elf64_align(uint8_t **bytes, int alignment) {
+    while (arrlen(*bytes) % alignment != 0) {
+        arrput(*bytes, 0);
+    }
+}
+
+static void c_elf64_append(uint8_t **bytes, uint8_t *data) {
+    for (int i = 0; i < arrlen(data); i++) {
+        arrput(*bytes, data[i]);
+    }
+}
+
+static void c_elf64_put_symbol(uint8_t **bytes,
+                               uint32_t name,
+                               int binding,
+                               int type,
+                               uint16_t section,
+                               uint64_t value) {
+    c_elf64_put32(bytes, name);
+    arrput(*bytes, (uint8_t)(binding << 4 | type));
+    arrput(*bytes, 0);
+    c_elf64_put16(bytes, section);
+    c_elf64_put64(bytes, value);
+    c_elf64_put64(bytes, 0);
+}
+
+static void c_elf64_put_section(uint8_t **bytes, c_elf64_section *section) {
+    c_elf64_put32(bytes, section->name);
+    c_elf64_put32(bytes, section->type);
+    c_elf64_put64(bytes, section->flags);
+    c_elf64_put64(bytes, 0);
+    c_elf64_put64(bytes, section->offset);
+    c_elf64_put64(bytes, section->size);
+    c_elf64_put32(bytes, section->link);
+    c_elf64_put32(bytes, section->info);
+    c_elf64_put64(bytes, section->alignment);
+    c_elf64_put64(bytes, section->entry_size);
+}
+
+static void c_elf64_put_header(uint8_t **bytes,
+                               uint16_t type,
+                               uint64_t entry,
+                               uint64_t program_headers,
+                               uint16_t program_headers_count,
+                               uint64_t section_headers,
+                               uint16_t sections_count,
+                               uint16_t section_names_index) {
+    static const uint8_t identification[16] = {
+        0x7f, 'E', 'L', 'F', 2, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    };
+
+    for (int i = 0; i < 16; i++) {
+        arrput(*bytes, identification[i]);
+    }
+
+    c_elf64_put16(bytes, type);
+    c_elf64_put16(bytes, C_ELF64_EM_X86_64);
+    c_elf64_put32(bytes, 1);
+    c_elf64_put64(bytes, entry);
+    c_elf64_put64(bytes, program_headers);
+    c_elf64_put64(bytes, section_headers);
+    c_elf64_put32(bytes, 0);
+    c_elf64_put16(bytes, C_ELF64_HEADER_SIZE);
+    c_elf64_put16(bytes,
+                  program_headers_count ? C_ELF64_PROGRAM_HEADER_SIZE : 0);
+    c_elf64_put16(bytes, program_headers_count);
+    c_elf64_put16(bytes, sections_count ? C_ELF64_SECTION_HEADER_SIZE : 0);
+    c_elf64_put16(bytes, sections_count);
+    c_elf64_put16(bytes, section_names_index);
+}
+
+uint64_t c_elf64_executable_text_offset(void) {
+    return (C_ELF64_HEADER_SIZE + C_ELF64_PROGRAM_HEADER_SIZE + 15) / 16 * 16;
+}
+
+uint8_t *c_elf64_write_executable(uint8_t *text,
+                                  uint64_t base,
+                                  uint64_t entry) {
+    uint8_t *bytes = NULL;
+    uint64_t text_offset = c_elf64_executable_text_offset();
+    uint64_t size = text_offset + arrlen(text);
+
+    c_elf64_put_header(
+        &bytes, C_ELF64_ET_EXEC, entry, C_ELF64_HEADER_SIZE, 1, 0, 0, 0);
+
+    c_elf64_put32(&bytes, C_ELF64_PT_LOAD);
+    c_elf64_put32(&bytes, C_ELF64_PF_R | C_ELF64_PF_X);
+    c_elf64_put64(&bytes, 0);
+    c_elf64_put64(&bytes, base);
+    c_elf64_put64(&bytes, base);
+    c_elf64_put64(&bytes, size);
+    c_elf64_put64(&bytes, size);
+    c_elf64_put64(&bytes, 0x1000);
+
+    c_elf64_align(&bytes, 16);
+    c_elf64_append(&bytes, text);
+
+    return bytes;
+}
+
+uint8_t *c_elf64_write_relocatable(c_asm_object *object) {
+    uint8_t *symbols = NULL;
+    uint8_t *strings = NULL;
+    uint8_t *relocations = NULL;
+    uint8_t *section_names = NULL;
+    int *symbol_index = NULL;
+
+    c_elf64_add_string(&strings, "");
+    c_elf64_put_symbol(&symbols, 0, 0, 0, 0, 0);
+    c_elf64_put_symbol(&symbols,
+                       0,
+                       C_ELF64_STB_LOCAL,
+                       C_ELF64_STT_SECTION,
+                       C_ELF64_TEXT_INDEX,
+                       0);
+
+    for (int i = 0; i < arrlen(object->symbols); i++) {
+        arrput(symbol_index, 0);
+    }
+
+    // NOTE: the symbol table lists every local before the first global
+    int next = 2;
+    int first_global = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            first_global = next;
+        }
+
+        for (int i = 0; i < arrlen(object->symbols); i++) {
+            c_asm_symbol *symbol = &object->symbols[i];
+
+            if (symbol->is_global != pass) {
+                continue;
+            }
+
+            c_elf64_put_symbol(
+                &symbols,
+                c_elf64_add_string(&strings, symbol->name),
+                symbol->is_global ? C_ELF64_STB_GLOBAL : C_ELF64_STB_LOCAL,
+                C_ELF64_STT_NOTYPE,
+                symbol->is_defined ? C_ELF64_TEXT_INDEX : 0,
+                symbol->is_defined ? (uint64_t)symbol->offset : 0);
+            symbol_index[i] = next++;
+        }
+    }
+
+    for (int i = 0; i < arrlen(object->relocations); i++) {
+        c_asm_relocation *relocation = &object->relocations[i];
+
+        c_elf64_put64(&relocations, (uint64_t)relocation->offset);
+        c_elf64_put64(&relocations,
+                      (uint64_t)symbol_index[relocation->symbol] << 32
+                          | C_ELF64_R_X86_64_PLT32);
+        c_elf64_put64(&relocations, (uint64_t)relocation->addend);
+    }
+
+    c_elf64_section sections[C_ELF64_SECTIONS_COUNT];
+    memset(sections, 0, sizeof(sections));
+    c_elf64_add_string(&section_names, "");
+
+    sections[C_ELF64_TEXT_INDEX] = (c_elf64_section){
+        .name = c_elf64_add_string(&section_names, ".text"),
+        .type = C_ELF64_SHT_PROGBITS,
+        .flags = C_ELF64_SHF_ALLOC | C_ELF64_SHF_EXECINSTR,
+        .size = arrlen(object->text),
+        .alignment = 16,
+    };
+    sections[C_ELF64_SYMTAB_INDEX] = (c_elf64_section){
+        .name = c_elf64_add_string(&section_names, ".symtab"),
+        .type = C_ELF64_SHT_SYMTAB,
+        .size = arrlen(symbols),
+        .link = C_ELF64_STRTAB_INDEX,
+        .info = first_global,
+        .alignment = 8,
+        .entry_size = C_ELF64_SYMBOL_SIZE,
+    };
+    sections[C_ELF64_STRTAB_INDEX] = (c_elf64_section){
+        .name = c_elf64_add_string(&section_names, ".strtab"),
+        .type = C_ELF64_SHT_STRTAB,
+        .size = arrlen(strings),
+        .alignment = 1,
+    };
+    sections[C_ELF64_RELA_INDEX] = (c_elf64_section){
+        .name = c_elf64_add_string(&section_names, ".rela.text"),
+        .type = C_ELF64_SHT_RELA,
+        .flags = C_ELF64_SHF_INFO_LINK,
+        .size = arrlen(relocations),
+        .link = C_ELF64_SYMTAB_INDEX,
+        .info = C_ELF64_TEXT_INDEX,
+        .alignment = 8,
+        .entry_size = C_ELF64_RELA_SIZE,
+    };
+    sections[C_ELF64_SHSTRTAB_INDEX] = (c_elf64_section){
+        .name = c_elf64_add_string(&section_names, ".shstrtab"),
+        .type = C_ELF64_SHT_STRTAB,
+        .size = arrlen(section_names),
+        .alignment = 1,
+    };
+
+    uint8_t *contents = NULL;
+    uint8_t *data[C_ELF64_SECTIONS_COUNT] = {
+        NULL, object->text, symbols, strings, relocations, section_names,
+    };
+
+    for (int i = C_ELF64_TEXT_INDEX; i < C_ELF64_SECTIONS_COUNT; i++) {
+        // NOTE: offsets are relative to the end of the elf header
+        c_elf64_align(&contents, (int)sections[i].alignment);
+        sections[i].offset = C_ELF64_HEADER_SIZE + arrlen(contents);
+        c_elf64_append(&contents, data[i]);
+    }
+
+    c_elf64_align(&contents, 8);
+    uint64_t section_headers = C_ELF64_HEADER_SIZE + arrlen(contents);
+
+    uint8_t *bytes = NULL;
+    c_elf64_put_header(&bytes,
+                       C_ELF64_ET_REL,
+                       0,
+                       0,
+                       0,
+                       section_headers,
+                       C_ELF64_SECTIONS_COUNT,
+                       C_ELF64_SHSTRTAB_INDEX);
+
+    c_elf64_append(&bytes, contents);
+
+    for (int i = 0; i < C_ELF64_SECTIONS_COUNT; i++) {
+        c_elf64_put_section(&bytes, &sections[i]);
+    }
+
+    arrfree(contents);
+    arrfree(symbols);
+    arrfree(strings);
+    arrfree(relocations);
+    arrfree(section_names);
+    arrfree(symbol_index);
+
+    return bytes;
+}
@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 c_error_context *c_error_context_create(void) {
     c_error_context *context = malloc(sizeof(c_error_context));
@@ -54,6 +55,27 @@ void c_error_report(c_error_context *ctx,
     error->column = column;
 }
 
+void c_warning_report(c_error_context *ctx,
+                      const char *message,
+                      const char *filename,
+                      int line,
+                      int column) {
+    // NOTE: a pass may visit the same code more than once, the
+    // warning is kept once per location and message
+    for (int i = 0; i < arrlen(ctx->errors); i++) {
+        c_error *error = &ctx->errors[i];
+
+        if (error->severity == C_SEVERITY_WARNING && error->line == line
+            && error->column == column && strcmp(error->filename, filename) == 0
+            && strcmp(error->message, message) == 0) {
+            return;
+        }
+    }
+
+    c_error_report(ctx, message, filename, line, column);
+    ctx->errors[arrlen(ctx->errors) - 1].severity = C_SEVERITY_WARNING;
+}
+
 void c_error_report_with_token(c_error_context *ctx,
                                const char *message,
                                c_token token,
@@ -84,14 +106,21 @@ void c_error_context_print(c_error_context *ctx, FILE *output) {
         c_error *error = &ctx->errors[i];
 
         fprintf(output,
-                "%s:%d:%d: error: %s\n",
+                "%s:%d:%d: %s: %s\n",
                 error->filename,
                 error->line,
                 error->column,
+                error->severity == C_SEVERITY_WARNING ? "warning" : "error",
                 error->message);
     }
 }
 
 int c_error_context_has_errors(c_error_context *ctx) {
-    return arrlen(ctx->errors) > 0;
+    for (int i = 0; i < arrlen(ctx->errors); i++) {
+        if (ctx->errors[i].severity == C_SEVERITY_ERROR) {
+            return 1;
+        }
+    }
+
+    return 0;
 }
@@ -0,0 +1,228 @@
+#include "evaluator.h"
+#include <stdlib.h>
+#include <string.h>
+#include "call_rewrite.h"
+#include "constant_folding.h"
+#include "stb_ds.h"
+#include "utils.h"
+
+typedef enum {
+    C_EVAL_NEXT,
+    C_EVAL_RETURNED,
+    C_EVAL_STOPPED,
+} c_eval_flow;
+
+static int c_eval_step(c_eval_context *context) {
+    return ++context->steps <= C_EVAL_MAX_STEPS;
+}
+
+static int c_eval_expression(c_eval_context *context,
+                             int frame,
+                             c_ast_expression *expression,
+                             int *value) {
+    if (!c_eval_step(context)) {
+        return 0;
+    }
+
+    switch (expression->type) {
+        case C_CONSTANT:
+            *value = expression->constant->value;
+            return 1;
+        case C_VARIABLE:
+            for (int i = (int)arrlen(context->locals) - 1; i >= frame; i--) {
+                if (strcmp(context->locals[i].name, expression->variable->name)
+                    == 0) {
+                    *value = context->locals[i].value;
+                    return 1;
+                }
+            }
+
+            // NOTE: undeclared, left for the later passes to report
+            return 0;
+        case C_FUNCTION_CALL:
+            return c_eval_function_value(
+                context, expression->function_call->function_name, value);
+        case C_BINARY_EXPRESSION: {
+            int lhs;
+            int rhs;
+
+            if (!c_eval_expression(
+                    context, frame, expression->binary->lhs, &lhs)
+                || !c_eval_expression(
+                    context, frame, expression->binary->rhs, &rhs)) {
+                return 0;
+            }
+
+            return c_fold_evaluate(expression->binary->symbol, lhs, rhs, value);
+        }
+        default:
+            return 0;
+    }
+}
+
+static c_eval_flow c_eval_block(c_eval_context *context,
+                                int frame,
+                                c_ast_block *block,
+                                int *value) {
+    int start = (int)arrlen(context->locals);
+    c_eval_flow flow = C_EVAL_NEXT;
+
+    for (int i = 0; i < arrlen(block->statements) && flow == C_EVAL_NEXT;
+         i++) {
+        c_ast_statement *statement = block->statements[i];
+        int result;
+
+        if (!c_eval_step(context)) {
+            flow = C_EVAL_STOPPED;
+            break;
+        }
+
+        switch (statement->type) {
+            case C_STATEMENT_ASSIGNMENT: {
+                if (arrlen(context->locals) >= C_EVAL_MAX_LOCALS
+                    || !c_eval_expression(context,
+                                          frame,
+                                          statement->assignment->expression,
+                                          &result)) {
+                    flow = C_EVAL_STOPPED;
+                    break;
+                }
+
+                c_eval_local local = {statement->assignment->variable_name,
+                                      result};
+                arrput(context->locals, local);
+                break;
+            }
+            case C_STATEMENT_EXPRESSION:
+                if (!c_eval_expression(
+                        context, frame, statement->expression, &result)) {
+                    flow = C_EVAL_STOPPED;
+                }
+                break;
+            case C_STATEMENT_RETURN:
+                // NOTE: the caller would read whatever is left in eax
+                if (!statement->return_statement->value
+                    || !c_eval_expression(context,
+                                          frame,
+                                          statement->return_statement->value,
+                                          value)) {
+                    flow = C_EVAL_STOPPED;
+                    break;
+                }
+
+                flow = C_EVAL_RETURNED;
+                break;
+            case C_STATEMENT_BLOCK:
+                flow = c_eval_block(context, frame, statement->block, value);
+                break;
+            case C_STATEMENT_NOOP:
+                break;
+            default:
+                flow = C_EVAL_STOPPED;
+                break;
+        }
+    }
+
+    arrsetlen(context->locals, (size_t)start);
+
+    return flow;
+}
+
+int c_eval_function_value(c_eval_context *context,
+                          const char *name,
+                          int *value) {
+    int index = c_call_find_function(context->program, name);
+
+    // NOTE: defined elsewhere, it may do anything
+    if (index == -1) {
+        return 0;
+    }
+
+    c_eval_function *function = &context->functions[index];
+
+    switch (function->state) {
+        case C_EVAL_CONSTANT:
+            *value = function->value;
+            return 1;
+        case C_EVAL_RUNNING:
+        case C_EVAL_FAILED:
+            return 0;
+        default:
+            break;
+    }
+
+    // NOTE: left unknown, a shallower caller may still finish it
+    if (context->depth >= C_EVAL_MAX_DEPTH) {
+        return 0;
+    }
+
+    // NOTE: so one expensive function does not use up the budget of
+    // every call site after it
+    if (context->depth == 0) {
+        context->steps = 0;
+    }
+
+    int result;
+
+    function->state = C_EVAL_RUNNING;
+    context->depth++;
+
+    c_eval_flow flow = c_eval_block(context,
+                                    (int)arrlen(context->locals),
+                                    function->declaration->body,
+                                    &result);
+
+    context->depth--;
+
+    if (flow != C_EVAL_RETURNED) {
+        function->state = C_EVAL_FAILED;
+        return 0;
+    }
+
+    function->state = C_EVAL_CONSTANT;
+    function->value = result;
+    *value = result;
+
+    return 1;
+}
+
+static int c_eval_value_for_call(void *context, const char *name, int *value) {
+    return c_eval_function_value(context, name, value);
+}
+
+static void c_eval_free_call(void *context, c_ast_expression *call) {
+    c_eval_context *eval = context;
+    eval->replaced++;
+    c_ast_free_expression(call);
+}
+
+int c_eval_program(c_ast_program *program) {
+    c_eval_context context = {0};
+    context.program = program;
+    c_call_rewriter rewriter = {
+        .context = &context,
+        .value_for_call = c_eval_value_for_call,
+        .replaced = c_eval_free_call,
+        .rewritten = NULL,
+        .keep_call_statements = 0,
+    };
+
+    for (int i = 0; i < arrlen(program->function_declarations); i++) {
+        c_eval_function function = {
+            .declaration = program->function_declarations[i],
+            .state = C_EVAL_UNKNOWN,
+            .value = 0,
+        };
+        arrput(context.functions, function);
+    }
+
+    for (int i = 0; i < arrlen(program->function_declarations); i++) {
+        c_call_rewrite_block(&rewriter,
+                             program->function_declarations[i]->body);
+    }
+
+    arrfree(context.functions);
+    arrfree(context.locals);
+
+    return context.replaced;
+}
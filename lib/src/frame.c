@@ -0,0 +1,159 @@
+#include "frame.h"
+#include <stdlib.h>
+#include "ir.h"
+#include "register_allocator.h"
+#include "stb_ds.h"
+#include "utils.h"
+
+static int c_frame_align(int value, int alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static void c_frame_add_slot(c_frame_layout *frame,
+                             int value,
+                             int size,
+                             int alignment) {
+    c_frame_slot slot = {
+        .value = value, .size = size, .alignment = alignment, .offset = 0};
+    frame->slot_of[value] = (int)arrlen(frame->slots);
+    arrput(frame->slots, slot);
+}
+
+// NOTE: biggest alignment first so no padding is needed between slots
+static int c_frame_compare_slots(const void *a, const void *b) {
+    const c_frame_slot *lhs = a;
+    const c_frame_slot *rhs = b;
+
+    if (lhs->alignment != rhs->alignment) {
+        return rhs->alignment - lhs->alignment;
+    }
+
+    return lhs->value - rhs->value;
+}
+
+c_frame_layout *c_frame_layout_create(c_ir_function *function,
+                                      c_register_allocation *allocation,
+                                      int omit_frame_pointer,
+                                      int tail_calls) {
+    c_frame_layout *frame = malloc(sizeof(c_frame_layout));
+
+    if (!frame) {
+        EXIT_WITH_ERROR("Failed to allocate memory for frame layout\n");
+    }
+
+    frame->slots = NULL;
+    frame->slot_of = NULL;
+    frame->saved_size =
+        (int)arrlen(allocation->saved_registers) * C_FRAME_PUSH_SIZE;
+    frame->locals_size = 0;
+    frame->allocation_size = 0;
+    frame->has_calls = 0;
+    frame->omit_frame_pointer = omit_frame_pointer;
+    frame->uses_red_zone = 0;
+
+    for (int v = 0; v < arrlen(function->instructions); v++) {
+        arrput(frame->slot_of, -1);
+    }
+
+    int *use_counts = c_ir_use_counts(function);
+
+    for (int b = 0; b < arrlen(function->blocks); b++) {
+        int *instructions = function->blocks[b].instructions;
+
+        for (int i = 0; i < arrlen(instructions); i++) {
+            int value = instructions[i];
+            c_ir_instruction *instruction = &function->instructions[value];
+            int size = c_ir_type_size(instruction->type);
+
+            if (instruction->opcode == C_IR_ALLOCA) {
+                c_frame_add_slot(frame, value, size, size);
+            } else if (instruction->opcode == C_IR_CALL
+                       && !(tail_calls
+                            && c_ir_is_tail_call(function, value, use_counts))) {
+                // NOTE: a tail call leaves with the frame already gone
+                frame->has_calls = 1;
+            }
+        }
+    }
+
+    arrfree(use_counts);
+
+    // NOTE: spill slots are as wide as the spilled value
+    for (int i = 0; i < arrlen(allocation->intervals); i++) {
+        if (allocation->intervals[i].reg == C_X86_NO_REGISTER) {
+            int value = allocation->intervals[i].value;
+            int size = c_ir_type_size(function->instructions[value].type);
+
+            c_frame_add_slot(frame, value, size, size);
+        }
+    }
+
+    if (arrlen(frame->slots) > 0) {
+        qsort(frame->slots,
+              arrlen(frame->slots),
+              sizeof(c_frame_slot),
+              c_frame_compare_slots);
+    }
+
+    int offset = frame->saved_size;
+
+    for (int i = 0; i < arrlen(frame->slots); i++) {
+        c_frame_slot *slot = &frame->slots[i];
+
+        offset = c_frame_align(offset + slot->size, slot->alignment);
+        slot->offset = offset;
+        frame->slot_of[slot->value] = i;
+    }
+
+    frame->locals_size = offset - frame->saved_size;
+    frame->allocation_size = frame->locals_size;
+
+    // NOTE: System V wants rsp 16 byte aligned at every call, the return
+    // address misaligns it by 8 and push rbp realigns it
+    int pushed = frame->saved_size + (omit_frame_pointer ? 8 : 0);
+
+    if (frame->has_calls) {
+        frame->allocation_size =
+            c_frame_align(pushed + frame->locals_size, C_FRAME_STACK_ALIGNMENT)
+            - pushed;
+    } else if (omit_frame_pointer
+               && frame->locals_size <= C_FRAME_RED_ZONE_SIZE) {
+        frame->uses_red_zone = 1;
+        frame->allocation_size = 0;
+    }
+
+    return frame;
+}
+
+c_frame_slot *c_frame_slot_of(c_frame_layout *frame, int value) {
+    if (value < 0 || value >= arrlen(frame->slot_of)
+        || frame->slot_of[value] == -1) {
+        return NULL;
+    }
+
+    return &frame->slots[frame->slot_of[value]];
+}
+
+c_x86_register c_frame_base_register(c_frame_layout *frame) {
+    return frame->omit_frame_pointer ? C_X86_RSP : C_X86_RBP;
+}
+
+int c_frame_displacement(c_frame_layout *frame, c_frame_slot *slot) {
+    if (!frame->omit_frame_pointer) {
+        return -slot->offset;
+    }
+
+    // NOTE: rsp sits allocation_size below the slots area, which
+    // itself starts below the pushed registers
+    return frame->allocation_size + frame->saved_size - slot->offset;
+}
+
+void c_frame_layout_free(c_frame_layout *frame) {
+    if (!frame) {
+        return;
+    }
+
+    arrfree(frame->slots);
+    arrfree(frame->slot_of);
+    free(frame);
+}
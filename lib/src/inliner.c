@@ -0,0 +1,455 @@
+#include "inliner.h"
+#include <stdlib.h>
+#include <string.h>
+#include "call_rewrite.h"
+#include "constant_folding.h"
+#include "stb_ds.h"
+#include "str.h"
+#include "utils.h"
+
+typedef struct {
+    char *name;
+    c_ast_expression *expression;
+    int uses;
+} c_inline_binding;
+
+typedef struct {
+    c_inline_binding *bindings;
+    c_ast_expression *result;
+    // NOTE: nodes built so far, locals used more than once are
+    // copied per use and can grow a summary exponentially
+    int size;
+    // NOTE: calls in the body, a local holding one moves it into
+    // the result whose operands are evaluated in any order
+    int calls;
+    int moves_call;
+    int failed;
+} c_inline_summary_context;
+
+c_ast_expression *c_inline_copy_expression(c_ast_expression *expression) {
+    c_ast_expression *copy = malloc(sizeof(c_ast_expression));
+
+    if (!copy) {
+        EXIT_WITH_ERROR("Failed to allocate memory for expression copy\n");
+    }
+
+    copy->type = expression->type;
+
+    switch (expression->type) {
+        case C_CONSTANT:
+            copy->constant = malloc(sizeof(c_ast_constant));
+            *copy->constant = *expression->constant;
+            break;
+        case C_FUNCTION_CALL:
+            copy->function_call = malloc(sizeof(c_ast_function_call));
+            copy->function_call->function_name =
+                strdup(expression->function_call->function_name);
+            break;
+        case C_VARIABLE:
+            copy->variable = malloc(sizeof(c_ast_variable));
+            copy->variable->name = strdup(expression->variable->name);
+            break;
+        case C_BINARY_EXPRESSION:
+            copy->binary = malloc(sizeof(c_ast_binary_expression));
+            *copy->binary = *expression->binary;
+            copy->binary->lhs =
+                c_inline_copy_expression(expression->binary->lhs);
+            copy->binary->rhs =
+                c_inline_copy_expression(expression->binary->rhs);
+            break;
+        default:
+            EXIT_WITH_ERROR("Got unknown expression to copy: %d\n",
+                            expression->type);
+    }
+
+    return copy;
+}
+
+int c_inline_expression_size(c_ast_expression *expression) {
+    if (expression->type != C_BINARY_EXPRESSION) {
+        return 1;
+    }
+
+    return 1 + c_inline_expression_size(expression->binary->lhs)
+           + c_inline_expression_size(expression->binary->rhs);
+}
+
+static int c_inline_is_foldable(c_ast_expression *expression) {
+    switch (expression->type) {
+        case C_CONSTANT:
+            return 1;
+        case C_BINARY_EXPRESSION:
+            return c_inline_is_foldable(expression->binary->lhs)
+                   && c_inline_is_foldable(expression->binary->rhs);
+        default:
+            return 0;
+    }
+}
+
+int c_inline_cost(c_ast_expression *summary) {
+    int size = c_inline_is_foldable(summary)
+                   ? 1
+                   : c_inline_expression_size(summary);
+
+    return size - C_INLINE_CALL_BENEFIT;
+}
+
+static c_ast_expression *c_inline_substitute(c_inline_summary_context *context,
+                                             c_ast_expression *expression) {
+    switch (expression->type) {
+        case C_FUNCTION_CALL:
+            context->calls++;
+            context->size++;
+            return c_inline_copy_expression(expression);
+        case C_CONSTANT:
+            context->size++;
+            return c_inline_copy_expression(expression);
+        case C_VARIABLE:
+            for (int i = (int)arrlen(context->bindings) - 1; i >= 0; i--) {
+                c_inline_binding *binding = &context->bindings[i];
+
+                if (strcmp(binding->name, expression->variable->name) != 0) {
+                    continue;
+                }
+
+                context->size += c_inline_expression_size(binding->expression);
+
+                if (context->size > C_INLINE_MAX_SUMMARY_SIZE) {
+                    context->failed = 1;
+                    return NULL;
+                }
+
+                binding->uses++;
+                return c_inline_copy_expression(binding->expression);
+            }
+
+            // NOTE: undeclared, left for the later passes to report
+            context->failed = 1;
+            return NULL;
+        case C_BINARY_EXPRESSION: {
+            c_ast_expression *lhs =
+                c_inline_substitute(context, expression->binary->lhs);
+            c_ast_expression *rhs =
+                c_inline_substitute(context, expression->binary->rhs);
+
+            if (!lhs || !rhs) {
+                c_ast_free_expression(lhs);
+                c_ast_free_expression(rhs);
+                return NULL;
+            }
+
+            context->size++;
+            c_ast_expression *result = malloc(sizeof(c_ast_expression));
+            result->type = C_BINARY_EXPRESSION;
+            result->binary = malloc(sizeof(c_ast_binary_expression));
+            *result->binary = *expression->binary;
+            result->binary->lhs = lhs;
+            result->binary->rhs = rhs;
+
+            return result;
+        }
+        default:
+            context->failed = 1;
+            return NULL;
+    }
+}
+
+// NOTE: functions only return values, so a local with a call
+// may move but must still be evaluated exactly once
+static void c_inline_pop_bindings(c_inline_summary_context *context,
+                                  size_t start) {
+    for (size_t i = start; i < arrlenu(context->bindings); i++) {
+        c_inline_binding *binding = &context->bindings[i];
+
+        if (binding->uses != 1 && !c_fold_is_pure(binding->expression)) {
+            context->failed = 1;
+        }
+
+        c_ast_free_expression(binding->expression);
+    }
+
+    arrsetlen(context->bindings, start);
+}
+
+static void c_inline_summarize_block(c_inline_summary_context *context,
+                                     c_ast_block *block) {
+    size_t start = arrlenu(context->bindings);
+
+    for (int i = 0; i < arrlen(block->statements); i++) {
+        if (context->failed || context->result) {
+            break;
+        }
+
+        c_ast_statement *statement = block->statements[i];
+
+        switch (statement->type) {
+            case C_STATEMENT_ASSIGNMENT: {
+                c_ast_expression *expression = c_inline_substitute(
+                    context, statement->assignment->expression);
+
+                if (expression) {
+                    context->moves_call |= !c_fold_is_pure(expression);
+                    c_inline_binding binding = {
+                        statement->assignment->variable_name, expression, 0};
+                    arrput(context->bindings, binding);
+                }
+                break;
+            }
+            case C_STATEMENT_BLOCK:
+                c_inline_summarize_block(context, statement->block);
+                break;
+            case C_STATEMENT_EXPRESSION: {
+                c_ast_expression *expression =
+                    c_inline_substitute(context, statement->expression);
+
+                if (expression && !c_fold_is_pure(expression)) {
+                    context->failed = 1;
+                }
+
+                c_ast_free_expression(expression);
+                break;
+            }
+            // NOTE: there is no control flow, the first
+            // return is the one that runs
+            case C_STATEMENT_RETURN:
+                if (!statement->return_statement->value) {
+                    context->failed = 1;
+                    break;
+                }
+
+                context->result = c_inline_substitute(
+                    context, statement->return_statement->value);
+                break;
+            case C_STATEMENT_NOOP:
+                break;
+            default:
+                context->failed = 1;
+                break;
+        }
+    }
+
+    c_inline_pop_bindings(context, start);
+}
+
+c_ast_expression *c_inline_summarize(c_ast_function_declaration *declaration) {
+    c_inline_summary_context context = {0};
+
+    c_inline_summarize_block(&context, declaration->body);
+    arrfree(context.bindings);
+
+    // NOTE: a moved call could then run before a call that
+    // preceded it, so it has to be the only one
+    if (context.moves_call && context.calls > 1) {
+        context.failed = 1;
+    }
+
+    if (context.failed || !context.result) {
+        c_ast_free_expression(context.result);
+        return NULL;
+    }
+
+    return context.result;
+}
+
+static void c_inline_collect_callees(c_inline_context *context,
+                                     c_inline_function *function,
+                                     c_ast_expression *expression) {
+    if (!expression) {
+        return;
+    }
+
+    if (expression->type == C_FUNCTION_CALL) {
+        int callee = c_call_find_function(
+            context->program, expression->function_call->function_name);
+
+        if (callee != -1) {
+            arrput(function->callees, callee);
+        }
+    } else if (expression->type == C_BINARY_EXPRESSION) {
+        c_inline_collect_callees(context, function, expression->binary->lhs);
+        c_inline_collect_callees(context, function, expression->binary->rhs);
+    }
+}
+
+static void c_inline_collect_block(c_inline_context *context,
+                                   c_inline_function *function,
+                                   c_ast_block *block) {
+    for (int i = 0; i < arrlen(block->statements); i++) {
+        c_ast_statement *statement = block->statements[i];
+
+        switch (statement->type) {
+            case C_STATEMENT_BLOCK:
+                c_inline_collect_block(context, function, statement->block);
+                break;
+            case C_STATEMENT_RETURN:
+                c_inline_collect_callees(
+                    context, function, statement->return_statement->value);
+                break;
+            case C_STATEMENT_EXPRESSION:
+                c_inline_collect_callees(
+                    context, function, statement->expression);
+                break;
+            case C_STATEMENT_ASSIGNMENT:
+                c_inline_collect_callees(
+                    context, function, statement->assignment->expression);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static int c_inline_reaches(c_inline_context *context,
+                            int from,
+                            int target,
+                            int *seen) {
+    for (int i = 0; i < arrlen(context->functions[from].callees); i++) {
+        int callee = context->functions[from].callees[i];
+
+        if (callee == target) {
+            return 1;
+        }
+
+        if (!seen[callee]) {
+            seen[callee] = 1;
+
+            if (c_inline_reaches(context, callee, target, seen)) {
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static c_ast_expression *c_inline_expression(c_inline_context *context,
+                                             c_ast_expression *expression) {
+    if (!expression) {
+        return expression;
+    }
+
+    if (expression->type == C_BINARY_EXPRESSION) {
+        expression->binary->lhs =
+            c_inline_expression(context, expression->binary->lhs);
+        expression->binary->rhs =
+            c_inline_expression(context, expression->binary->rhs);
+        return expression;
+    }
+
+    if (expression->type != C_FUNCTION_CALL) {
+        return expression;
+    }
+
+    int callee = c_call_find_function(
+        context->program, expression->function_call->function_name);
+
+    if (callee == -1 || !context->functions[callee].summary) {
+        return expression;
+    }
+
+    c_ast_free_expression(expression);
+    context->inlined++;
+
+    return c_inline_copy_expression(context->functions[callee].summary);
+}
+
+static void c_inline_block(c_inline_context *context, c_ast_block *block) {
+    for (int i = 0; i < arrlen(block->statements); i++) {
+        c_ast_statement *statement = block->statements[i];
+
+        switch (statement->type) {
+            case C_STATEMENT_BLOCK:
+                c_inline_block(context, statement->block);
+                break;
+            case C_STATEMENT_RETURN:
+                statement->return_statement->value = c_inline_expression(
+                    context, statement->return_statement->value);
+                break;
+            case C_STATEMENT_EXPRESSION:
+                statement->expression =
+                    c_inline_expression(context, statement->expression);
+                break;
+            case C_STATEMENT_ASSIGNMENT:
+                statement->assignment->expression = c_inline_expression(
+                    context, statement->assignment->expression);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// NOTE: callees first, so a summary already has its own
+// small callees inlined and is measured after that
+static void c_inline_visit(c_inline_context *context, int index) {
+    c_inline_function *function = &context->functions[index];
+
+    if (function->is_visited) {
+        return;
+    }
+
+    function->is_visited = 1;
+
+    for (int i = 0; i < arrlen(function->callees); i++) {
+        c_inline_visit(context, function->callees[i]);
+    }
+
+    c_inline_block(context, function->declaration->body);
+
+    if (function->is_recursive) {
+        return;
+    }
+
+    function->summary = c_inline_summarize(function->declaration);
+
+    if (!function->summary) {
+        return;
+    }
+
+    function->cost = c_inline_cost(function->summary);
+
+    if (function->cost > context->threshold) {
+        c_ast_free_expression(function->summary);
+        function->summary = NULL;
+    }
+}
+
+int c_inline_program(c_ast_program *program, int threshold) {
+    c_inline_context context = {
+        .program = program, .functions = NULL, .threshold = threshold};
+    int count = (int)arrlen(program->function_declarations);
+
+    for (int i = 0; i < count; i++) {
+        c_inline_function function = {0};
+        function.declaration = program->function_declarations[i];
+        arrput(context.functions, function);
+    }
+
+    for (int i = 0; i < count; i++) {
+        c_inline_collect_block(&context, &context.functions[i],
+                               context.functions[i].declaration->body);
+    }
+
+    int *seen = calloc(count ? count : 1, sizeof(int));
+
+    for (int i = 0; i < count; i++) {
+        memset(seen, 0, count * sizeof(int));
+        context.functions[i].is_recursive =
+            c_inline_reaches(&context, i, i, seen);
+    }
+
+    free(seen);
+
+    for (int i = 0; i < count; i++) {
+        c_inline_visit(&context, i);
+    }
+
+    for (int i = 0; i < count; i++) {
+        arrfree(context.functions[i].callees);
+        c_ast_free_expression(context.functions[i].summary);
+    }
+
+    arrfree(context.functions);
+
+    return context.inlined;
+}
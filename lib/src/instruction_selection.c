@@ -0,0 +1,404 @@
+#include "instruction_selection.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include "stb_ds.h"
+#include "utils.h"
+
+#define C_ISEL_MAX_DEPTH 3
+
+static const int c_isel_costs[C_ISEL_KINDS_COUNT] = {
+    [C_ISEL_MOVE] = 1,
+    [C_ISEL_ALU] = 1,
+    [C_ISEL_SHIFT] = 1,
+    [C_ISEL_IMUL] = 3,
+    [C_ISEL_LEA] = 1,
+    [C_ISEL_LEA_COMPLEX] = 3,
+};
+
+typedef struct {
+    c_ir_function *function;
+    int *use_counts;
+    c_register_allocation *allocation;
+    c_isel_selection *selection;
+    // NOTE: index of every value inside its block
+    int *positions;
+} c_isel_context;
+
+typedef struct {
+    c_isel_address address;
+    // NOTE: inner values the pattern computes, int64 so that
+    // several displacements can be checked before they are used
+    int64_t displacement;
+    int *covered;
+    int covered_cost;
+} c_isel_match;
+
+int c_isel_cost(c_isel_kind kind) {
+    return c_isel_costs[kind];
+}
+
+static c_ir_instruction *c_isel_instruction(c_isel_context *context,
+                                            int value) {
+    return &context->function->instructions[value];
+}
+
+static int c_isel_is_constant(c_isel_context *context, int value) {
+    return c_isel_instruction(context, value)->opcode == C_IR_CONSTANT;
+}
+
+static int c_isel_in_register(c_isel_context *context, int value) {
+    return context->allocation->registers[value] != C_X86_NO_REGISTER
+           && context->selection->forms[value] != C_ISEL_FOLDED;
+}
+
+// NOTE: constants are immediates and NOPs are gone,
+// neither emits code between a pattern and its root
+static int c_isel_emits_nothing(c_isel_context *context, int value) {
+    c_ir_opcode opcode = c_isel_instruction(context, value)->opcode;
+    return opcode == C_IR_CONSTANT || opcode == C_IR_NOP;
+}
+
+static int c_isel_multiply_cost(int constant) {
+    switch (constant) {
+        case 2:
+        case 4:
+        case 8:
+            return c_isel_cost(C_ISEL_MOVE) + c_isel_cost(C_ISEL_SHIFT);
+        case 3:
+        case 5:
+        case 9:
+            return c_isel_cost(C_ISEL_LEA);
+        default:
+            return c_isel_cost(C_ISEL_IMUL);
+    }
+}
+
+// NOTE: two address add or sub, a move first unless the
+// result register already holds the left operand
+static int c_isel_two_address_cost(c_isel_context *context, int value) {
+    c_ir_instruction *instruction = c_isel_instruction(context, value);
+    c_x86_register work = context->allocation->registers[value];
+    int cost = c_isel_cost(C_ISEL_ALU);
+
+    for (int o = 0; o < 2; o++) {
+        int operand = instruction->operands[o];
+
+        if (work != C_X86_NO_REGISTER
+            && context->allocation->registers[operand] == work
+            && (o == 0 || instruction->opcode == C_IR_ADD)) {
+            return cost;
+        }
+    }
+
+    return cost + c_isel_cost(C_ISEL_MOVE);
+}
+
+static int c_isel_add_term(c_isel_address *address, int value, int scale) {
+    if (scale == 1 && address->base == C_IR_NO_VALUE) {
+        address->base = value;
+        return 1;
+    }
+
+    if (address->index == C_IR_NO_VALUE) {
+        address->index = value;
+        address->scale = scale;
+        return 1;
+    }
+
+    // NOTE: a scaled term needs the index, move a plain one to the base
+    if (address->scale == 1 && address->base == C_IR_NO_VALUE) {
+        address->base = address->index;
+        address->index = value;
+        address->scale = scale;
+        return 1;
+    }
+
+    return 0;
+}
+
+static int c_isel_match_node(c_isel_context *context,
+                             int value,
+                             int root,
+                             int depth,
+                             c_isel_match *match);
+
+static int c_isel_match_leaf(c_isel_context *context,
+                             int value,
+                             c_isel_match *match) {
+    if (c_isel_is_constant(context, value)) {
+        match->displacement += c_isel_instruction(context, value)->constant;
+        return 1;
+    }
+
+    return c_isel_in_register(context, value)
+           && c_isel_add_term(&match->address, value, 1);
+}
+
+static int c_isel_match_operands(c_isel_context *context,
+                                 int value,
+                                 int root,
+                                 int depth,
+                                 c_isel_match *match) {
+    c_ir_instruction *instruction = c_isel_instruction(context, value);
+    int lhs = instruction->operands[0];
+    int rhs = instruction->operands[1];
+
+    switch (instruction->opcode) {
+        case C_IR_ADD:
+            return c_isel_match_node(context, lhs, root, depth + 1, match)
+                   && c_isel_match_node(context, rhs, root, depth + 1, match);
+        case C_IR_SUBTRACT:
+            if (!c_isel_is_constant(context, rhs)) {
+                return 0;
+            }
+
+            match->displacement -= c_isel_instruction(context, rhs)->constant;
+            return c_isel_match_node(context, lhs, root, depth + 1, match);
+        case C_IR_MULTIPLY: {
+            if (c_isel_is_constant(context, lhs)) {
+                int tmp = lhs;
+                lhs = rhs;
+                rhs = tmp;
+            }
+
+            if (!c_isel_is_constant(context, rhs)
+                || !c_isel_in_register(context, lhs)) {
+                return 0;
+            }
+
+            int constant = c_isel_instruction(context, rhs)->constant;
+
+            if (constant == 2 || constant == 4 || constant == 8) {
+                return c_isel_add_term(&match->address, lhs, constant);
+            }
+
+            // NOTE: x * 3 is [x+x*2], it takes both registers
+            if ((constant == 3 || constant == 5 || constant == 9)
+                && match->address.base == C_IR_NO_VALUE
+                && match->address.index == C_IR_NO_VALUE) {
+                match->address.base = lhs;
+                match->address.index = lhs;
+                match->address.scale = constant - 1;
+                return 1;
+            }
+
+            return 0;
+        }
+        default:
+            return 0;
+    }
+}
+
+// NOTE: an inner node is covered when it has no other user and sits
+// in the root block, otherwise it is a leaf read from its register
+static int c_isel_match_node(c_isel_context *context,
+                             int value,
+                             int root,
+                             int depth,
+                             c_isel_match *match) {
+    c_ir_instruction *instruction = c_isel_instruction(context, value);
+
+    if (depth <= C_ISEL_MAX_DEPTH && context->use_counts[value] == 1
+        && instruction->block == c_isel_instruction(context, root)->block
+        && (instruction->opcode == C_IR_ADD
+            || instruction->opcode == C_IR_SUBTRACT
+            || instruction->opcode == C_IR_MULTIPLY)) {
+        c_isel_match saved = *match;
+        int covered_count = (int)arrlen(match->covered);
+
+        if (c_isel_match_operands(context, value, root, depth, match)) {
+            c_ir_instruction *inner = c_isel_instruction(context, value);
+
+            arrput(match->covered, value);
+            match->covered_cost +=
+                inner->opcode == C_IR_MULTIPLY
+                    ? c_isel_multiply_cost(c_isel_instruction(
+                          context,
+                          c_isel_is_constant(context, inner->operands[1])
+                              ? inner->operands[1]
+                              : inner->operands[0])->constant)
+                    : c_isel_two_address_cost(context, value);
+            return 1;
+        }
+
+        saved.covered = match->covered;
+        arrsetlen(saved.covered, (size_t)covered_count);
+        *match = saved;
+    }
+
+    return c_isel_match_leaf(context, value, match);
+}
+
+// NOTE: everything between a covered value and the root must
+// emit nothing, or be covered by the same pattern
+static int c_isel_is_contiguous(c_isel_context *context,
+                                int root,
+                                int *covered) {
+    int *instructions =
+        context->function->blocks[c_isel_instruction(context, root)->block]
+            .instructions;
+
+    for (int c = 0; c < arrlen(covered); c++) {
+        for (int i = context->positions[covered[c]] + 1;
+             i < context->positions[root];
+             i++) {
+            int between = instructions[i];
+            int is_covered = c_isel_emits_nothing(context, between);
+
+            for (int k = 0; k < arrlen(covered) && !is_covered; k++) {
+                is_covered = covered[k] == between;
+            }
+
+            if (!is_covered) {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+static void c_isel_select_address(c_isel_context *context, int root) {
+    c_isel_match match = {
+        .address = {C_IR_NO_VALUE, C_IR_NO_VALUE, 1, 0}, .covered = NULL};
+
+    if (!c_isel_match_operands(context, root, root, 0, &match)
+        || !c_isel_is_contiguous(context, root, match.covered)) {
+        arrfree(match.covered);
+        match = (c_isel_match){
+            .address = {C_IR_NO_VALUE, C_IR_NO_VALUE, 1, 0}, .covered = NULL};
+
+        // NOTE: only the operands of the root, nothing is covered
+        if (!c_isel_match_operands(
+                context, root, root, C_ISEL_MAX_DEPTH, &match)) {
+            arrfree(match.covered);
+            return;
+        }
+    }
+
+    int has_register = match.address.base != C_IR_NO_VALUE
+                       || match.address.index != C_IR_NO_VALUE;
+    int is_complex = match.address.base != C_IR_NO_VALUE
+                     && match.address.index != C_IR_NO_VALUE
+                     && match.displacement != 0;
+    int lea_cost = c_isel_cost(is_complex ? C_ISEL_LEA_COMPLEX : C_ISEL_LEA);
+    int default_cost =
+        c_isel_two_address_cost(context, root) + match.covered_cost;
+
+    // NOTE: multiplies as roots keep their strength reduced form
+    if (has_register && match.displacement >= INT32_MIN
+        && match.displacement <= INT32_MAX
+        && c_isel_instruction(context, root)->opcode != C_IR_MULTIPLY
+        && lea_cost < default_cost) {
+        match.address.displacement = (int)match.displacement;
+        context->selection->forms[root] = C_ISEL_ADDRESS;
+        context->selection->addresses[root] = match.address;
+
+        for (int c = 0; c < arrlen(match.covered); c++) {
+            context->selection->forms[match.covered[c]] = C_ISEL_FOLDED;
+        }
+    }
+
+    arrfree(match.covered);
+}
+
+// NOTE: loads right before their only user are read by it from memory
+static void c_isel_fold_loads(c_isel_context *context, int block) {
+    int *instructions = context->function->blocks[block].instructions;
+
+    for (int i = 0; i < arrlen(instructions); i++) {
+        int user = instructions[i];
+        c_ir_instruction *instruction = c_isel_instruction(context, user);
+        int operands[2];
+        int count = c_ir_value_operands(instruction, operands);
+
+        if (context->selection->forms[user] != C_ISEL_EMIT || count == 0) {
+            continue;
+        }
+
+        for (int j = i - 1; j >= 0; j--) {
+            int value = instructions[j];
+            c_ir_instruction *load = c_isel_instruction(context, value);
+
+            if (c_isel_emits_nothing(context, value)) {
+                continue;
+            }
+
+            int is_operand = 0;
+            for (int o = 0; o < count; o++) {
+                is_operand |= operands[o] == value;
+            }
+
+            if (load->opcode != C_IR_LOAD || !is_operand
+                || context->use_counts[value] != 1) {
+                break;
+            }
+
+            context->selection->forms[value] = C_ISEL_FOLDED;
+        }
+    }
+}
+
+c_isel_selection *c_isel_select(c_ir_function *function,
+                                int *use_counts,
+                                c_register_allocation *allocation) {
+    c_isel_selection *selection = malloc(sizeof(c_isel_selection));
+    int count = (int)arrlen(function->instructions);
+
+    if (!selection) {
+        EXIT_WITH_ERROR("Failed to allocate memory for instruction selection\n");
+    }
+
+    selection->forms = NULL;
+    selection->addresses = NULL;
+
+    c_isel_context context = {.function = function,
+                              .use_counts = use_counts,
+                              .allocation = allocation,
+                              .selection = selection,
+                              .positions = NULL};
+
+    for (int v = 0; v < count; v++) {
+        c_isel_address address = {C_IR_NO_VALUE, C_IR_NO_VALUE, 1, 0};
+        arrput(selection->forms, C_ISEL_EMIT);
+        arrput(selection->addresses, address);
+        arrput(context.positions, -1);
+    }
+
+    for (int b = 0; b < arrlen(function->blocks); b++) {
+        int *instructions = function->blocks[b].instructions;
+
+        for (int i = 0; i < arrlen(instructions); i++) {
+            context.positions[instructions[i]] = i;
+        }
+    }
+
+    // NOTE: last to first, a root is selected before the
+    // operands it might cover are looked at as roots
+    for (int b = 0; b < arrlen(function->blocks); b++) {
+        int *instructions = function->blocks[b].instructions;
+
+        for (int i = (int)arrlen(instructions) - 1; i >= 0; i--) {
+            int value = instructions[i];
+            c_ir_opcode opcode = function->instructions[value].opcode;
+
+            if ((opcode == C_IR_ADD || opcode == C_IR_SUBTRACT)
+                && selection->forms[value] == C_ISEL_EMIT
+                && use_counts[value] > 0) {
+                c_isel_select_address(&context, value);
+            }
+        }
+
+        c_isel_fold_loads(&context, b);
+    }
+
+    arrfree(context.positions);
+
+    return selection;
+}
+
+void c_isel_selection_free(c_isel_selection *selection) {
+    arrfree(selection->forms);
+    arrfree(selection->addresses);
+    free(selection);
+}
@@ -0,0 +1,553 @@
+#include "interpreter.h"
+#include <stdlib.h>
+#include <string.h>
+#include "ssa.h"
+#include "stb_ds.h"
+#include "str.h"
+#include "utils.h"
+
+// NOTE: labels as values are a gnu extension,
+// other compilers dispatch through a switch
+#if defined(__GNUC__) && !defined(C_INTERPRETER_SWITCH)
+#define C_INTERPRETER_THREADED 1
+#endif
+
+typedef struct {
+    int position;
+    int block;
+} c_bytecode_patch;
+
+typedef struct {
+    c_ir_module *module;
+    c_ir_function *function;
+    int32_t *code;
+    // NOTE: value id to register, -1 for values without a result
+    int *registers;
+    int *block_starts;
+    c_bytecode_patch *patches;
+    int registers_count;
+    int scratch;
+} c_bytecode_compiler;
+
+typedef struct {
+    const int32_t *code;
+    const int32_t *return_pc;
+    int base;
+    int destination;
+} c_interpreter_frame;
+
+static int c_bytecode_has_result(c_ir_opcode opcode) {
+    switch (opcode) {
+        case C_IR_CONSTANT:
+        case C_IR_ALLOCA:
+        case C_IR_LOAD:
+        case C_IR_ADD:
+        case C_IR_SUBTRACT:
+        case C_IR_MULTIPLY:
+        case C_IR_DIVIDE:
+        case C_IR_CALL:
+        case C_IR_PHI:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int c_bytecode_register(c_bytecode_compiler *compiler, int value) {
+    if (value < 0 || value >= arrlen(compiler->registers)
+        || compiler->registers[value] == -1) {
+        EXIT_WITH_ERROR("Value %%%d has no bytecode register\n", value);
+    }
+
+    return compiler->registers[value];
+}
+
+static void c_bytecode_emit(c_bytecode_compiler *compiler,
+                            c_bytecode_opcode opcode,
+                            int count,
+                            int32_t a,
+                            int32_t b,
+                            int32_t c) {
+    int32_t operands[3] = {a, b, c};
+
+    arrput(compiler->code, opcode);
+
+    for (int i = 0; i < count; i++) {
+        arrput(compiler->code, operands[i]);
+    }
+}
+
+static void c_bytecode_emit_target(c_bytecode_compiler *compiler, int block) {
+    c_bytecode_patch patch = {(int)arrlen(compiler->code), block};
+
+    arrput(compiler->patches, patch);
+    arrput(compiler->code, -1);
+}
+
+static int c_bytecode_function_index(c_bytecode_compiler *compiler,
+                                     const char *name) {
+    for (int i = 0; i < arrlen(compiler->module->functions); i++) {
+        if (strcmp(compiler->module->functions[i]->name, name) == 0) {
+            return i;
+        }
+    }
+
+    EXIT_WITH_ERROR("Undefined reference to %s\n", name);
+}
+
+// NOTE: phis read their operands in parallel, going
+// through scratch registers keeps swaps correct
+static int c_bytecode_emit_phi_copies(c_bytecode_compiler *compiler,
+                                      int from_block,
+                                      int to_block) {
+    c_ir_function *function = compiler->function;
+    int *phis = NULL;
+    int *sources = NULL;
+
+    for (int i = 0; i < arrlen(function->blocks[to_block].instructions); i++) {
+        int value = function->blocks[to_block].instructions[i];
+        c_ir_instruction *instruction = &function->instructions[value];
+
+        if (instruction->opcode != C_IR_PHI) {
+            continue;
+        }
+
+        for (int j = 0; j < arrlen(instruction->phi_operands); j++) {
+            if (instruction->phi_operands[j].block == from_block) {
+                arrput(phis, c_bytecode_register(compiler, value));
+                arrput(sources,
+                       c_bytecode_register(
+                           compiler, instruction->phi_operands[j].value));
+                break;
+            }
+        }
+    }
+
+    int count = (int)arrlen(phis);
+
+    if (count == 1) {
+        c_bytecode_emit(compiler, C_BYTECODE_MOVE, 2, phis[0], sources[0], 0);
+    } else {
+        for (int i = 0; i < count; i++) {
+            c_bytecode_emit(compiler, C_BYTECODE_MOVE, 2,
+                            compiler->scratch + i, sources[i], 0);
+        }
+
+        for (int i = 0; i < count; i++) {
+            c_bytecode_emit(compiler, C_BYTECODE_MOVE, 2,
+                            phis[i], compiler->scratch + i, 0);
+        }
+    }
+
+    arrfree(phis);
+    arrfree(sources);
+
+    return count;
+}
+
+static void c_bytecode_emit_jump(c_bytecode_compiler *compiler,
+                                 int from_block,
+                                 int to_block,
+                                 int can_fall_through) {
+    int copies = c_bytecode_emit_phi_copies(compiler, from_block, to_block);
+
+    // NOTE: blocks are laid out in order, the next one is a fallthrough
+    if (can_fall_through && copies == 0 && to_block == from_block + 1) {
+        return;
+    }
+
+    arrput(compiler->code, C_BYTECODE_JUMP);
+    c_bytecode_emit_target(compiler, to_block);
+}
+
+static void c_bytecode_compile_instruction(c_bytecode_compiler *compiler,
+                                           int value) {
+    c_ir_instruction *instruction = &compiler->function->instructions[value];
+    int block = instruction->block;
+
+    switch (instruction->opcode) {
+        case C_IR_CONSTANT:
+            c_bytecode_emit(compiler, C_BYTECODE_CONSTANT, 2,
+                            c_bytecode_register(compiler, value),
+                            instruction->constant, 0);
+            break;
+        case C_IR_LOAD:
+            c_bytecode_emit(
+                compiler, C_BYTECODE_MOVE, 2,
+                c_bytecode_register(compiler, value),
+                c_bytecode_register(compiler, instruction->operands[0]), 0);
+            break;
+        case C_IR_STORE:
+            c_bytecode_emit(
+                compiler, C_BYTECODE_MOVE, 2,
+                c_bytecode_register(compiler, instruction->operands[0]),
+                c_bytecode_register(compiler, instruction->operands[1]), 0);
+            break;
+        case C_IR_ADD:
+        case C_IR_SUBTRACT:
+        case C_IR_MULTIPLY:
+        case C_IR_DIVIDE: {
+            c_bytecode_opcode opcode =
+                C_BYTECODE_ADD + (instruction->opcode - C_IR_ADD);
+
+            c_bytecode_emit(
+                compiler, opcode, 3, c_bytecode_register(compiler, value),
+                c_bytecode_register(compiler, instruction->operands[0]),
+                c_bytecode_register(compiler, instruction->operands[1]));
+            break;
+        }
+        case C_IR_CALL:
+            c_bytecode_emit(
+                compiler, C_BYTECODE_CALL, 2,
+                c_bytecode_register(compiler, value),
+                c_bytecode_function_index(compiler, instruction->function_name),
+                0);
+            break;
+        case C_IR_JUMP:
+            c_bytecode_emit_jump(compiler, block, instruction->targets[0], 1);
+            break;
+        case C_IR_BRANCH: {
+            arrput(compiler->code, C_BYTECODE_BRANCH_ZERO);
+            arrput(compiler->code,
+                   c_bytecode_register(compiler, instruction->operands[0]));
+            int else_position = (int)arrlen(compiler->code);
+            arrput(compiler->code, -1);
+
+            // NOTE: else copies may follow, the then edge always jumps
+            c_bytecode_emit_jump(compiler, block, instruction->targets[0], 0);
+
+            // NOTE: without else copies the branch goes to the block directly
+            int start = (int)arrlen(compiler->code);
+
+            if (c_bytecode_emit_phi_copies(
+                    compiler, block, instruction->targets[1])
+                == 0) {
+                c_bytecode_patch patch = {else_position,
+                                          instruction->targets[1]};
+                arrput(compiler->patches, patch);
+            } else {
+                compiler->code[else_position] = start;
+                arrput(compiler->code, C_BYTECODE_JUMP);
+                c_bytecode_emit_target(compiler, instruction->targets[1]);
+            }
+            break;
+        }
+        case C_IR_RETURN:
+            if (instruction->operands[0] == C_IR_NO_VALUE) {
+                arrput(compiler->code, C_BYTECODE_RETURN_ZERO);
+            } else {
+                c_bytecode_emit(
+                    compiler, C_BYTECODE_RETURN, 1,
+                    c_bytecode_register(compiler, instruction->operands[0]),
+                    0, 0);
+            }
+            break;
+        // NOTE: allocas only reserve a register, phis are
+        // written by the copies on their incoming edges
+        case C_IR_ALLOCA:
+        case C_IR_PHI:
+        case C_IR_NOP:
+            break;
+        default:
+            EXIT_WITH_ERROR("Got unsupported opcode for bytecode: %s\n",
+                            c_ir_opcode_to_string(instruction->opcode));
+    }
+}
+
+static c_bytecode_function c_bytecode_compile_function(
+    c_ir_module *module,
+    c_ir_function *function) {
+    c_bytecode_compiler compiler = {0};
+    compiler.module = module;
+    compiler.function = function;
+
+    for (int i = 0; i < arrlen(function->instructions); i++) {
+        int has_result =
+            c_bytecode_has_result(function->instructions[i].opcode);
+
+        arrput(compiler.registers,
+               has_result ? compiler.registers_count++ : -1);
+    }
+
+    int scratch_count = 0;
+
+    for (int b = 0; b < arrlen(function->blocks); b++) {
+        int phis = 0;
+
+        for (int i = 0; i < arrlen(function->blocks[b].instructions); i++) {
+            int value = function->blocks[b].instructions[i];
+            phis += function->instructions[value].opcode == C_IR_PHI;
+        }
+
+        scratch_count = phis > scratch_count ? phis : scratch_count;
+    }
+
+    compiler.scratch = compiler.registers_count;
+    compiler.registers_count += scratch_count;
+
+    for (int b = 0; b < arrlen(function->blocks); b++) {
+        arrput(compiler.block_starts, (int)arrlen(compiler.code));
+
+        for (int i = 0; i < arrlen(function->blocks[b].instructions); i++) {
+            c_bytecode_compile_instruction(
+                &compiler, function->blocks[b].instructions[i]);
+        }
+    }
+
+    // NOTE: a block without a terminator must not run off the code
+    arrput(compiler.code, C_BYTECODE_RETURN_ZERO);
+
+    for (int i = 0; i < arrlen(compiler.patches); i++) {
+        c_bytecode_patch *patch = &compiler.patches[i];
+        compiler.code[patch->position] = compiler.block_starts[patch->block];
+    }
+
+    c_bytecode_function result = {
+        .name = strdup(function->name),
+        .code = compiler.code,
+        .registers_count = compiler.registers_count,
+    };
+
+    arrfree(compiler.registers);
+    arrfree(compiler.block_starts);
+    arrfree(compiler.patches);
+
+    return result;
+}
+
+c_bytecode_module *c_bytecode_compile_module(c_ir_module *module) {
+    c_bytecode_module *result = malloc(sizeof(c_bytecode_module));
+
+    if (!result) {
+        EXIT_WITH_ERROR("Failed to allocate memory for bytecode module\n");
+    }
+
+    result->functions = NULL;
+
+    for (int i = 0; i < arrlen(module->functions); i++) {
+        arrput(result->functions,
+               c_bytecode_compile_function(module, module->functions[i]));
+    }
+
+    return result;
+}
+
+c_bytecode_module *c_bytecode_compile(c_ast_program *program) {
+    c_ir_module *module = c_ir_lower_program(program);
+
+    // NOTE: locals become registers instead of a load and store each
+    for (int i = 0; i < arrlen(module->functions); i++) {
+        c_ssa_promote_allocas(module->functions[i]);
+    }
+    c_bytecode_module *result = c_bytecode_compile_module(module);
+
+    c_ir_module_free(module);
+
+    return result;
+}
+
+int c_bytecode_find_function(c_bytecode_module *module, const char *name) {
+    for (int i = 0; i < arrlen(module->functions); i++) {
+        if (strcmp(module->functions[i].name, name) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void c_bytecode_module_free(c_bytecode_module *module) {
+    if (!module) {
+        return;
+    }
+
+    for (int i = 0; i < arrlen(module->functions); i++) {
+        free(module->functions[i].name);
+        arrfree(module->functions[i].code);
+    }
+
+    arrfree(module->functions);
+    free(module);
+}
+
+// NOTE: unsigned arithmetic wraps without undefined behaviour
+static int32_t c_interpreter_wrap(uint32_t value) {
+    return (int32_t)value;
+}
+
+#ifdef C_INTERPRETER_THREADED
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
+c_interpreter_status c_interpreter_run(c_bytecode_module *module,
+                                       const char *entry,
+                                       int *result) {
+    int function = c_bytecode_find_function(module, entry);
+
+    if (function == -1) {
+        return C_INTERPRETER_UNDEFINED_ENTRY;
+    }
+
+    c_interpreter_status status = C_INTERPRETER_OK;
+    c_interpreter_frame *frames = NULL;
+    int32_t *stack = NULL;
+    int base = 0;
+
+    arrsetlen(stack, (size_t)module->functions[function].registers_count);
+    memset(stack, 0, arrlen(stack) * sizeof(int32_t));
+
+    int32_t *r = stack;
+    // NOTE: jump targets are offsets into the code of the current function
+    const int32_t *code = module->functions[function].code;
+    const int32_t *pc = code;
+    c_interpreter_frame frame;
+
+#ifdef C_INTERPRETER_THREADED
+    // NOTE: same order as c_bytecode_opcode
+    static const void *dispatch[C_BYTECODE_OPCODES_COUNT] = {
+        &&op_CONSTANT, &&op_MOVE,        &&op_ADD,
+        &&op_SUBTRACT, &&op_MULTIPLY,    &&op_DIVIDE,
+        &&op_CALL,     &&op_JUMP,        &&op_BRANCH_ZERO,
+        &&op_RETURN,   &&op_RETURN_ZERO,
+    };
+#define C_INTERPRETER_OP(name) op_##name:
+#define C_INTERPRETER_NEXT() goto *dispatch[*pc]
+#else
+#define C_INTERPRETER_OP(name) case C_BYTECODE_##name:
+#define C_INTERPRETER_NEXT() continue
+#endif
+
+#define C_INTERPRETER_LEAVE()                 \
+    if (arrlen(frames) == 0) {                \
+        *result = value;                      \
+        goto done;                            \
+    }                                         \
+    frame = arrlast(frames);                  \
+    arrsetlen(frames, arrlenu(frames) - 1);   \
+    arrsetlen(stack, (size_t)base);           \
+    base = frame.base;                        \
+    r = stack + base;                         \
+    r[frame.destination] = value;             \
+    code = frame.code;                        \
+    pc = frame.return_pc;                     \
+    C_INTERPRETER_NEXT()
+
+    int32_t value = 0;
+
+#ifdef C_INTERPRETER_THREADED
+    C_INTERPRETER_NEXT();
+#else
+    for (;;) {
+        switch (*pc) {
+#endif
+    C_INTERPRETER_OP(CONSTANT) {
+        r[pc[1]] = pc[2];
+        pc += 3;
+        C_INTERPRETER_NEXT();
+    }
+    C_INTERPRETER_OP(MOVE) {
+        r[pc[1]] = r[pc[2]];
+        pc += 3;
+        C_INTERPRETER_NEXT();
+    }
+    C_INTERPRETER_OP(ADD) {
+        r[pc[1]] =
+            c_interpreter_wrap((uint32_t)r[pc[2]] + (uint32_t)r[pc[3]]);
+        pc += 4;
+        C_INTERPRETER_NEXT();
+    }
+    C_INTERPRETER_OP(SUBTRACT) {
+        r[pc[1]] =
+            c_interpreter_wrap((uint32_t)r[pc[2]] - (uint32_t)r[pc[3]]);
+        pc += 4;
+        C_INTERPRETER_NEXT();
+    }
+    C_INTERPRETER_OP(MULTIPLY) {
+        r[pc[1]] =
+            c_interpreter_wrap((uint32_t)r[pc[2]] * (uint32_t)r[pc[3]]);
+        pc += 4;
+        C_INTERPRETER_NEXT();
+    }
+    C_INTERPRETER_OP(DIVIDE) {
+        int32_t divisor = r[pc[3]];
+
+        if (divisor == 0 || (divisor == -1 && r[pc[2]] == INT32_MIN)) {
+            status = C_INTERPRETER_ARITHMETIC_ERROR;
+            goto done;
+        }
+
+        r[pc[1]] = r[pc[2]] / divisor;
+        pc += 4;
+        C_INTERPRETER_NEXT();
+    }
+    C_INTERPRETER_OP(CALL) {
+        if (arrlen(frames) == C_INTERPRETER_MAX_FRAMES) {
+            status = C_INTERPRETER_STACK_OVERFLOW;
+            goto done;
+        }
+
+        c_bytecode_function *callee = &module->functions[pc[2]];
+        frame = (c_interpreter_frame){code, pc + 3, base, pc[1]};
+        arrput(frames, frame);
+
+        // NOTE: the stack may move, frames only keep offsets
+        base = (int)arrlen(stack);
+        arrsetlen(stack, (size_t)(base + callee->registers_count));
+        memset(stack + base, 0, callee->registers_count * sizeof(int32_t));
+        r = stack + base;
+        code = callee->code;
+        pc = code;
+        C_INTERPRETER_NEXT();
+    }
+    C_INTERPRETER_OP(JUMP) {
+        pc = code + pc[1];
+        C_INTERPRETER_NEXT();
+    }
+    C_INTERPRETER_OP(BRANCH_ZERO) {
+        pc = r[pc[1]] == 0 ? code + pc[2] : pc + 3;
+        C_INTERPRETER_NEXT();
+    }
+    C_INTERPRETER_OP(RETURN) {
+        value = r[pc[1]];
+        C_INTERPRETER_LEAVE();
+    }
+    C_INTERPRETER_OP(RETURN_ZERO) {
+        value = 0;
+        C_INTERPRETER_LEAVE();
+    }
+#ifndef C_INTERPRETER_THREADED
+            default:
+                EXIT_WITH_ERROR("Got unsupported bytecode opcode: %d\n", *pc);
+        }
+    }
+#endif
+
+done:
+#undef C_INTERPRETER_OP
+#undef C_INTERPRETER_NEXT
+#undef C_INTERPRETER_LEAVE
+    arrfree(frames);
+    arrfree(stack);
+
+    return status;
+}
+
+#ifdef C_INTERPRETER_THREADED
+#pragma GCC diagnostic pop
+#endif
+
+const char *c_interpreter_status_to_string(c_interpreter_status status) {
+    switch (status) {
+        case C_INTERPRETER_OK:
+            return "ok";
+        case C_INTERPRETER_ARITHMETIC_ERROR:
+            return "arithmetic error";
+        case C_INTERPRETER_STACK_OVERFLOW:
+            return "stack overflow";
+        case C_INTERPRETER_UNDEFINED_ENTRY:
+            return "undefined entry";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,209 @@
+#include "interprocedural.h"
+#include <stdlib.h>
+#include <string.h>
+#include "call_rewrite.h"
+#include "constant_folding.h"
+#include "stb_ds.h"
+#include "utils.h"
+
+// NOTE: 0 when any part is varying or the arithmetic traps
+static int c_ipa_expression(c_ipa_context *context,
+                            int frame,
+                            c_ast_expression *expression,
+                            int *value) {
+    switch (expression->type) {
+        case C_CONSTANT:
+            *value = expression->constant->value;
+            return 1;
+        case C_VARIABLE:
+            for (int i = (int)arrlen(context->locals) - 1; i >= frame; i--) {
+                c_ipa_local *local = &context->locals[i];
+
+                if (strcmp(local->name, expression->variable->name) == 0) {
+                    *value = local->value;
+                    return local->is_constant;
+                }
+            }
+
+            return 0;
+        case C_FUNCTION_CALL:
+            return c_ipa_return_value(
+                context, expression->function_call->function_name, value);
+        case C_BINARY_EXPRESSION: {
+            int lhs;
+            int rhs;
+
+            return c_ipa_expression(
+                       context, frame, expression->binary->lhs, &lhs)
+                   && c_ipa_expression(
+                       context, frame, expression->binary->rhs, &rhs)
+                   && c_fold_evaluate(
+                       expression->binary->symbol, lhs, rhs, value);
+        }
+        default:
+            return 0;
+    }
+}
+
+// NOTE: 1 once a return was reached, its value is in value when
+// is_constant is set
+static int c_ipa_block(c_ipa_context *context,
+                       int frame,
+                       c_ast_block *block,
+                       int *is_constant,
+                       int *value) {
+    int start = (int)arrlen(context->locals);
+    int returned = 0;
+
+    for (int i = 0; i < arrlen(block->statements) && !returned; i++) {
+        c_ast_statement *statement = block->statements[i];
+
+        switch (statement->type) {
+            case C_STATEMENT_ASSIGNMENT: {
+                c_ipa_local local = {
+                    .name = statement->assignment->variable_name};
+                local.is_constant =
+                    c_ipa_expression(context,
+                                     frame,
+                                     statement->assignment->expression,
+                                     &local.value);
+                arrput(context->locals, local);
+                break;
+            }
+            case C_STATEMENT_RETURN:
+                returned = 1;
+                *is_constant =
+                    statement->return_statement->value
+                    && c_ipa_expression(context,
+                                        frame,
+                                        statement->return_statement->value,
+                                        value);
+                break;
+            case C_STATEMENT_BLOCK:
+                returned = c_ipa_block(
+                    context, frame, statement->block, is_constant, value);
+                break;
+            default:
+                break;
+        }
+    }
+
+    arrsetlen(context->locals, (size_t)start);
+
+    return returned;
+}
+
+int c_ipa_return_value(c_ipa_context *context, const char *name, int *value) {
+    int index = c_call_find_function(context->program, name);
+
+    if (index == -1) {
+        return 0;
+    }
+
+    c_ipa_function *function = &context->functions[index];
+
+    switch (function->state) {
+        case C_IPA_CONSTANT:
+            *value = function->value;
+            return 1;
+        case C_IPA_RUNNING:
+        case C_IPA_VARYING:
+            return 0;
+        default:
+            break;
+    }
+
+    if (context->depth >= C_IPA_MAX_DEPTH) {
+        return 0;
+    }
+
+    int is_constant = 0;
+    int result;
+
+    function->state = C_IPA_RUNNING;
+    context->depth++;
+
+    int returned = c_ipa_block(context,
+                               (int)arrlen(context->locals),
+                               function->declaration->body,
+                               &is_constant,
+                               &result);
+
+    context->depth--;
+
+    if (!returned || !is_constant) {
+        function->state = C_IPA_VARYING;
+        return 0;
+    }
+
+    function->state = C_IPA_CONSTANT;
+    function->value = result;
+    *value = result;
+
+    return 1;
+}
+
+static int c_ipa_value_for_call(void *context, const char *name, int *value) {
+    return c_ipa_return_value(context, name, value);
+}
+
+static void c_ipa_hoist_call(void *context, c_ast_expression *call) {
+    c_ipa_context *ipa = context;
+    ipa->replaced++;
+    arrput(ipa->hoisted, call);
+}
+
+// NOTE: the hoisted calls go right before the statement they came from
+static int c_ipa_insert_hoisted(void *context, c_ast_block *block, int index) {
+    c_ipa_context *ipa = context;
+    int count = (int)arrlen(ipa->hoisted);
+
+    for (int h = 0; h < count; h++) {
+        c_ast_statement *call = malloc(sizeof(c_ast_statement));
+
+        if (!call) {
+            EXIT_WITH_ERROR("Failed to allocate memory for statement\n");
+        }
+
+        call->type = C_STATEMENT_EXPRESSION;
+        call->expression = ipa->hoisted[h];
+        arrins(block->statements, index + h, call);
+    }
+
+    arrsetlen(ipa->hoisted, 0);
+
+    return count;
+}
+
+int c_ipa_propagate_program(c_ast_program *program) {
+    c_ipa_context context = {0};
+    context.program = program;
+    c_call_rewriter rewriter = {
+        .context = &context,
+        .value_for_call = c_ipa_value_for_call,
+        .replaced = c_ipa_hoist_call,
+        .rewritten = c_ipa_insert_hoisted,
+        // NOTE: a call on its own already discards its result
+        .keep_call_statements = 1,
+    };
+
+    for (int i = 0; i < arrlen(program->function_declarations); i++) {
+        c_ipa_function function = {
+            .declaration = program->function_declarations[i],
+            .state = C_IPA_UNKNOWN,
+            .value = 0,
+        };
+        arrput(context.functions, function);
+    }
+
+    for (int i = 0; i < arrlen(program->function_declarations); i++) {
+        c_call_rewrite_block(&rewriter,
+                             program->function_declarations[i]->body);
+    }
+
+    arrfree(context.functions);
+    arrfree(context.locals);
+    arrfree(context.hoisted);
+
+    return context.replaced;
+}
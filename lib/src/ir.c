@@ -0,0 +1,863 @@
+#include "ir.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "parser.h"
+#include "stb_ds.h"
+#include "str.h"
+#include "utils.h"
+
+#define MAX_IR_LINE_LENGTH 256
+
+typedef struct {
+    char *name;
+    int alloca_value;
+} c_ir_local;
+
+typedef struct {
+    c_ir_module *module;
+    c_ir_function *function;
+    int current_block;
+    int allocas_count;
+    c_ir_local *locals;
+    int *scope_starts;
+} c_ir_builder;
+
+c_ir_function *c_ir_function_create(const char *name) {
+    c_ir_function *function = malloc(sizeof(c_ir_function));
+
+    if (!function) {
+        EXIT_WITH_ERROR("Failed to allocate memory for ir function\n");
+    }
+
+    function->name = strdup(name);
+    function->instructions = NULL;
+    function->blocks = NULL;
+
+    return function;
+}
+
+int c_ir_function_add_block(c_ir_function *function) {
+    c_ir_block block = {0};
+    block.immediate_dominator = -1;
+    arrput(function->blocks, block);
+    return (int)arrlen(function->blocks) - 1;
+}
+
+c_ir_instruction c_ir_make(c_ir_opcode opcode, int lhs, int rhs) {
+    c_ir_instruction instruction = {0};
+    instruction.opcode = opcode;
+    instruction.operands[0] = lhs;
+    instruction.operands[1] = rhs;
+    instruction.targets[0] = -1;
+    instruction.targets[1] = -1;
+    return instruction;
+}
+
+c_ir_instruction c_ir_make_constant(int value) {
+    c_ir_instruction instruction =
+        c_ir_make(C_IR_CONSTANT, C_IR_NO_VALUE, C_IR_NO_VALUE);
+    instruction.constant = value;
+    return instruction;
+}
+
+c_ir_instruction c_ir_make_call(const char *function_name) {
+    c_ir_instruction instruction =
+        c_ir_make(C_IR_CALL, C_IR_NO_VALUE, C_IR_NO_VALUE);
+    instruction.function_name = strdup(function_name);
+    return instruction;
+}
+
+c_ir_instruction c_ir_make_jump(int target) {
+    c_ir_instruction instruction =
+        c_ir_make(C_IR_JUMP, C_IR_NO_VALUE, C_IR_NO_VALUE);
+    instruction.targets[0] = target;
+    return instruction;
+}
+
+c_ir_instruction c_ir_make_branch(int condition, int then_block,
+                                  int else_block) {
+    c_ir_instruction instruction =
+        c_ir_make(C_IR_BRANCH, condition, C_IR_NO_VALUE);
+    instruction.targets[0] = then_block;
+    instruction.targets[1] = else_block;
+    return instruction;
+}
+
+int c_ir_function_insert(c_ir_function *function,
+                         int block,
+                         int position,
+                         c_ir_instruction instruction) {
+    instruction.block = block;
+    arrput(function->instructions, instruction);
+
+    int value = (int)arrlen(function->instructions) - 1;
+    arrins(function->blocks[block].instructions, position, value);
+
+    return value;
+}
+
+int c_ir_function_append(c_ir_function *function,
+                         int block,
+                         c_ir_instruction instruction) {
+    return c_ir_function_insert(
+        function,
+        block,
+        (int)arrlen(function->blocks[block].instructions),
+        instruction);
+}
+
+void c_ir_function_remove(c_ir_function *function, int value) {
+    c_ir_instruction *instruction = &function->instructions[value];
+    c_ir_block *block = &function->blocks[instruction->block];
+
+    for (int i = 0; i < arrlen(block->instructions); i++) {
+        if (block->instructions[i] == value) {
+            arrdel(block->instructions, i);
+            break;
+        }
+    }
+
+    arrfree(instruction->phi_operands);
+    instruction->opcode = C_IR_NOP;
+}
+
+int c_ir_type_size(c_ir_type type) {
+    switch (type) {
+        case C_IR_TYPE_I32:
+            return 4;
+        case C_IR_TYPE_I64:
+            return 8;
+        default:
+            EXIT_WITH_ERROR("Got unsupported ir type: %d\n", type);
+    }
+}
+
+int c_ir_is_terminator(c_ir_opcode opcode) {
+    return opcode == C_IR_JUMP || opcode == C_IR_BRANCH
+           || opcode == C_IR_RETURN;
+}
+
+int c_ir_is_binary(c_ir_opcode opcode) {
+    switch (opcode) {
+        case C_IR_ADD:
+        case C_IR_SUBTRACT:
+        case C_IR_MULTIPLY:
+        case C_IR_DIVIDE:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+int c_ir_block_terminator(c_ir_function *function, int block) {
+    int *instructions = function->blocks[block].instructions;
+    int length = (int)arrlen(instructions);
+
+    if (length == 0) {
+        return C_IR_NO_VALUE;
+    }
+
+    int last = instructions[length - 1];
+
+    if (!c_ir_is_terminator(function->instructions[last].opcode)) {
+        return C_IR_NO_VALUE;
+    }
+
+    return last;
+}
+
+int c_ir_value_operands(c_ir_instruction *instruction, int operands[2]) {
+    int count = 0;
+
+    switch (instruction->opcode) {
+        case C_IR_STORE:
+            operands[count++] = instruction->operands[1];
+            break;
+        case C_IR_BRANCH:
+        case C_IR_RETURN:
+            if (instruction->operands[0] != C_IR_NO_VALUE) {
+                operands[count++] = instruction->operands[0];
+            }
+            break;
+        default:
+            if (c_ir_is_binary(instruction->opcode)) {
+                operands[count++] = instruction->operands[0];
+                operands[count++] = instruction->operands[1];
+            }
+            break;
+    }
+
+    return count;
+}
+
+int *c_ir_use_counts(c_ir_function *function) {
+    int *counts = NULL;
+
+    for (int i = 0; i < arrlen(function->instructions); i++) {
+        arrput(counts, 0);
+    }
+
+    for (int b = 0; b < arrlen(function->blocks); b++) {
+        int *instructions = function->blocks[b].instructions;
+
+        for (int i = 0; i < arrlen(instructions); i++) {
+            c_ir_instruction *instruction =
+                &function->instructions[instructions[i]];
+            int operands[2];
+            int count = c_ir_value_operands(instruction, operands);
+
+            for (int o = 0; o < count; o++) {
+                counts[operands[o]]++;
+            }
+
+            for (int p = 0; p < arrlen(instruction->phi_operands); p++) {
+                counts[instruction->phi_operands[p].value]++;
+            }
+        }
+    }
+
+    return counts;
+}
+
+int c_ir_is_tail_call(c_ir_function *function, int value, int *use_counts) {
+    int *instructions =
+        function->blocks[function->instructions[value].block].instructions;
+    int i = 0;
+
+    while (instructions[i] != value) {
+        i++;
+    }
+
+    for (i++; i < arrlen(instructions); i++) {
+        int next = instructions[i];
+        c_ir_instruction *instruction = &function->instructions[next];
+
+        switch (instruction->opcode) {
+            case C_IR_NOP:
+            case C_IR_CONSTANT:
+            case C_IR_ALLOCA:
+                continue;
+            case C_IR_RETURN:
+                if (instruction->operands[0] == value) {
+                    return use_counts[value] == 1;
+                }
+
+                return instruction->operands[0] == C_IR_NO_VALUE
+                       && use_counts[value] == 0;
+            case C_IR_LOAD:
+                if (use_counts[next] == 0) {
+                    continue;
+                }
+                return 0;
+            default:
+                if (c_ir_is_binary(instruction->opcode)
+                    && use_counts[next] == 0) {
+                    continue;
+                }
+                return 0;
+        }
+    }
+
+    return 0;
+}
+
+void c_ir_function_compute_cfg(c_ir_function *function) {
+    for (int i = 0; i < arrlen(function->blocks); i++) {
+        arrfree(function->blocks[i].predecessors);
+        arrfree(function->blocks[i].successors);
+    }
+
+    for (int i = 0; i < arrlen(function->blocks); i++) {
+        int terminator = c_ir_block_terminator(function, i);
+
+        if (terminator == C_IR_NO_VALUE) {
+            continue;
+        }
+
+        c_ir_instruction *instruction = &function->instructions[terminator];
+
+        for (int t = 0; t < 2; t++) {
+            int target = instruction->targets[t];
+
+            if (target < 0) {
+                continue;
+            }
+
+            arrput(function->blocks[i].successors, target);
+            arrput(function->blocks[target].predecessors, i);
+        }
+    }
+}
+
+static int c_ir_alloca_is_used(c_ir_function *function, int alloca_value) {
+    for (int b = 0; b < arrlen(function->blocks); b++) {
+        int *instructions = function->blocks[b].instructions;
+
+        for (int i = 0; i < arrlen(instructions); i++) {
+            c_ir_instruction *instruction =
+                &function->instructions[instructions[i]];
+
+            if ((instruction->opcode == C_IR_LOAD
+                 || instruction->opcode == C_IR_STORE)
+                && instruction->operands[0] == alloca_value) {
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+int c_ir_function_remove_unreachable(c_ir_function *function) {
+    int blocks_count = (int)arrlen(function->blocks);
+
+    if (blocks_count == 0) {
+        return 0;
+    }
+
+    int *is_reachable = calloc(blocks_count, sizeof(int));
+    int *stack = NULL;
+    int removed = 0;
+
+    is_reachable[0] = 1;
+    arrput(stack, 0);
+
+    while (arrlen(stack) > 0) {
+        int block = arrlast(stack);
+        arrsetlen(stack, arrlenu(stack) - 1);
+
+        for (int i = 0; i < arrlen(function->blocks[block].successors); i++) {
+            int successor = function->blocks[block].successors[i];
+
+            if (!is_reachable[successor]) {
+                is_reachable[successor] = 1;
+                arrput(stack, successor);
+            }
+        }
+    }
+
+    arrfree(stack);
+
+    for (int b = 0; b < blocks_count; b++) {
+        int **instructions = &function->blocks[b].instructions;
+
+        while (!is_reachable[b] && arrlen(*instructions) > 0) {
+            c_ir_function_remove(function, arrlast(*instructions));
+            removed++;
+        }
+    }
+
+    if (removed == 0) {
+        free(is_reachable);
+        return 0;
+    }
+
+    // NOTE: phis forget the removed edges, locals that were
+    // only used after a return lose their slot
+    int *entry = function->blocks[0].instructions;
+
+    for (int i = (int)arrlen(entry) - 1; i >= 0; i--) {
+        c_ir_instruction *instruction = &function->instructions[entry[i]];
+
+        if (instruction->opcode == C_IR_ALLOCA
+            && !c_ir_alloca_is_used(function, entry[i])) {
+            c_ir_function_remove(function, entry[i]);
+            entry = function->blocks[0].instructions;
+            removed++;
+        }
+    }
+
+    for (int v = 0; v < arrlen(function->instructions); v++) {
+        c_ir_phi_operand **phi_operands =
+            &function->instructions[v].phi_operands;
+
+        for (int p = (int)arrlen(*phi_operands) - 1; p >= 0; p--) {
+            if (!is_reachable[(*phi_operands)[p].block]) {
+                arrdel(*phi_operands, p);
+            }
+        }
+    }
+
+    free(is_reachable);
+    c_ir_function_compute_cfg(function);
+
+    return removed;
+}
+
+int c_ir_module_find_function(c_ir_module *module, const char *name) {
+    for (int i = 0; i < arrlen(module->functions); i++) {
+        if (strcmp(module->functions[i]->name, name) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void c_ir_mark_reachable_functions(c_ir_module *module,
+                                          int index,
+                                          int *is_reachable) {
+    c_ir_function *function = module->functions[index];
+
+    is_reachable[index] = 1;
+
+    for (int v = 0; v < arrlen(function->instructions); v++) {
+        if (function->instructions[v].opcode != C_IR_CALL) {
+            continue;
+        }
+
+        int callee = c_ir_module_find_function(
+            module, function->instructions[v].function_name);
+
+        if (callee != -1 && !is_reachable[callee]) {
+            c_ir_mark_reachable_functions(module, callee, is_reachable);
+        }
+    }
+}
+
+int c_ir_module_remove_dead_functions(c_ir_module *module, const char *entry) {
+    int root = c_ir_module_find_function(module, entry);
+
+    if (root == -1) {
+        return 0;
+    }
+
+    int count = (int)arrlen(module->functions);
+    int *is_reachable = calloc(count, sizeof(int));
+    int kept = 0;
+
+    c_ir_mark_reachable_functions(module, root, is_reachable);
+
+    for (int i = 0; i < count; i++) {
+        if (is_reachable[i]) {
+            module->functions[kept++] = module->functions[i];
+        } else {
+            c_ir_function_free(module->functions[i]);
+        }
+    }
+
+    free(is_reachable);
+    arrsetlen(module->functions, (size_t)kept);
+
+    return count - kept;
+}
+
+static void c_ir_builder_push_scope(c_ir_builder *builder) {
+    arrput(builder->scope_starts, (int)arrlen(builder->locals));
+}
+
+static void c_ir_builder_pop_scope(c_ir_builder *builder) {
+    int start = arrlast(builder->scope_starts);
+    arrsetlen(builder->scope_starts, arrlenu(builder->scope_starts) - 1);
+    arrsetlen(builder->locals, (size_t)start);
+}
+
+static int c_ir_builder_lookup(c_ir_builder *builder, const char *name) {
+    for (int i = (int)arrlen(builder->locals) - 1; i >= 0; i--) {
+        if (strcmp(builder->locals[i].name, name) == 0) {
+            return builder->locals[i].alloca_value;
+        }
+    }
+
+    return C_IR_NO_VALUE;
+}
+
+static int c_ir_builder_emit(c_ir_builder *builder,
+                             c_ir_instruction instruction) {
+    // NOTE: code after a return opens a block without predecessors
+    if (builder->current_block == -1) {
+        builder->current_block = c_ir_function_add_block(builder->function);
+    }
+
+    return c_ir_function_append(
+        builder->function, builder->current_block, instruction);
+}
+
+// NOTE: Sethi-Ullman label, constants are immediates
+// so they do not need a register of their own
+int c_ir_expression_register_need(c_ast_expression *expression) {
+    switch (expression->type) {
+        case C_CONSTANT:
+            return 0;
+        case C_FUNCTION_CALL:
+        case C_VARIABLE:
+            return 1;
+        case C_BINARY_EXPRESSION: {
+            int lhs = c_ir_expression_register_need(expression->binary->lhs);
+            int rhs = c_ir_expression_register_need(expression->binary->rhs);
+            int need = lhs == rhs ? lhs + 1 : (lhs > rhs ? lhs : rhs);
+
+            return need > 1 ? need : 1;
+        }
+        default:
+            EXIT_WITH_ERROR("Got unsupported type for register need: %d\n",
+                            expression->type);
+    }
+}
+
+static int c_ir_lower_expression(c_ir_builder *builder,
+                                 c_ast_expression *expression) {
+    switch (expression->type) {
+        case C_CONSTANT:
+            return c_ir_builder_emit(
+                builder, c_ir_make_constant(expression->constant->value));
+        case C_FUNCTION_CALL:
+            return c_ir_builder_emit(
+                builder,
+                c_ir_make_call(expression->function_call->function_name));
+        case C_VARIABLE: {
+            int alloca_value =
+                c_ir_builder_lookup(builder, expression->variable->name);
+
+            if (alloca_value == C_IR_NO_VALUE) {
+                EXIT_WITH_ERROR("Use of undeclared variable: %s\n",
+                                expression->variable->name);
+            }
+
+            c_ir_instruction load =
+                c_ir_make(C_IR_LOAD, alloca_value, C_IR_NO_VALUE);
+            load.type = builder->function->instructions[alloca_value].type;
+
+            return c_ir_builder_emit(builder, load);
+        }
+        case C_BINARY_EXPRESSION: {
+            c_ir_opcode opcode;
+
+            switch (expression->binary->symbol) {
+                case '+':
+                    opcode = C_IR_ADD;
+                    break;
+                case '-':
+                    opcode = C_IR_SUBTRACT;
+                    break;
+                case '*':
+                    opcode = C_IR_MULTIPLY;
+                    break;
+                case '/':
+                    opcode = C_IR_DIVIDE;
+                    break;
+                default:
+                    EXIT_WITH_ERROR(
+                        "Received inproper binary operator symbol: %c\n",
+                        expression->binary->symbol);
+            }
+
+            int lhs;
+            int rhs;
+
+            // NOTE: C leaves the operand order unspecified, evaluating the
+            // heavier side first keeps fewer temporaries alive at once
+            if (c_ir_expression_register_need(expression->binary->rhs)
+                > c_ir_expression_register_need(expression->binary->lhs)) {
+                rhs = c_ir_lower_expression(builder, expression->binary->rhs);
+                lhs = c_ir_lower_expression(builder, expression->binary->lhs);
+
+                if (opcode == C_IR_ADD || opcode == C_IR_MULTIPLY) {
+                    int tmp = lhs;
+                    lhs = rhs;
+                    rhs = tmp;
+                }
+            } else {
+                lhs = c_ir_lower_expression(builder, expression->binary->lhs);
+                rhs = c_ir_lower_expression(builder, expression->binary->rhs);
+            }
+
+            return c_ir_builder_emit(builder, c_ir_make(opcode, lhs, rhs));
+        }
+        default:
+            EXIT_WITH_ERROR("Got unsupported type for expression lowering: %d\n",
+                            expression->type);
+    }
+}
+
+static void c_ir_lower_block(c_ir_builder *builder, c_ast_block *block);
+
+static void c_ir_lower_statement(c_ir_builder *builder,
+                                 c_ast_statement *statement) {
+    switch (statement->type) {
+        case C_STATEMENT_BLOCK:
+            c_ir_lower_block(builder, statement->block);
+            break;
+        case C_STATEMENT_RETURN: {
+            int value = C_IR_NO_VALUE;
+
+            if (statement->return_statement->value) {
+                value = c_ir_lower_expression(
+                    builder, statement->return_statement->value);
+            }
+
+            c_ir_builder_emit(builder,
+                              c_ir_make(C_IR_RETURN, value, C_IR_NO_VALUE));
+            builder->current_block = -1;
+            break;
+        }
+        // NOTE: lowered on its own, it sees none of the enclosing
+        // locals and is only entered through calls
+        case C_STATEMENT_FUNCTION_DECLARATION:
+            c_ir_lower_function_declaration(builder->module,
+                                            statement->function_declaration);
+            break;
+        case C_STATEMENT_EXPRESSION:
+            c_ir_lower_expression(builder, statement->expression);
+            break;
+        case C_STATEMENT_ASSIGNMENT: {
+            // NOTE: allocas live at the start of the entry block,
+            // so every local gets exactly one slot
+            c_ir_instruction alloca_instruction =
+                c_ir_make(C_IR_ALLOCA, C_IR_NO_VALUE, C_IR_NO_VALUE);
+            alloca_instruction.variable_name =
+                strdup(statement->assignment->variable_name);
+
+            int alloca_value = c_ir_function_insert(builder->function,
+                                                    0,
+                                                    builder->allocas_count,
+                                                    alloca_instruction);
+            builder->allocas_count++;
+
+            c_ir_local local = {.name = statement->assignment->variable_name,
+                                .alloca_value = alloca_value};
+            arrput(builder->locals, local);
+
+            if (statement->assignment->expression) {
+                int value = c_ir_lower_expression(
+                    builder, statement->assignment->expression);
+                c_ir_builder_emit(builder,
+                                  c_ir_make(C_IR_STORE, alloca_value, value));
+            }
+            break;
+        }
+        case C_STATEMENT_NOOP:
+            break;
+        default:
+            EXIT_WITH_ERROR("Got unsupported type for statement lowering: %d\n",
+                            statement->type);
+    }
+}
+
+static void c_ir_lower_block(c_ir_builder *builder, c_ast_block *block) {
+    c_ir_builder_push_scope(builder);
+
+    for (int i = 0; i < arrlen(block->statements); i++) {
+        c_ir_lower_statement(builder, block->statements[i]);
+    }
+
+    c_ir_builder_pop_scope(builder);
+}
+
+void c_ir_lower_function_declaration(
+    c_ir_module *module,
+    c_ast_function_declaration *function_declaration) {
+    // NOTE: calls and dead function removal find functions by name,
+    // a second body under the same name would never be reached
+    if (c_ir_module_find_function(module, function_declaration->function_name)
+        != -1) {
+        EXIT_WITH_ERROR("Redefinition of function: %s\n",
+                        function_declaration->function_name);
+    }
+
+    c_ir_builder builder = {0};
+    builder.module = module;
+    builder.function = c_ir_function_create(function_declaration->function_name);
+    arrput(module->functions, builder.function);
+    builder.current_block = c_ir_function_add_block(builder.function);
+
+    c_ir_lower_block(&builder, function_declaration->body);
+
+    // NOTE: falling off the end returns whatever is in the
+    // return register, same as before
+    if (builder.current_block != -1
+        && c_ir_block_terminator(builder.function, builder.current_block)
+               == C_IR_NO_VALUE) {
+        c_ir_builder_emit(&builder,
+                          c_ir_make(C_IR_RETURN, C_IR_NO_VALUE, C_IR_NO_VALUE));
+    }
+
+    arrfree(builder.locals);
+    arrfree(builder.scope_starts);
+
+    c_ir_function_compute_cfg(builder.function);
+    c_ir_function_remove_unreachable(builder.function);
+}
+
+c_ir_module *c_ir_lower_program(c_ast_program *program) {
+    c_ir_module *module = malloc(sizeof(c_ir_module));
+
+    if (!module) {
+        EXIT_WITH_ERROR("Failed to allocate memory for ir module\n");
+    }
+
+    module->functions = NULL;
+
+    for (int i = 0; i < arrlen(program->function_declarations); i++) {
+        c_ir_lower_function_declaration(module,
+                                        program->function_declarations[i]);
+    }
+
+    return module;
+}
+
+const char *c_ir_opcode_to_string(c_ir_opcode opcode) {
+    switch (opcode) {
+        case C_IR_CONSTANT:
+            return "const";
+        case C_IR_ALLOCA:
+            return "alloca";
+        case C_IR_LOAD:
+            return "load";
+        case C_IR_STORE:
+            return "store";
+        case C_IR_ADD:
+            return "add";
+        case C_IR_SUBTRACT:
+            return "sub";
+        case C_IR_MULTIPLY:
+            return "mul";
+        case C_IR_DIVIDE:
+            return "div";
+        case C_IR_CALL:
+            return "call";
+        case C_IR_PHI:
+            return "phi";
+        case C_IR_JUMP:
+            return "jmp";
+        case C_IR_BRANCH:
+            return "br";
+        case C_IR_RETURN:
+            return "ret";
+        case C_IR_NOP:
+            return "nop";
+    }
+
+    return "?";
+}
+
+static char *c_ir_print_instruction(c_ir_function *function, int value) {
+    c_ir_instruction *instruction = &function->instructions[value];
+    char *line = malloc(MAX_IR_LINE_LENGTH);
+    const char *name = c_ir_opcode_to_string(instruction->opcode);
+
+    switch (instruction->opcode) {
+        case C_IR_CONSTANT:
+            snprintf(line, MAX_IR_LINE_LENGTH, "    %%%d = const %d", value,
+                     instruction->constant);
+            break;
+        case C_IR_ALLOCA:
+            snprintf(line, MAX_IR_LINE_LENGTH, "    %%%d = alloca %s", value,
+                     instruction->variable_name);
+            break;
+        case C_IR_LOAD:
+            snprintf(line, MAX_IR_LINE_LENGTH, "    %%%d = load %%%d", value,
+                     instruction->operands[0]);
+            break;
+        case C_IR_STORE:
+            snprintf(line, MAX_IR_LINE_LENGTH, "    store %%%d, %%%d",
+                     instruction->operands[0], instruction->operands[1]);
+            break;
+        case C_IR_CALL:
+            snprintf(line, MAX_IR_LINE_LENGTH, "    %%%d = call %s", value,
+                     instruction->function_name);
+            break;
+        case C_IR_PHI: {
+            int length = snprintf(line, MAX_IR_LINE_LENGTH, "    %%%d = phi",
+                                  value);
+
+            for (int i = 0; i < arrlen(instruction->phi_operands)
+                            && length < MAX_IR_LINE_LENGTH;
+                 i++) {
+                length += snprintf(line + length,
+                                   MAX_IR_LINE_LENGTH - length,
+                                   "%s [.L%d, %%%d]",
+                                   i == 0 ? "" : ",",
+                                   instruction->phi_operands[i].block,
+                                   instruction->phi_operands[i].value);
+            }
+            break;
+        }
+        case C_IR_JUMP:
+            snprintf(line, MAX_IR_LINE_LENGTH, "    jmp .L%d",
+                     instruction->targets[0]);
+            break;
+        case C_IR_BRANCH:
+            snprintf(line, MAX_IR_LINE_LENGTH, "    br %%%d, .L%d, .L%d",
+                     instruction->operands[0], instruction->targets[0],
+                     instruction->targets[1]);
+            break;
+        case C_IR_RETURN:
+            if (instruction->operands[0] == C_IR_NO_VALUE) {
+                snprintf(line, MAX_IR_LINE_LENGTH, "    ret");
+            } else {
+                snprintf(line, MAX_IR_LINE_LENGTH, "    ret %%%d",
+                         instruction->operands[0]);
+            }
+            break;
+        default:
+            snprintf(line, MAX_IR_LINE_LENGTH, "    %%%d = %s %%%d, %%%d",
+                     value, name, instruction->operands[0],
+                     instruction->operands[1]);
+            break;
+    }
+
+    return line;
+}
+
+char **c_ir_print_function(c_ir_function *function) {
+    char **lines = NULL;
+
+    size_t length = strlen(function->name) + 2;
+    char *function_label = malloc(length);
+    snprintf(function_label, length, "%s:", function->name);
+    arrput(lines, function_label);
+
+    for (int b = 0; b < arrlen(function->blocks); b++) {
+        char *block_label = malloc(MAX_IR_LINE_LENGTH);
+        snprintf(block_label, MAX_IR_LINE_LENGTH, ".L%d:", b);
+        arrput(lines, block_label);
+
+        for (int i = 0; i < arrlen(function->blocks[b].instructions); i++) {
+            arrput(lines,
+                   c_ir_print_instruction(
+                       function, function->blocks[b].instructions[i]));
+        }
+    }
+
+    return lines;
+}
+
+void c_ir_function_free(c_ir_function *function) {
+    if (!function) {
+        return;
+    }
+
+    for (int i = 0; i < arrlen(function->instructions); i++) {
+        free(function->instructions[i].function_name);
+        free(function->instructions[i].variable_name);
+        arrfree(function->instructions[i].phi_operands);
+    }
+
+    for (int i = 0; i < arrlen(function->blocks); i++) {
+        arrfree(function->blocks[i].instructions);
+        arrfree(function->blocks[i].predecessors);
+        arrfree(function->blocks[i].successors);
+        arrfree(function->blocks[i].dominator_children);
+        arrfree(function->blocks[i].dominance_frontier);
+    }
+
+    arrfree(function->instructions);
+    arrfree(function->blocks);
+    free(function->name);
+    free(function);
+}
+
+void c_ir_module_free(c_ir_module *module) {
+    if (!module) {
+        return;
+    }
+
+    for (int i = 0; i < arrlen(module->functions); i++) {
+        c_ir_function_free(module->functions[i]);
+    }
+
+    arrfree(module->functions);
+    free(module);
+}
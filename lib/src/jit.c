@@ -0,0 +1,62 @@
+// NOTE: mmap, mprotect and MAP_ANONYMOUS are not part of C11
+#define _DEFAULT_SOURCE
+
+#include "jit.h"
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "stb_ds.h"
+#include "utils.h"
+
+typedef int (*c_jit_function)(void);
+
+int c_jit_run(c_asm_object *object, const char *entry) {
+    int symbol = c_asm_find_symbol(object, entry);
+
+    if (symbol == -1 || !object->symbols[symbol].is_defined) {
+        EXIT_WITH_ERROR("Undefined entry symbol %s\n", entry);
+    }
+
+    long page = sysconf(_SC_PAGESIZE);
+    size_t size = ((size_t)arrlen(object->text) + page - 1) / page * page;
+    uint8_t *memory = mmap(
+        NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (memory == MAP_FAILED) {
+        EXIT_WITH_ERROR("Failed to map memory for jit\n");
+    }
+
+    memcpy(memory, object->text, arrlen(object->text));
+
+    // NOTE: pc relative, S + A - P, the code never moves
+    // so these are the same values the linker would write
+    for (int i = 0; i < arrlen(object->relocations); i++) {
+        c_asm_relocation *relocation = &object->relocations[i];
+        c_asm_symbol *target = &object->symbols[relocation->symbol];
+
+        if (!target->is_defined) {
+            EXIT_WITH_ERROR("Undefined reference to %s\n", target->name);
+        }
+
+        int32_t value =
+            (int32_t)(target->offset + relocation->addend - relocation->offset);
+        memcpy(memory + relocation->offset, &value, sizeof(value));
+    }
+
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, size);
+        EXIT_WITH_ERROR("Failed to make jit memory executable\n");
+    }
+
+    // NOTE: object to function pointer casts are not portable C,
+    // copying the address is
+    c_jit_function function;
+    uint8_t *address = memory + object->symbols[symbol].offset;
+    memcpy(&function, &address, sizeof(function));
+
+    int result = function();
+    munmap(memory, size);
+
+    return result;
+}
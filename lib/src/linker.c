@@ -0,0 +1,50 @@
+#include "linker.h"
+#include "elf64.h"
+#include "stb_ds.h"
+#include "utils.h"
+
+static void c_link_patch32(uint8_t *text, int64_t offset, int64_t value) {
+    for (int i = 0; i < 4; i++) {
+        text[offset + i] = (uint8_t)((uint64_t)value >> (8 * i));
+    }
+}
+
+uint8_t *c_link_executable(c_asm_object *object) {
+    uint64_t text_address = C_LINK_BASE_ADDRESS + c_elf64_executable_text_offset();
+    int entry = c_asm_find_symbol(object, C_LINK_ENTRY);
+
+    if (entry == -1 || !object->symbols[entry].is_defined) {
+        EXIT_WITH_ERROR("Undefined entry symbol %s\n", C_LINK_ENTRY);
+    }
+
+    uint8_t *text = NULL;
+
+    for (int i = 0; i < arrlen(object->text); i++) {
+        arrput(text, object->text[i]);
+    }
+
+    // NOTE: pc relative, S + A - P
+    for (int i = 0; i < arrlen(object->relocations); i++) {
+        c_asm_relocation *relocation = &object->relocations[i];
+        c_asm_symbol *symbol = &object->symbols[relocation->symbol];
+
+        if (!symbol->is_defined) {
+            EXIT_WITH_ERROR("Undefined reference to %s\n", symbol->name);
+        }
+
+        int64_t value =
+            symbol->offset + relocation->addend - relocation->offset;
+
+        if (value < INT32_MIN || value > INT32_MAX) {
+            EXIT_WITH_ERROR("Relocation to %s out of range\n", symbol->name);
+        }
+
+        c_link_patch32(text, relocation->offset, value);
+    }
+
+    uint8_t *bytes = c_elf64_write_executable(
+        text, C_LINK_BASE_ADDRESS, text_address + object->symbols[entry].offset);
+    arrfree(text);
+
+    return bytes;
+}
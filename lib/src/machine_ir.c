@@ -0,0 +1,341 @@
+#include "machine_ir.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stb_ds.h"
+#include "str.h"
+#include "utils.h"
+
+#define MAX_LINE_LENGTH 128
+#define MAX_LABEL_LENGTH 128
+
+c_mir_function *c_mir_function_create(const char *name) {
+    c_mir_function *function = calloc(1, sizeof(c_mir_function));
+
+    if (!function) {
+        EXIT_WITH_ERROR("Failed to allocate memory for machine function\n");
+    }
+
+    c_mir_begin_block(function, c_mir_label(function, "%s", name));
+
+    return function;
+}
+
+void c_mir_function_free(c_mir_function *function) {
+    if (!function) {
+        return;
+    }
+
+    for (int i = 0; i < arrlen(function->labels); i++) {
+        free(function->labels[i]);
+    }
+
+    for (int i = 0; i < arrlen(function->blocks); i++) {
+        arrfree(function->blocks[i].instructions);
+    }
+
+    arrfree(function->labels);
+    arrfree(function->blocks);
+    free(function);
+}
+
+void c_mir_module_free(c_mir_module *module) {
+    if (!module) {
+        return;
+    }
+
+    for (int i = 0; i < arrlen(module->globals); i++) {
+        free(module->globals[i]);
+    }
+
+    for (int i = 0; i < arrlen(module->functions); i++) {
+        c_mir_function_free(module->functions[i]);
+    }
+
+    arrfree(module->globals);
+    arrfree(module->functions);
+    free(module);
+}
+
+int c_mir_label(c_mir_function *function, const char *format, ...) {
+    char name[MAX_LABEL_LENGTH];
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(name, sizeof(name), format, args);
+    va_end(args);
+
+    for (int i = 0; i < arrlen(function->labels); i++) {
+        if (strcmp(function->labels[i], name) == 0) {
+            return i;
+        }
+    }
+
+    arrput(function->labels, strdup(name));
+    return (int)arrlen(function->labels) - 1;
+}
+
+void c_mir_begin_block(c_mir_function *function, int label) {
+    c_mir_block block = {.label = label, .instructions = NULL};
+    arrput(function->blocks, block);
+}
+
+void c_mir_append(c_mir_function *function, c_mir_instruction instruction) {
+    arrput(arrlast(function->blocks).instructions, instruction);
+}
+
+c_mir_operand c_mir_register(c_x86_register reg, int size) {
+    c_mir_operand operand = {.kind = C_MIR_REGISTER, .size = size};
+    operand.reg = reg;
+    return operand;
+}
+
+c_mir_operand c_mir_immediate(int64_t value) {
+    c_mir_operand operand = {.kind = C_MIR_IMMEDIATE, .size = 0};
+    operand.immediate = value;
+    return operand;
+}
+
+c_mir_operand c_mir_memory(c_x86_register base,
+                           c_x86_register index,
+                           int scale,
+                           int displacement,
+                           int size) {
+    c_mir_operand operand = {.kind = C_MIR_MEMORY, .size = size};
+    operand.memory.base = base;
+    operand.memory.index = index;
+    operand.memory.scale = scale;
+    operand.memory.displacement = displacement;
+    return operand;
+}
+
+c_mir_operand c_mir_label_operand(int label) {
+    c_mir_operand operand = {.kind = C_MIR_LABEL, .size = 0};
+    operand.label = label;
+    return operand;
+}
+
+c_mir_instruction c_mir_make0(c_mir_opcode opcode) {
+    c_mir_instruction instruction = {.opcode = opcode, .operands_count = 0};
+    return instruction;
+}
+
+c_mir_instruction c_mir_make1(c_mir_opcode opcode, c_mir_operand operand) {
+    c_mir_instruction instruction = c_mir_make0(opcode);
+    instruction.operands[instruction.operands_count++] = operand;
+    return instruction;
+}
+
+c_mir_instruction c_mir_make2(c_mir_opcode opcode,
+                              c_mir_operand destination,
+                              c_mir_operand source) {
+    c_mir_instruction instruction = c_mir_make1(opcode, destination);
+    instruction.operands[instruction.operands_count++] = source;
+    return instruction;
+}
+
+c_mir_instruction c_mir_make3(c_mir_opcode opcode,
+                              c_mir_operand destination,
+                              c_mir_operand source,
+                              c_mir_operand immediate) {
+    c_mir_instruction instruction = c_mir_make2(opcode, destination, source);
+    instruction.operands[instruction.operands_count++] = immediate;
+    return instruction;
+}
+
+int c_mir_operand_equal(c_mir_operand a, c_mir_operand b) {
+    if (a.kind != b.kind || a.size != b.size) {
+        return 0;
+    }
+
+    switch (a.kind) {
+        case C_MIR_NONE:
+            return 1;
+        case C_MIR_REGISTER:
+            return a.reg == b.reg;
+        case C_MIR_IMMEDIATE:
+            return a.immediate == b.immediate;
+        case C_MIR_MEMORY:
+            return a.memory.base == b.memory.base
+                   && a.memory.index == b.memory.index
+                   && a.memory.scale == b.memory.scale
+                   && a.memory.displacement == b.memory.displacement;
+        case C_MIR_LABEL:
+            return a.label == b.label;
+        default:
+            EXIT_WITH_ERROR("Got unknown machine operand kind: %d\n", a.kind);
+    }
+}
+
+int c_mir_is_register(c_mir_operand operand) {
+    return operand.kind == C_MIR_REGISTER;
+}
+
+int c_mir_is_memory(c_mir_operand operand) {
+    return operand.kind == C_MIR_MEMORY;
+}
+
+const char *c_mir_opcode_to_string(c_mir_opcode opcode) {
+    static const char *names[C_MIR_OPCODES_COUNT] = {
+        [C_MIR_MOV] = "mov",   [C_MIR_LEA] = "lea",
+        [C_MIR_ADD] = "add",   [C_MIR_SUB] = "sub",
+        [C_MIR_IMUL] = "imul", [C_MIR_AND] = "and",
+        [C_MIR_XOR] = "xor",   [C_MIR_DIV] = "div",
+        [C_MIR_NEG] = "neg",   [C_MIR_SHL] = "shl",
+        [C_MIR_SHR] = "shr",   [C_MIR_SAR] = "sar",
+        [C_MIR_CMP] = "cmp",   [C_MIR_TEST] = "test",
+        [C_MIR_MUL] = "mul",   [C_MIR_IDIV] = "idiv",
+        [C_MIR_CDQ] = "cdq",   [C_MIR_CQO] = "cqo",
+        [C_MIR_PUSH] = "push", [C_MIR_POP] = "pop",
+        [C_MIR_CALL] = "call", [C_MIR_JMP] = "jmp",
+        [C_MIR_JZ] = "jz",     [C_MIR_JNZ] = "jnz",
+        [C_MIR_RET] = "ret",   [C_MIR_SYSCALL] = "syscall",
+    };
+
+    if (opcode < 0 || opcode >= C_MIR_OPCODES_COUNT) {
+        EXIT_WITH_ERROR("Got invalid machine opcode: %d\n", opcode);
+    }
+
+    return names[opcode];
+}
+
+static void c_mir_print_address(c_mir_address *address,
+                                char *buffer,
+                                size_t size) {
+    size_t length = snprintf(buffer, size, "[");
+
+    if (address->base != C_X86_NO_REGISTER) {
+        length += snprintf(buffer + length,
+                           size - length,
+                           "%s",
+                           c_x86_register_name(address->base));
+    }
+
+    if (address->index != C_X86_NO_REGISTER) {
+        length += snprintf(buffer + length,
+                           size - length,
+                           "%s%s",
+                           address->base != C_X86_NO_REGISTER ? "+" : "",
+                           c_x86_register_name(address->index));
+
+        if (address->scale > 1) {
+            length += snprintf(
+                buffer + length, size - length, "*%d", address->scale);
+        }
+    }
+
+    if (address->displacement != 0) {
+        length += snprintf(
+            buffer + length, size - length, "%+d", address->displacement);
+    }
+
+    snprintf(buffer + length, size - length, "]");
+}
+
+const char *c_mir_print_operand(c_mir_function *function,
+                                c_mir_operand operand,
+                                char *buffer) {
+    switch (operand.kind) {
+        case C_MIR_REGISTER:
+            snprintf(buffer,
+                     C_MIR_MAX_OPERAND_LENGTH,
+                     "%s",
+                     c_x86_register_name_sized(operand.reg, operand.size));
+            break;
+        case C_MIR_IMMEDIATE:
+            snprintf(buffer,
+                     C_MIR_MAX_OPERAND_LENGTH,
+                     "%lld",
+                     (long long)operand.immediate);
+            break;
+        case C_MIR_MEMORY: {
+            // NOTE: lea only computes the address, it has no size
+            int length = 0;
+
+            if (operand.size != 0) {
+                length = snprintf(buffer,
+                                  C_MIR_MAX_OPERAND_LENGTH,
+                                  "%s ",
+                                  operand.size == 8 ? "qword" : "dword");
+            }
+
+            c_mir_print_address(&operand.memory,
+                                buffer + length,
+                                C_MIR_MAX_OPERAND_LENGTH - length);
+            break;
+        }
+        case C_MIR_LABEL:
+            snprintf(buffer,
+                     C_MIR_MAX_OPERAND_LENGTH,
+                     "%s",
+                     function->labels[operand.label]);
+            break;
+        default:
+            EXIT_WITH_ERROR("Got unknown machine operand kind: %d\n",
+                            operand.kind);
+    }
+
+    return buffer;
+}
+
+char *c_mir_print_instruction(c_mir_function *function,
+                              c_mir_instruction *instruction) {
+    char *line = malloc(MAX_LINE_LENGTH);
+    int length = snprintf(line,
+                          MAX_LINE_LENGTH,
+                          "    %s",
+                          c_mir_opcode_to_string(instruction->opcode));
+
+    for (int i = 0; i < instruction->operands_count; i++) {
+        char operand[C_MIR_MAX_OPERAND_LENGTH];
+
+        length += snprintf(
+            line + length,
+            MAX_LINE_LENGTH - length,
+            "%s%s",
+            i == 0 ? " " : ", ",
+            c_mir_print_operand(function, instruction->operands[i], operand));
+    }
+
+    return line;
+}
+
+void c_mir_print_function(c_mir_function *function, char ***lines) {
+    for (int b = 0; b < arrlen(function->blocks); b++) {
+        c_mir_block *block = &function->blocks[b];
+
+        if (block->label == C_MIR_NO_LABEL) {
+            arrput(*lines, strdup(""));
+        } else {
+            char *label = malloc(MAX_LABEL_LENGTH + 1);
+            snprintf(label,
+                     MAX_LABEL_LENGTH + 1,
+                     "%s:",
+                     function->labels[block->label]);
+            arrput(*lines, label);
+        }
+
+        for (int i = 0; i < arrlen(block->instructions); i++) {
+            arrput(*lines,
+                   c_mir_print_instruction(function, &block->instructions[i]));
+        }
+    }
+
+    arrput(*lines, strdup(""));
+}
+
+void c_mir_print_module(c_mir_module *module, char ***lines) {
+    for (int i = 0; i < arrlen(module->globals); i++) {
+        char *line = malloc(MAX_LABEL_LENGTH + 8);
+        snprintf(line, MAX_LABEL_LENGTH + 8, "global %s", module->globals[i]);
+        arrput(*lines, line);
+    }
+
+    arrput(*lines, strdup(""));
+    arrput(*lines, strdup("section .text"));
+
+    for (int i = 0; i < arrlen(module->functions); i++) {
+        c_mir_print_function(module->functions[i], lines);
+    }
+}
@@ -3,6 +3,7 @@
 #include <float.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "error.h"
 #include "lexer.h"
 #include "utils.h"
@@ -25,6 +26,7 @@ c_parser *c_parser_create(c_token *tokens,
     parser->tokens = tokens;
     parser->error_context = error_context;
     parser->filename = filename;
+    parser->function_names = NULL;
 
     return parser;
 }
@@ -308,6 +310,7 @@ c_ast_expression *c_parser_parse_expression_with_precedence(
             break;
         }
 
+        c_token operator_token = parser->current_token;
         c_parser_advance(parser);
 
         c_ast_expression *rhs =
@@ -341,6 +344,8 @@ c_ast_expression *c_parser_parse_expression_with_precedence(
 
         binary_expr->binary->lhs = lhs;
         binary_expr->binary->rhs = rhs;
+        binary_expr->binary->line = operator_token.line;
+        binary_expr->binary->column = operator_token.column;
         lhs = binary_expr;
     }
 
@@ -442,6 +447,25 @@ c_ast_block *c_parser_parse_block(c_parser *parser) {
     return block;
 }
 
+// NOTE: calls resolve by name alone, so a nested function may not
+// shadow or be shadowed by another function
+static void c_parser_declare_function(c_parser *parser, c_token name) {
+    for (int i = 0; i < arrlen(parser->function_names); i++) {
+        if (strcmp(parser->function_names[i], name.string) == 0) {
+            char message[256];
+            snprintf(message,
+                     sizeof(message),
+                     "Redefinition of function '%s'",
+                     name.string);
+            c_error_report_with_token(
+                parser->error_context, message, name, parser->filename);
+            return;
+        }
+    }
+
+    arrput(parser->function_names, strdup(name.string));
+}
+
 c_ast_function_declaration *c_parser_parse_function_declaration(
     c_parser *parser) {
     LOG_DEBUG("Parsing function declaration\n");
@@ -461,6 +485,7 @@ c_ast_function_declaration *c_parser_parse_function_declaration(
     }
 
     function_declaration->function_name = strdup(parser->current_token.string);
+    c_parser_declare_function(parser, parser->current_token);
 
     c_parser_advance(parser);
 
@@ -563,6 +588,11 @@ void c_parser_free(c_parser *parser) {
         return;
     }
 
+    for (int i = 0; i < arrlen(parser->function_names); i++) {
+        free(parser->function_names[i]);
+    }
+
+    arrfree(parser->function_names);
     c_lexer_free_tokens(parser->tokens);
     free(parser);
 }
@@ -0,0 +1,259 @@
+#include "peephole.h"
+#include <stdlib.h>
+#include "stb_ds.h"
+#include "utils.h"
+
+static c_mir_instruction *c_peephole_at(c_peephole_stream *stream,
+                                        int index) {
+    return &stream->entries[index].instruction;
+}
+
+static void c_peephole_replace(c_peephole_stream *stream,
+                               int index,
+                               c_mir_instruction instruction) {
+    stream->entries[index].instruction = instruction;
+}
+
+static void c_peephole_delete(c_peephole_stream *stream, int index) {
+    arrdel(stream->entries, index);
+}
+
+static int c_peephole_is(c_peephole_stream *stream,
+                         int index,
+                         c_mir_opcode opcode,
+                         int operands_count) {
+    c_peephole_entry *entry = &stream->entries[index];
+
+    return entry->kind == C_PEEPHOLE_INSTRUCTION
+           && entry->instruction.opcode == opcode
+           && entry->instruction.operands_count == operands_count;
+}
+
+static int c_peephole_is_zero(c_mir_operand operand) {
+    return operand.kind == C_MIR_IMMEDIATE && operand.immediate == 0;
+}
+
+static int c_peephole_is_condition(c_mir_opcode opcode) {
+    return opcode == C_MIR_JZ || opcode == C_MIR_JNZ;
+}
+
+static int c_peephole_writes_flags(c_mir_opcode opcode) {
+    switch (opcode) {
+        case C_MIR_ADD:
+        case C_MIR_SUB:
+        case C_MIR_IMUL:
+        case C_MIR_IDIV:
+        case C_MIR_NEG:
+        case C_MIR_XOR:
+        case C_MIR_AND:
+        case C_MIR_CMP:
+        case C_MIR_TEST:
+        case C_MIR_SHL:
+        case C_MIR_SAR:
+        case C_MIR_SHR:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// NOTE: flags set by the instruction at index are dead when they are
+// overwritten or control leaves before anything reads them
+static int c_peephole_flags_dead_after(c_peephole_stream *stream, int index) {
+    for (int i = index + 1; i < arrlen(stream->entries); i++) {
+        c_peephole_entry *entry = &stream->entries[i];
+
+        if (entry->kind == C_PEEPHOLE_SEPARATOR) {
+            continue;
+        }
+
+        c_mir_opcode opcode = entry->instruction.opcode;
+
+        if (entry->kind == C_PEEPHOLE_LABEL
+            || c_peephole_is_condition(opcode)) {
+            return 0;
+        }
+
+        if (c_peephole_writes_flags(opcode) || opcode == C_MIR_JMP
+            || opcode == C_MIR_RET || opcode == C_MIR_CALL) {
+            return 1;
+        }
+    }
+
+    return 1;
+}
+
+static int c_peephole_move_back(c_peephole_stream *stream, int *window) {
+    if (!c_peephole_is(stream, window[0], C_MIR_MOV, 2)
+        || !c_peephole_is(stream, window[1], C_MIR_MOV, 2)) {
+        return 0;
+    }
+
+    c_mir_instruction *first = c_peephole_at(stream, window[0]);
+    c_mir_instruction *second = c_peephole_at(stream, window[1]);
+
+    if (!c_mir_operand_equal(first->operands[0], second->operands[1])
+        || !c_mir_operand_equal(first->operands[1], second->operands[0])) {
+        return 0;
+    }
+
+    c_peephole_delete(stream, window[1]);
+    return 1;
+}
+
+static int c_peephole_zero_idiom(c_peephole_stream *stream, int *window) {
+    c_mir_instruction *move = c_peephole_at(stream, window[0]);
+
+    // NOTE: xor clobbers flags where mov does not
+    if (!c_peephole_is(stream, window[0], C_MIR_MOV, 2)
+        || !c_mir_is_register(move->operands[0])
+        || !c_peephole_is_zero(move->operands[1])
+        || !c_peephole_flags_dead_after(stream, window[0])) {
+        return 0;
+    }
+
+    c_mir_operand reg = c_mir_register(move->operands[0].reg, 4);
+    c_peephole_replace(stream, window[0], c_mir_make2(C_MIR_XOR, reg, reg));
+    return 1;
+}
+
+static int c_peephole_add_zero(c_peephole_stream *stream, int *window) {
+    if ((!c_peephole_is(stream, window[0], C_MIR_ADD, 2)
+         && !c_peephole_is(stream, window[0], C_MIR_SUB, 2))
+        || !c_peephole_is_zero(c_peephole_at(stream, window[0])->operands[1])
+        || !c_peephole_flags_dead_after(stream, window[0])) {
+        return 0;
+    }
+
+    c_peephole_delete(stream, window[0]);
+    return 1;
+}
+
+static const c_peephole_rule c_peephole_rules[] = {
+    {"move-back", 2, c_peephole_move_back},
+    {"zero-idiom", 1, c_peephole_zero_idiom},
+    {"add-zero", 1, c_peephole_add_zero},
+};
+
+int c_peephole_rules_count(void) {
+    return (int)(sizeof(c_peephole_rules) / sizeof(c_peephole_rules[0]));
+}
+
+const c_peephole_rule *c_peephole_rule_at(int index) {
+    if (index < 0 || index >= c_peephole_rules_count()) {
+        EXIT_WITH_ERROR("Got invalid peephole rule: %d\n", index);
+    }
+
+    return &c_peephole_rules[index];
+}
+
+static int c_peephole_is_separator(c_peephole_stream *stream, int index) {
+    return stream->entries[index].kind == C_PEEPHOLE_SEPARATOR;
+}
+
+static int c_peephole_collect_window(c_peephole_stream *stream,
+                                     int index,
+                                     int size,
+                                     int *window) {
+    int count = 0;
+
+    for (int i = index; i < arrlen(stream->entries) && count < size; i++) {
+        if (!c_peephole_is_separator(stream, i)) {
+            window[count++] = i;
+        }
+    }
+
+    return count == size;
+}
+
+static void c_peephole_flatten(c_peephole_stream *stream) {
+    c_mir_function *function = stream->function;
+
+    for (int b = 0; b < arrlen(function->blocks); b++) {
+        c_mir_block *block = &function->blocks[b];
+        c_peephole_entry start = {
+            .kind = block->label == C_MIR_NO_LABEL ? C_PEEPHOLE_SEPARATOR
+                                                   : C_PEEPHOLE_LABEL,
+            .label = block->label,
+        };
+        arrput(stream->entries, start);
+
+        for (int i = 0; i < arrlen(block->instructions); i++) {
+            c_peephole_entry entry = {
+                .kind = C_PEEPHOLE_INSTRUCTION,
+                .label = C_MIR_NO_LABEL,
+                .instruction = block->instructions[i],
+            };
+            arrput(stream->entries, entry);
+        }
+
+        arrfree(block->instructions);
+    }
+
+    arrfree(function->blocks);
+}
+
+// NOTE: every block start is kept, a block can only lose instructions
+static void c_peephole_rebuild(c_peephole_stream *stream) {
+    for (int i = 0; i < arrlen(stream->entries); i++) {
+        c_peephole_entry *entry = &stream->entries[i];
+
+        if (entry->kind == C_PEEPHOLE_INSTRUCTION) {
+            c_mir_append(stream->function, entry->instruction);
+        } else {
+            c_mir_begin_block(stream->function, entry->label);
+        }
+    }
+}
+
+int c_peephole_optimize_function(c_mir_function *function, int *fires) {
+    c_peephole_stream stream = {.function = function, .entries = NULL};
+    int total = 0;
+    int index = 0;
+
+    c_peephole_flatten(&stream);
+
+    while (index < arrlen(stream.entries)) {
+        int fired = 0;
+
+        if (!c_peephole_is_separator(&stream, index)) {
+            for (int r = 0; r < c_peephole_rules_count() && !fired; r++) {
+                int window[C_PEEPHOLE_MAX_WINDOW];
+
+                if (!c_peephole_collect_window(
+                        &stream, index, c_peephole_rules[r].window, window)) {
+                    continue;
+                }
+
+                if (c_peephole_rules[r].rewrite(&stream, window)) {
+                    fired = 1;
+                    total++;
+
+                    if (fires) {
+                        fires[r]++;
+                    }
+                }
+            }
+        }
+
+        if (!fired) {
+            index++;
+            continue;
+        }
+
+        // NOTE: a rewrite can complete a pattern that
+        // starts a few instructions earlier
+        for (int back = 0; back < C_PEEPHOLE_MAX_WINDOW && index > 0;) {
+            index--;
+
+            if (!c_peephole_is_separator(&stream, index)) {
+                back++;
+            }
+        }
+    }
+
+    c_peephole_rebuild(&stream);
+    arrfree(stream.entries);
+
+    return total;
+}
@@ -0,0 +1,279 @@
+#include "range_analysis.h"
+#include <stdlib.h>
+#include "ssa.h"
+#include "stb_ds.h"
+#include "utils.h"
+
+static c_range c_range_empty(void) {
+    c_range range = {.min = 1, .max = 0};
+    return range;
+}
+
+c_range c_range_full(c_ir_type type) {
+    c_range range;
+
+    switch (type) {
+        case C_IR_TYPE_I32:
+            range.min = INT32_MIN;
+            range.max = INT32_MAX;
+            break;
+        case C_IR_TYPE_I64:
+            range.min = INT64_MIN;
+            range.max = INT64_MAX;
+            break;
+        default:
+            EXIT_WITH_ERROR("Got unsupported ir type: %d\n", type);
+    }
+
+    return range;
+}
+
+c_range c_range_constant(int64_t value) {
+    c_range range = {.min = value, .max = value};
+    return range;
+}
+
+int c_range_is_empty(c_range range) {
+    return range.min > range.max;
+}
+
+int c_range_is_non_negative(c_range range) {
+    return !c_range_is_empty(range) && range.min >= 0;
+}
+
+c_range c_range_union(c_range a, c_range b) {
+    if (c_range_is_empty(a)) {
+        return b;
+    }
+
+    if (c_range_is_empty(b)) {
+        return a;
+    }
+
+    c_range range = {
+        .min = a.min < b.min ? a.min : b.min,
+        .max = a.max > b.max ? a.max : b.max,
+    };
+    return range;
+}
+
+static int c_range_fits_32(c_range range) {
+    return range.min >= INT32_MIN && range.max <= INT32_MAX;
+}
+
+static c_range c_range_of_corners(int64_t *corners, int count) {
+    c_range range = c_range_constant(corners[0]);
+
+    for (int i = 1; i < count; i++) {
+        range = c_range_union(range, c_range_constant(corners[i]));
+    }
+
+    return range;
+}
+
+// NOTE: divisor has one sign, quotients move monotonically
+// with either operand so the corners bound every quotient
+static c_range c_range_divide_by(c_range lhs, int64_t low, int64_t high) {
+    int64_t corners[4] = {
+        lhs.min / low,
+        lhs.min / high,
+        lhs.max / low,
+        lhs.max / high,
+    };
+
+    return c_range_of_corners(corners, 4);
+}
+
+c_range c_range_of_binary(c_ir_opcode opcode,
+                          c_ir_type type,
+                          c_range lhs,
+                          c_range rhs) {
+    if (c_range_is_empty(lhs) || c_range_is_empty(rhs)) {
+        return c_range_empty();
+    }
+
+    // NOTE: 32 bit bounds can not overflow the 64 bit arithmetic below
+    if (!c_range_fits_32(lhs) || !c_range_fits_32(rhs)) {
+        return c_range_full(type);
+    }
+
+    c_range range;
+
+    switch (opcode) {
+        case C_IR_ADD:
+            range.min = lhs.min + rhs.min;
+            range.max = lhs.max + rhs.max;
+            break;
+        case C_IR_SUBTRACT:
+            range.min = lhs.min - rhs.max;
+            range.max = lhs.max - rhs.min;
+            break;
+        case C_IR_MULTIPLY: {
+            int64_t corners[4] = {
+                lhs.min * rhs.min,
+                lhs.min * rhs.max,
+                lhs.max * rhs.min,
+                lhs.max * rhs.max,
+            };
+            range = c_range_of_corners(corners, 4);
+            break;
+        }
+        case C_IR_DIVIDE:
+            // NOTE: a zero divisor traps, only the others give a value
+            range = c_range_empty();
+
+            if (rhs.min < 0) {
+                range = c_range_union(
+                    range,
+                    c_range_divide_by(
+                        lhs, rhs.min, rhs.max < 0 ? rhs.max : -1));
+            }
+
+            if (rhs.max > 0) {
+                range = c_range_union(
+                    range,
+                    c_range_divide_by(
+                        lhs, rhs.min > 0 ? rhs.min : 1, rhs.max));
+            }
+
+            if (c_range_is_empty(range)) {
+                return c_range_full(type);
+            }
+            break;
+        default:
+            EXIT_WITH_ERROR("Got unsupported opcode for ranges: %d\n", opcode);
+    }
+
+    c_range bounds = c_range_full(type);
+
+    if (range.min < bounds.min || range.max > bounds.max) {
+        return bounds;
+    }
+
+    return range;
+}
+
+static c_range c_range_of_instruction(c_ir_function *function,
+                                      c_range *ranges,
+                                      int value) {
+    c_ir_instruction *instruction = &function->instructions[value];
+
+    switch (instruction->opcode) {
+        case C_IR_CONSTANT:
+            return c_range_constant(instruction->constant);
+        case C_IR_LOAD:
+        case C_IR_CALL:
+            return c_range_full(instruction->type);
+        case C_IR_PHI: {
+            c_range range = c_range_empty();
+
+            for (int p = 0; p < arrlen(instruction->phi_operands); p++) {
+                range = c_range_union(
+                    range, ranges[instruction->phi_operands[p].value]);
+            }
+
+            return range;
+        }
+        default:
+            if (c_ir_is_binary(instruction->opcode)) {
+                return c_range_of_binary(instruction->opcode,
+                                         instruction->type,
+                                         ranges[instruction->operands[0]],
+                                         ranges[instruction->operands[1]]);
+            }
+
+            return c_range_empty();
+    }
+}
+
+c_range *c_range_analyze(c_ir_function *function) {
+    int count = (int)arrlen(function->instructions);
+    c_range *ranges = NULL;
+    int *visits = calloc(count ? count : 1, sizeof(int));
+
+    if (!visits) {
+        EXIT_WITH_ERROR("Failed to allocate memory for range analysis\n");
+    }
+
+    for (int v = 0; v < count; v++) {
+        arrput(ranges, c_range_empty());
+    }
+
+    if (arrlen(function->blocks) == 0) {
+        free(visits);
+        return ranges;
+    }
+
+    // NOTE: without back edges one pass in reverse postorder sees
+    // every operand first, loops repeat until the phis settle
+    int *order = c_ssa_reverse_postorder(function);
+    int changed = 1;
+
+    while (changed) {
+        changed = 0;
+
+        for (int o = 0; o < arrlen(order); o++) {
+            int *instructions = function->blocks[order[o]].instructions;
+
+            for (int i = 0; i < arrlen(instructions); i++) {
+                int value = instructions[i];
+                c_ir_instruction *instruction = &function->instructions[value];
+                c_range range = c_range_of_instruction(function, ranges, value);
+
+                if (instruction->opcode == C_IR_PHI
+                    && visits[value] > C_RANGE_MAX_VISITS) {
+                    range = c_range_full(instruction->type);
+                }
+
+                if (range.min == ranges[value].min
+                    && range.max == ranges[value].max) {
+                    continue;
+                }
+
+                if (instruction->opcode == C_IR_PHI) {
+                    visits[value]++;
+                }
+
+                ranges[value] = range;
+                changed = 1;
+            }
+        }
+    }
+
+    arrfree(order);
+    free(visits);
+
+    return ranges;
+}
+
+int c_range_simplify_function(c_ir_function *function) {
+    c_range *ranges = c_range_analyze(function);
+    int simplified = 0;
+
+    for (int v = 0; v < arrlen(function->instructions); v++) {
+        c_ir_instruction *instruction = &function->instructions[v];
+
+        if (!c_ir_is_binary(instruction->opcode)
+            || ranges[v].min != ranges[v].max) {
+            continue;
+        }
+
+        c_range divisor = ranges[instruction->operands[1]];
+
+        if (instruction->opcode == C_IR_DIVIDE
+            && (c_range_is_empty(divisor)
+                || (divisor.min <= 0 && divisor.max >= 0))) {
+            continue;
+        }
+
+        instruction->opcode = C_IR_CONSTANT;
+        instruction->constant = (int)ranges[v].min;
+        instruction->operands[0] = C_IR_NO_VALUE;
+        instruction->operands[1] = C_IR_NO_VALUE;
+        simplified++;
+    }
+
+    arrfree(ranges);
+
+    return simplified;
+}
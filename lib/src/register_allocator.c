@@ -0,0 +1,429 @@
+#include "register_allocator.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+#include "stb_ds.h"
+#include "utils.h"
+#include "x86.h"
+
+static const c_x86_register caller_saved_registers[] = {
+    C_X86_RCX, C_X86_RSI, C_X86_RDI, C_X86_R8, C_X86_R9, C_X86_R10,
+};
+
+static const c_x86_register callee_saved_registers[] = {
+    C_X86_RBX, C_X86_R12, C_X86_R13, C_X86_R14, C_X86_R15,
+};
+
+#define CALLER_SAVED_COUNT \
+    (int)(sizeof(caller_saved_registers) / sizeof(caller_saved_registers[0]))
+#define CALLEE_SAVED_COUNT \
+    (int)(sizeof(callee_saved_registers) / sizeof(callee_saved_registers[0]))
+
+int c_register_needs_location(c_ir_function *function, int value) {
+    switch (function->instructions[value].opcode) {
+        case C_IR_LOAD:
+        case C_IR_CALL:
+        case C_IR_PHI:
+            return 1;
+        default:
+            return c_ir_is_binary(function->instructions[value].opcode);
+    }
+}
+
+typedef struct {
+    c_ir_function *function;
+    int values_count;
+    int blocks_count;
+    unsigned char *tracked;
+    unsigned char *live_in;
+    unsigned char *live_out;
+} c_liveness;
+
+static int c_liveness_is_tracked(c_liveness *liveness, int value) {
+    return value != C_IR_NO_VALUE && liveness->tracked[value];
+}
+
+// NOTE: classic backward dataflow, phi operands are live out
+// of the predecessor they come from, not live into the phi block
+static void c_liveness_compute(c_liveness *liveness) {
+    c_ir_function *function = liveness->function;
+    int n = liveness->values_count;
+    unsigned char *scratch = malloc(n);
+    int changed = 1;
+
+    while (changed) {
+        changed = 0;
+
+        for (int b = liveness->blocks_count - 1; b >= 0; b--) {
+            c_ir_block *block = &function->blocks[b];
+            unsigned char *out = liveness->live_out + (size_t)b * n;
+            unsigned char *in = liveness->live_in + (size_t)b * n;
+
+            memset(scratch, 0, n);
+
+            for (int s = 0; s < arrlen(block->successors); s++) {
+                int successor = block->successors[s];
+                unsigned char *successor_in =
+                    liveness->live_in + (size_t)successor * n;
+
+                for (int v = 0; v < n; v++) {
+                    scratch[v] |= successor_in[v];
+                }
+
+                int *instructions = function->blocks[successor].instructions;
+
+                for (int i = 0; i < arrlen(instructions); i++) {
+                    c_ir_instruction *phi = &function->instructions[instructions[i]];
+
+                    if (phi->opcode != C_IR_PHI) {
+                        break;
+                    }
+
+                    scratch[instructions[i]] = 0;
+
+                    for (int p = 0; p < arrlen(phi->phi_operands); p++) {
+                        int operand = phi->phi_operands[p].value;
+
+                        if (phi->phi_operands[p].block == b
+                            && c_liveness_is_tracked(liveness, operand)) {
+                            scratch[operand] = 1;
+                        }
+                    }
+                }
+            }
+
+            memcpy(out, scratch, n);
+
+            for (int i = (int)arrlen(block->instructions) - 1; i >= 0; i--) {
+                int value = block->instructions[i];
+                c_ir_instruction *instruction = &function->instructions[value];
+                int operands[2];
+                int count = c_ir_value_operands(instruction, operands);
+
+                scratch[value] = 0;
+
+                for (int o = 0; o < count; o++) {
+                    if (c_liveness_is_tracked(liveness, operands[o])) {
+                        scratch[operands[o]] = 1;
+                    }
+                }
+            }
+
+            if (memcmp(in, scratch, n) != 0) {
+                memcpy(in, scratch, n);
+                changed = 1;
+            }
+        }
+    }
+
+    free(scratch);
+}
+
+static void c_interval_extend(c_live_interval *intervals,
+                              int *interval_of,
+                              int value,
+                              int position) {
+    c_live_interval *interval = &intervals[interval_of[value]];
+
+    if (position < interval->start) {
+        interval->start = position;
+    }
+    if (position > interval->end) {
+        interval->end = position;
+    }
+}
+
+c_live_interval *c_register_build_intervals(c_ir_function *function,
+                                            int *positions) {
+    c_liveness liveness = {0};
+    liveness.function = function;
+    liveness.values_count = (int)arrlen(function->instructions);
+    liveness.blocks_count = (int)arrlen(function->blocks);
+
+    int n = liveness.values_count;
+    int *use_counts = c_ir_use_counts(function);
+    liveness.tracked = calloc(n, 1);
+    liveness.live_in = calloc((size_t)n * liveness.blocks_count + 1, 1);
+    liveness.live_out = calloc((size_t)n * liveness.blocks_count + 1, 1);
+
+    c_live_interval *intervals = NULL;
+    int *interval_of = malloc(sizeof(int) * (n + 1));
+
+    for (int v = 0; v < n; v++) {
+        interval_of[v] = -1;
+
+        if (function->instructions[v].opcode != C_IR_NOP
+            && c_register_needs_location(function, v) && use_counts[v] > 0) {
+            liveness.tracked[v] = 1;
+            interval_of[v] = (int)arrlen(intervals);
+
+            c_live_interval interval = {.value = v,
+                                        .start = INT_MAX,
+                                        .end = -1,
+                                        .crosses_call = 0,
+                                        .reg = C_X86_NO_REGISTER};
+            arrput(intervals, interval);
+        }
+    }
+
+    c_liveness_compute(&liveness);
+
+    int *block_start = malloc(sizeof(int) * (liveness.blocks_count + 1));
+    int *block_end = malloc(sizeof(int) * (liveness.blocks_count + 1));
+    int *calls = NULL;
+    int position = 0;
+
+    for (int b = 0; b < liveness.blocks_count; b++) {
+        block_start[b] = position;
+        position += 2;
+
+        for (int i = 0; i < arrlen(function->blocks[b].instructions); i++) {
+            int value = function->blocks[b].instructions[i];
+            positions[value] = position;
+
+            if (function->instructions[value].opcode == C_IR_CALL) {
+                arrput(calls, position);
+            }
+
+            position += 2;
+        }
+
+        block_end[b] = position;
+        position += 2;
+    }
+
+    for (int b = 0; b < liveness.blocks_count; b++) {
+        unsigned char *in = liveness.live_in + (size_t)b * n;
+        unsigned char *out = liveness.live_out + (size_t)b * n;
+
+        for (int v = 0; v < n; v++) {
+            if (in[v]) {
+                c_interval_extend(intervals, interval_of, v, block_start[b]);
+            }
+            if (out[v]) {
+                c_interval_extend(intervals, interval_of, v, block_end[b]);
+            }
+        }
+
+        for (int i = 0; i < arrlen(function->blocks[b].instructions); i++) {
+            int value = function->blocks[b].instructions[i];
+            c_ir_instruction *instruction = &function->instructions[value];
+            int operands[2];
+            int count = c_ir_value_operands(instruction, operands);
+
+            if (liveness.tracked[value]) {
+                c_interval_extend(
+                    intervals, interval_of, value, positions[value]);
+
+                // NOTE: phis are written by the copies at the end
+                // of every predecessor
+                for (int p = 0; p < arrlen(instruction->phi_operands); p++) {
+                    c_interval_extend(intervals,
+                                      interval_of,
+                                      value,
+                                      block_end[instruction->phi_operands[p]
+                                                    .block]);
+                }
+            }
+
+            for (int o = 0; o < count; o++) {
+                if (c_liveness_is_tracked(&liveness, operands[o])) {
+                    c_interval_extend(
+                        intervals, interval_of, operands[o], positions[value]);
+                }
+            }
+
+            for (int p = 0; p < arrlen(instruction->phi_operands); p++) {
+                int operand = instruction->phi_operands[p].value;
+
+                if (c_liveness_is_tracked(&liveness, operand)) {
+                    c_interval_extend(intervals,
+                                      interval_of,
+                                      operand,
+                                      block_end[instruction->phi_operands[p]
+                                                    .block]);
+                }
+            }
+        }
+    }
+
+    // NOTE: a value defined before a call and used after it
+    // would be clobbered by the callee
+    for (int i = 0; i < arrlen(intervals); i++) {
+        for (int c = 0; c < arrlen(calls); c++) {
+            if (intervals[i].start < calls[c] && calls[c] < intervals[i].end) {
+                intervals[i].crosses_call = 1;
+                break;
+            }
+        }
+    }
+
+    free(block_start);
+    free(block_end);
+    free(interval_of);
+    free(liveness.tracked);
+    free(liveness.live_in);
+    free(liveness.live_out);
+    arrfree(calls);
+    arrfree(use_counts);
+
+    return intervals;
+}
+
+static int c_interval_compare_start(const void *a, const void *b) {
+    const c_live_interval *lhs = a;
+    const c_live_interval *rhs = b;
+
+    if (lhs->start != rhs->start) {
+        return lhs->start < rhs->start ? -1 : 1;
+    }
+
+    return lhs->value - rhs->value;
+}
+
+static c_x86_register c_register_take_free(int *free_registers,
+                                           int crosses_call) {
+    if (!crosses_call) {
+        for (int i = 0; i < CALLER_SAVED_COUNT; i++) {
+            if (free_registers[caller_saved_registers[i]]) {
+                return caller_saved_registers[i];
+            }
+        }
+    }
+
+    for (int i = 0; i < CALLEE_SAVED_COUNT; i++) {
+        if (free_registers[callee_saved_registers[i]]) {
+            return callee_saved_registers[i];
+        }
+    }
+
+    return C_X86_NO_REGISTER;
+}
+
+// NOTE: Poletto and Sarkar, when nothing is free the interval that
+// ends last is spilled
+static void c_register_linear_scan(c_live_interval *intervals) {
+    int free_registers[C_X86_REGISTERS_COUNT] = {0};
+    int *active = NULL;
+
+    for (int i = 0; i < CALLER_SAVED_COUNT; i++) {
+        free_registers[caller_saved_registers[i]] = 1;
+    }
+    for (int i = 0; i < CALLEE_SAVED_COUNT; i++) {
+        free_registers[callee_saved_registers[i]] = 1;
+    }
+
+    for (int i = 0; i < arrlen(intervals); i++) {
+        c_live_interval *current = &intervals[i];
+
+        for (int a = 0; a < arrlen(active);) {
+            c_live_interval *old = &intervals[active[a]];
+
+            if (old->end <= current->start) {
+                free_registers[old->reg] = 1;
+                arrdel(active, a);
+            } else {
+                a++;
+            }
+        }
+
+        current->reg =
+            c_register_take_free(free_registers, current->crosses_call);
+
+        if (current->reg != C_X86_NO_REGISTER) {
+            free_registers[current->reg] = 0;
+            arrput(active, i);
+            continue;
+        }
+
+        int victim = -1;
+
+        for (int a = 0; a < arrlen(active); a++) {
+            c_live_interval *candidate = &intervals[active[a]];
+
+            if (current->crosses_call && !c_x86_is_callee_saved(candidate->reg)) {
+                continue;
+            }
+
+            if (victim == -1 || candidate->end > intervals[active[victim]].end) {
+                victim = a;
+            }
+        }
+
+        if (victim != -1 && intervals[active[victim]].end > current->end) {
+            c_live_interval *spilled = &intervals[active[victim]];
+            current->reg = spilled->reg;
+            spilled->reg = C_X86_NO_REGISTER;
+            arrdel(active, victim);
+            arrput(active, i);
+        }
+    }
+
+    arrfree(active);
+}
+
+c_register_allocation *c_register_allocate(c_ir_function *function) {
+    c_register_allocation *allocation = malloc(sizeof(c_register_allocation));
+
+    if (!allocation) {
+        EXIT_WITH_ERROR("Failed to allocate memory for register allocation\n");
+    }
+
+    int n = (int)arrlen(function->instructions);
+
+    allocation->registers = NULL;
+    allocation->positions = NULL;
+    allocation->saved_registers = NULL;
+    allocation->spilled_count = 0;
+
+    for (int v = 0; v < n; v++) {
+        arrput(allocation->registers, C_X86_NO_REGISTER);
+        arrput(allocation->positions, -1);
+    }
+
+    allocation->intervals =
+        c_register_build_intervals(function, allocation->positions);
+
+    if (arrlen(allocation->intervals) > 0) {
+        qsort(allocation->intervals,
+              arrlen(allocation->intervals),
+              sizeof(c_live_interval),
+              c_interval_compare_start);
+    }
+
+    c_register_linear_scan(allocation->intervals);
+
+    int used[C_X86_REGISTERS_COUNT] = {0};
+
+    for (int i = 0; i < arrlen(allocation->intervals); i++) {
+        c_live_interval *interval = &allocation->intervals[i];
+
+        if (interval->reg == C_X86_NO_REGISTER) {
+            allocation->spilled_count++;
+        } else {
+            allocation->registers[interval->value] = interval->reg;
+            used[interval->reg] = 1;
+        }
+    }
+
+    for (int i = 0; i < CALLEE_SAVED_COUNT; i++) {
+        if (used[callee_saved_registers[i]]) {
+            arrput(allocation->saved_registers, callee_saved_registers[i]);
+        }
+    }
+
+    return allocation;
+}
+
+void c_register_allocation_free(c_register_allocation *allocation) {
+    if (!allocation) {
+        return;
+    }
+
+    arrfree(allocation->registers);
+    arrfree(allocation->positions);
+    arrfree(allocation->intervals);
+    arrfree(allocation->saved_registers);
+    free(allocation);
+}
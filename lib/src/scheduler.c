@@ -0,0 +1,386 @@
+#include "scheduler.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stb_ds.h"
+#include "utils.h"
+
+// NOTE: one bit per register, the flags come after them
+#define C_SCHEDULE_FLAGS (1u << C_X86_REGISTERS_COUNT)
+
+// NOTE: latencies and reciprocal throughputs of the 32 bit register
+// forms from the published instruction tables of each core, generic
+// sits between them
+static const c_schedule_model c_schedule_models[] = {
+    {
+        .name = "generic",
+        .issue_width = 4,
+        .load_latency = 4,
+        .costs =
+            {
+                [C_MIR_MOV] = {1, 1},  [C_MIR_LEA] = {1, 1},
+                [C_MIR_ADD] = {1, 1},  [C_MIR_SUB] = {1, 1},
+                [C_MIR_AND] = {1, 1},  [C_MIR_XOR] = {1, 1},
+                [C_MIR_NEG] = {1, 1},  [C_MIR_SHL] = {1, 1},
+                [C_MIR_SHR] = {1, 1},  [C_MIR_SAR] = {1, 1},
+                [C_MIR_CMP] = {1, 1},  [C_MIR_TEST] = {1, 1},
+                [C_MIR_CDQ] = {1, 1},  [C_MIR_CQO] = {1, 1},
+                [C_MIR_IMUL] = {3, 1}, [C_MIR_MUL] = {4, 1},
+                [C_MIR_DIV] = {20, 6}, [C_MIR_IDIV] = {20, 6},
+            },
+    },
+    {
+        .name = "skylake",
+        .issue_width = 4,
+        .load_latency = 4,
+        .costs =
+            {
+                [C_MIR_MOV] = {1, 1},  [C_MIR_LEA] = {1, 1},
+                [C_MIR_ADD] = {1, 1},  [C_MIR_SUB] = {1, 1},
+                [C_MIR_AND] = {1, 1},  [C_MIR_XOR] = {1, 1},
+                [C_MIR_NEG] = {1, 1},  [C_MIR_SHL] = {1, 1},
+                [C_MIR_SHR] = {1, 1},  [C_MIR_SAR] = {1, 1},
+                [C_MIR_CMP] = {1, 1},  [C_MIR_TEST] = {1, 1},
+                [C_MIR_CDQ] = {1, 1},  [C_MIR_CQO] = {1, 1},
+                [C_MIR_IMUL] = {3, 1}, [C_MIR_MUL] = {4, 1},
+                [C_MIR_DIV] = {26, 6}, [C_MIR_IDIV] = {26, 6},
+            },
+    },
+    {
+        .name = "znver3",
+        .issue_width = 6,
+        .load_latency = 4,
+        .costs =
+            {
+                [C_MIR_MOV] = {1, 1},  [C_MIR_LEA] = {1, 1},
+                [C_MIR_ADD] = {1, 1},  [C_MIR_SUB] = {1, 1},
+                [C_MIR_AND] = {1, 1},  [C_MIR_XOR] = {1, 1},
+                [C_MIR_NEG] = {1, 1},  [C_MIR_SHL] = {1, 1},
+                [C_MIR_SHR] = {1, 1},  [C_MIR_SAR] = {1, 1},
+                [C_MIR_CMP] = {1, 1},  [C_MIR_TEST] = {1, 1},
+                [C_MIR_CDQ] = {1, 1},  [C_MIR_CQO] = {1, 1},
+                [C_MIR_IMUL] = {3, 1}, [C_MIR_MUL] = {3, 1},
+                [C_MIR_DIV] = {10, 6}, [C_MIR_IDIV] = {10, 6},
+            },
+    },
+};
+
+typedef struct {
+    uint32_t uses;
+    uint32_t defs;
+    // NOTE: the memory operand read or written, NULL without one
+    c_mir_operand *memory;
+    int loads;
+    int stores;
+    int latency;
+    int occupancy;
+} c_schedule_node;
+
+typedef struct {
+    int node;
+    int latency;
+} c_schedule_edge;
+
+const c_schedule_model *c_schedule_model_for(const char *name) {
+    int count = sizeof(c_schedule_models) / sizeof(c_schedule_models[0]);
+
+    for (int i = 0; i < count; i++) {
+        if (strcmp(c_schedule_models[i].name, name) == 0) {
+            return &c_schedule_models[i];
+        }
+    }
+
+    return NULL;
+}
+
+static int c_schedule_is_barrier(c_mir_opcode opcode) {
+    switch (opcode) {
+        case C_MIR_PUSH:
+        case C_MIR_POP:
+        case C_MIR_CALL:
+        case C_MIR_JMP:
+        case C_MIR_JZ:
+        case C_MIR_JNZ:
+        case C_MIR_RET:
+        case C_MIR_SYSCALL:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static uint32_t c_schedule_bit(c_x86_register reg) {
+    return reg == C_X86_NO_REGISTER ? 0 : 1u << reg;
+}
+
+static void c_schedule_read(c_schedule_node *node, c_mir_operand *operand) {
+    if (operand->kind == C_MIR_REGISTER) {
+        node->uses |= c_schedule_bit(operand->reg);
+    } else if (operand->kind == C_MIR_MEMORY) {
+        node->uses |= c_schedule_bit(operand->memory.base)
+                      | c_schedule_bit(operand->memory.index);
+        node->memory = operand;
+        node->loads = 1;
+    }
+}
+
+static void c_schedule_write(c_schedule_node *node, c_mir_operand *operand) {
+    if (operand->kind == C_MIR_REGISTER) {
+        node->defs |= c_schedule_bit(operand->reg);
+    } else if (operand->kind == C_MIR_MEMORY) {
+        node->uses |= c_schedule_bit(operand->memory.base)
+                      | c_schedule_bit(operand->memory.index);
+        node->memory = operand;
+        node->stores = 1;
+    }
+}
+
+static c_schedule_node c_schedule_analyze(c_mir_instruction *instruction,
+                                          const c_schedule_model *model) {
+    c_schedule_node node = {0};
+    c_mir_operand *operands = instruction->operands;
+    uint32_t rax = c_schedule_bit(C_X86_RAX);
+    uint32_t rdx = c_schedule_bit(C_X86_RDX);
+
+    switch (instruction->opcode) {
+        case C_MIR_MOV:
+            c_schedule_read(&node, &operands[1]);
+            c_schedule_write(&node, &operands[0]);
+            break;
+        case C_MIR_LEA:
+            // NOTE: only the address registers are read
+            node.uses |= c_schedule_bit(operands[1].memory.base)
+                         | c_schedule_bit(operands[1].memory.index);
+            c_schedule_write(&node, &operands[0]);
+            break;
+        case C_MIR_ADD:
+        case C_MIR_SUB:
+        case C_MIR_AND:
+        case C_MIR_XOR:
+        case C_MIR_SHL:
+        case C_MIR_SHR:
+        case C_MIR_SAR:
+            c_schedule_read(&node, &operands[0]);
+            c_schedule_read(&node, &operands[1]);
+            c_schedule_write(&node, &operands[0]);
+            node.defs |= C_SCHEDULE_FLAGS;
+            break;
+        case C_MIR_NEG:
+            c_schedule_read(&node, &operands[0]);
+            c_schedule_write(&node, &operands[0]);
+            node.defs |= C_SCHEDULE_FLAGS;
+            break;
+        case C_MIR_IMUL:
+            if (instruction->operands_count == 1) {
+                c_schedule_read(&node, &operands[0]);
+                node.uses |= rax;
+                node.defs |= rax | rdx;
+            } else {
+                if (instruction->operands_count == 2) {
+                    c_schedule_read(&node, &operands[0]);
+                }
+
+                c_schedule_read(&node, &operands[1]);
+                c_schedule_write(&node, &operands[0]);
+            }
+            node.defs |= C_SCHEDULE_FLAGS;
+            break;
+        case C_MIR_CMP:
+        case C_MIR_TEST:
+            c_schedule_read(&node, &operands[0]);
+            c_schedule_read(&node, &operands[1]);
+            node.defs |= C_SCHEDULE_FLAGS;
+            break;
+        case C_MIR_MUL:
+            c_schedule_read(&node, &operands[0]);
+            node.uses |= rax;
+            node.defs |= rax | rdx | C_SCHEDULE_FLAGS;
+            break;
+        case C_MIR_DIV:
+        case C_MIR_IDIV:
+            c_schedule_read(&node, &operands[0]);
+            node.uses |= rax | rdx;
+            node.defs |= rax | rdx | C_SCHEDULE_FLAGS;
+            break;
+        case C_MIR_CDQ:
+        case C_MIR_CQO:
+            node.uses |= rax;
+            node.defs |= rdx;
+            break;
+        default:
+            EXIT_WITH_ERROR("Got unschedulable machine opcode: %s\n",
+                            c_mir_opcode_to_string(instruction->opcode));
+    }
+
+    c_schedule_cost cost = model->costs[instruction->opcode];
+    node.latency = (cost.latency > 0 ? cost.latency : 1)
+                   + (node.loads ? model->load_latency : 0);
+    node.occupancy = cost.occupancy > 0 ? cost.occupancy : 1;
+
+    return node;
+}
+
+// NOTE: every frame slot is addressed from one base register, the
+// same base without an index only overlaps on overlapping bytes
+static int c_schedule_may_alias(c_mir_operand *a, c_mir_operand *b) {
+    if (a->memory.base != b->memory.base
+        || a->memory.index != C_X86_NO_REGISTER
+        || b->memory.index != C_X86_NO_REGISTER) {
+        return 1;
+    }
+
+    return a->memory.displacement < b->memory.displacement + b->size
+           && b->memory.displacement < a->memory.displacement + a->size;
+}
+
+// NOTE: -1 when a and b may be swapped, else the cycles b waits after a
+static int c_schedule_dependence(c_schedule_node *a, c_schedule_node *b) {
+    int latency = -1;
+
+    if (a->defs & b->uses) {
+        latency = a->latency;
+    } else if ((a->uses & b->defs) || (a->defs & b->defs)) {
+        latency = 0;
+    }
+
+    if (a->memory && b->memory && (a->stores || b->stores)
+        && c_schedule_may_alias(a->memory, b->memory)) {
+        int memory_latency = a->stores && b->loads ? a->latency : 0;
+
+        if (memory_latency > latency) {
+            latency = memory_latency;
+        }
+    }
+
+    return latency;
+}
+
+static void c_schedule_region(c_mir_instruction *instructions,
+                              int count,
+                              const c_schedule_model *model) {
+    c_schedule_node *nodes = malloc(count * sizeof(c_schedule_node));
+    c_schedule_edge **successors = calloc(count, sizeof(c_schedule_edge *));
+    int *predecessors = calloc(count, sizeof(int));
+    int *heights = calloc(count, sizeof(int));
+    int *earliest = calloc(count, sizeof(int));
+    int *done = calloc(count, sizeof(int));
+    c_mir_instruction *scheduled = malloc(count * sizeof(c_mir_instruction));
+
+    if (!nodes || !successors || !predecessors || !heights || !earliest
+        || !done || !scheduled) {
+        EXIT_WITH_ERROR("Failed to allocate memory for scheduling\n");
+    }
+
+    for (int i = 0; i < count; i++) {
+        nodes[i] = c_schedule_analyze(&instructions[i], model);
+    }
+
+    for (int i = 0; i < count; i++) {
+        for (int j = i + 1; j < count; j++) {
+            int latency = c_schedule_dependence(&nodes[i], &nodes[j]);
+
+            if (latency >= 0) {
+                c_schedule_edge edge = {.node = j, .latency = latency};
+                arrput(successors[i], edge);
+                predecessors[j]++;
+            }
+        }
+    }
+
+    // NOTE: the longest latency path to the end of the region,
+    // instructions on it go first
+    for (int i = count - 1; i >= 0; i--) {
+        heights[i] = nodes[i].latency;
+
+        for (int s = 0; s < arrlen(successors[i]); s++) {
+            c_schedule_edge edge = successors[i][s];
+            int height = edge.latency + heights[edge.node];
+
+            if (height > heights[i]) {
+                heights[i] = height;
+            }
+        }
+    }
+
+    int cycle = 0;
+    int divider_free = 0;
+    int scheduled_count = 0;
+
+    while (scheduled_count < count) {
+        for (int issued = 0; issued < model->issue_width; issued++) {
+            int best = -1;
+
+            for (int i = 0; i < count; i++) {
+                if (done[i] || predecessors[i] > 0 || earliest[i] > cycle
+                    || (nodes[i].occupancy > 1 && divider_free > cycle)) {
+                    continue;
+                }
+
+                if (best == -1 || heights[i] > heights[best]) {
+                    best = i;
+                }
+            }
+
+            if (best == -1) {
+                break;
+            }
+
+            done[best] = 1;
+            scheduled[scheduled_count++] = instructions[best];
+
+            if (nodes[best].occupancy > 1) {
+                divider_free = cycle + nodes[best].occupancy;
+            }
+
+            for (int s = 0; s < arrlen(successors[best]); s++) {
+                c_schedule_edge edge = successors[best][s];
+
+                predecessors[edge.node]--;
+
+                if (cycle + edge.latency > earliest[edge.node]) {
+                    earliest[edge.node] = cycle + edge.latency;
+                }
+            }
+        }
+
+        cycle++;
+    }
+
+    memcpy(instructions, scheduled, count * sizeof(c_mir_instruction));
+
+    for (int i = 0; i < count; i++) {
+        arrfree(successors[i]);
+    }
+
+    free(nodes);
+    free(successors);
+    free(predecessors);
+    free(heights);
+    free(earliest);
+    free(done);
+    free(scheduled);
+}
+
+void c_schedule_function(c_mir_function *function,
+                         const c_schedule_model *model) {
+    for (int b = 0; b < arrlen(function->blocks); b++) {
+        c_mir_instruction *instructions = function->blocks[b].instructions;
+        int count = (int)arrlen(instructions);
+        int start = 0;
+
+        for (int i = 0; i <= count; i++) {
+            if (i < count && !c_schedule_is_barrier(instructions[i].opcode)
+                && i - start < C_SCHEDULE_MAX_REGION) {
+                continue;
+            }
+
+            if (i - start > 1) {
+                c_schedule_region(&instructions[start], i - start, model);
+            }
+
+            start = i < count && c_schedule_is_barrier(instructions[i].opcode)
+                        ? i + 1
+                        : i;
+        }
+    }
+}
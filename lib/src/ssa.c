@@ -0,0 +1,600 @@
+#include "ssa.h"
+#include <stdlib.h>
+#include "ir.h"
+#include "stb_ds.h"
+#include "utils.h"
+
+static void c_ssa_postorder(c_ir_function *function,
+                            int block,
+                            int *visited,
+                            int **order) {
+    visited[block] = 1;
+
+    for (int i = 0; i < arrlen(function->blocks[block].successors); i++) {
+        int successor = function->blocks[block].successors[i];
+
+        if (!visited[successor]) {
+            c_ssa_postorder(function, successor, visited, order);
+        }
+    }
+
+    arrput(*order, block);
+}
+
+int *c_ssa_reverse_postorder(c_ir_function *function) {
+    int blocks_count = (int)arrlen(function->blocks);
+    int *visited = calloc(blocks_count, sizeof(int));
+    int *order = NULL;
+
+    c_ssa_postorder(function, 0, visited, &order);
+    free(visited);
+
+    for (int i = 0, j = (int)arrlen(order) - 1; i < j; i++, j--) {
+        int tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    return order;
+}
+
+static int c_ssa_intersect(int *idoms, int *rpo_index, int a, int b) {
+    while (a != b) {
+        while (rpo_index[a] > rpo_index[b]) {
+            a = idoms[a];
+        }
+        while (rpo_index[b] > rpo_index[a]) {
+            b = idoms[b];
+        }
+    }
+
+    return a;
+}
+
+void c_ssa_compute_dominators(c_ir_function *function) {
+    int blocks_count = (int)arrlen(function->blocks);
+    int *order = c_ssa_reverse_postorder(function);
+    int *rpo_index = malloc(sizeof(int) * blocks_count);
+    int *idoms = malloc(sizeof(int) * blocks_count);
+
+    for (int i = 0; i < blocks_count; i++) {
+        rpo_index[i] = -1;
+        idoms[i] = -1;
+    }
+
+    for (int i = 0; i < arrlen(order); i++) {
+        rpo_index[order[i]] = i;
+    }
+
+    idoms[0] = 0;
+
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+
+        for (int i = 1; i < arrlen(order); i++) {
+            int block = order[i];
+            int new_idom = -1;
+            int *predecessors = function->blocks[block].predecessors;
+
+            for (int p = 0; p < arrlen(predecessors); p++) {
+                int predecessor = predecessors[p];
+
+                if (idoms[predecessor] == -1) {
+                    continue;
+                }
+
+                new_idom = new_idom == -1 ? predecessor
+                                          : c_ssa_intersect(idoms,
+                                                            rpo_index,
+                                                            predecessor,
+                                                            new_idom);
+            }
+
+            if (idoms[block] != new_idom) {
+                idoms[block] = new_idom;
+                changed = 1;
+            }
+        }
+    }
+
+    for (int i = 0; i < blocks_count; i++) {
+        c_ir_block *block = &function->blocks[i];
+        arrfree(block->dominator_children);
+        block->immediate_dominator = i == 0 ? -1 : idoms[i];
+    }
+
+    for (int i = 1; i < blocks_count; i++) {
+        if (idoms[i] != -1) {
+            arrput(function->blocks[idoms[i]].dominator_children, i);
+        }
+    }
+
+    free(idoms);
+    free(rpo_index);
+    arrfree(order);
+}
+
+static int c_ssa_is_reachable(c_ir_function *function, int block) {
+    return block == 0 || function->blocks[block].immediate_dominator != -1;
+}
+
+void c_ssa_compute_dominance_frontiers(c_ir_function *function) {
+    int blocks_count = (int)arrlen(function->blocks);
+
+    for (int i = 0; i < blocks_count; i++) {
+        arrfree(function->blocks[i].dominance_frontier);
+    }
+
+    for (int b = 0; b < blocks_count; b++) {
+        c_ir_block *block = &function->blocks[b];
+
+        if (arrlen(block->predecessors) < 2
+            || !c_ssa_is_reachable(function, b)) {
+            continue;
+        }
+
+        for (int p = 0; p < arrlen(block->predecessors); p++) {
+            int runner = block->predecessors[p];
+
+            if (!c_ssa_is_reachable(function, runner)) {
+                continue;
+            }
+
+            while (runner != -1 && runner != block->immediate_dominator) {
+                c_ir_block *runner_block = &function->blocks[runner];
+                int present = 0;
+
+                for (int i = 0; i < arrlen(runner_block->dominance_frontier);
+                     i++) {
+                    if (runner_block->dominance_frontier[i] == b) {
+                        present = 1;
+                        break;
+                    }
+                }
+
+                if (!present) {
+                    arrput(runner_block->dominance_frontier, b);
+                }
+
+                runner = runner_block->immediate_dominator;
+            }
+        }
+    }
+}
+
+int c_ssa_dominates(c_ir_function *function, int dominator, int block) {
+    while (block != -1) {
+        if (block == dominator) {
+            return 1;
+        }
+
+        block = function->blocks[block].immediate_dominator;
+    }
+
+    return 0;
+}
+
+static void c_ssa_mark_escaped(int *escaped, int value) {
+    if (value != C_IR_NO_VALUE) {
+        escaped[value] = 1;
+    }
+}
+
+int *c_ssa_escaped_values(c_ir_function *function) {
+    int count = (int)arrlen(function->instructions);
+    int *escaped = calloc(count ? count : 1, sizeof(int));
+
+    if (!escaped) {
+        EXIT_WITH_ERROR("Failed to allocate memory for escaped values\n");
+    }
+
+    for (int i = 0; i < count; i++) {
+        c_ir_instruction *instruction = &function->instructions[i];
+
+        switch (instruction->opcode) {
+            case C_IR_NOP:
+            case C_IR_LOAD:
+                break;
+            case C_IR_STORE:
+                // NOTE: storing the address itself escapes it
+                c_ssa_mark_escaped(escaped, instruction->operands[1]);
+                break;
+            case C_IR_PHI:
+                for (int p = 0; p < arrlen(instruction->phi_operands); p++) {
+                    c_ssa_mark_escaped(escaped,
+                                       instruction->phi_operands[p].value);
+                }
+                break;
+            default:
+                c_ssa_mark_escaped(escaped, instruction->operands[0]);
+                c_ssa_mark_escaped(escaped, instruction->operands[1]);
+                break;
+        }
+    }
+
+    return escaped;
+}
+
+typedef struct {
+    c_ir_function *function;
+    // alloca value -> promoted index, -1 otherwise
+    int *promoted_index;
+    // phi value -> promoted index it was placed for
+    int *phi_index;
+    int **stacks;
+    int *replacements;
+    int *removed;
+    int undefined_value;
+} c_ssa_renamer;
+
+static int c_ssa_undefined(c_ssa_renamer *renamer) {
+    // NOTE: reading a local before its first store is
+    // undefined in C, zero is as good as anything
+    if (renamer->undefined_value == C_IR_NO_VALUE) {
+        renamer->undefined_value =
+            c_ir_function_insert(renamer->function, 0, 0,
+                                 c_ir_make_constant(0));
+        arrput(renamer->replacements, C_IR_NO_VALUE);
+        arrput(renamer->removed, 0);
+        arrput(renamer->promoted_index, -1);
+        arrput(renamer->phi_index, -1);
+    }
+
+    return renamer->undefined_value;
+}
+
+static int c_ssa_top(c_ssa_renamer *renamer, int index) {
+    int *stack = renamer->stacks[index];
+
+    if (arrlen(stack) == 0) {
+        return c_ssa_undefined(renamer);
+    }
+
+    return stack[arrlen(stack) - 1];
+}
+
+static void c_ssa_rename_block(c_ssa_renamer *renamer, int block) {
+    c_ir_function *function = renamer->function;
+    int *pushed = NULL;
+
+    // NOTE: copy, undefined constants may be inserted while walking
+    int *instructions = NULL;
+    for (int i = 0; i < arrlen(function->blocks[block].instructions); i++) {
+        arrput(instructions, function->blocks[block].instructions[i]);
+    }
+
+    for (int i = 0; i < arrlen(instructions); i++) {
+        int value = instructions[i];
+        c_ir_instruction *instruction = &function->instructions[value];
+
+        switch (instruction->opcode) {
+            case C_IR_PHI: {
+                int index = renamer->phi_index[value];
+
+                if (index >= 0) {
+                    arrput(renamer->stacks[index], value);
+                    arrput(pushed, index);
+                }
+                break;
+            }
+            case C_IR_LOAD: {
+                int index = renamer->promoted_index[instruction->operands[0]];
+
+                if (index >= 0) {
+                    int top = c_ssa_top(renamer, index);
+                    renamer->replacements[value] = top;
+                    renamer->removed[value] = 1;
+                }
+                break;
+            }
+            case C_IR_STORE: {
+                int index = renamer->promoted_index[instruction->operands[0]];
+
+                if (index >= 0) {
+                    arrput(renamer->stacks[index], instruction->operands[1]);
+                    arrput(pushed, index);
+                    renamer->removed[value] = 1;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    int *successors = function->blocks[block].successors;
+
+    for (int s = 0; s < arrlen(successors); s++) {
+        int *successor_instructions =
+            function->blocks[successors[s]].instructions;
+
+        for (int i = 0; i < arrlen(successor_instructions); i++) {
+            int value = successor_instructions[i];
+
+            if (function->instructions[value].opcode != C_IR_PHI) {
+                break;
+            }
+
+            int index = renamer->phi_index[value];
+
+            if (index < 0) {
+                continue;
+            }
+
+            c_ir_phi_operand operand = {.block = block,
+                                        .value = c_ssa_top(renamer, index)};
+            arrput(function->instructions[value].phi_operands, operand);
+        }
+    }
+
+    int *children = function->blocks[block].dominator_children;
+
+    for (int c = 0; c < arrlen(children); c++) {
+        c_ssa_rename_block(renamer, children[c]);
+    }
+
+    for (int i = 0; i < arrlen(pushed); i++) {
+        int *stack = renamer->stacks[pushed[i]];
+        arrsetlen(stack, arrlenu(stack) - 1);
+    }
+
+    arrfree(pushed);
+    arrfree(instructions);
+}
+
+static int c_ssa_resolve(int *replacements, int value) {
+    while (value != C_IR_NO_VALUE && replacements[value] != C_IR_NO_VALUE) {
+        value = replacements[value];
+    }
+
+    return value;
+}
+
+static void c_ssa_apply_replacements(c_ir_function *function,
+                                     int *replacements) {
+    for (int i = 0; i < arrlen(function->instructions); i++) {
+        c_ir_instruction *instruction = &function->instructions[i];
+
+        if (instruction->opcode == C_IR_NOP
+            || instruction->opcode == C_IR_CONSTANT
+            || instruction->opcode == C_IR_ALLOCA
+            || instruction->opcode == C_IR_CALL) {
+            continue;
+        }
+
+        for (int o = 0; o < 2; o++) {
+            instruction->operands[o] =
+                c_ssa_resolve(replacements, instruction->operands[o]);
+        }
+
+        for (int p = 0; p < arrlen(instruction->phi_operands); p++) {
+            instruction->phi_operands[p].value = c_ssa_resolve(
+                replacements, instruction->phi_operands[p].value);
+        }
+    }
+}
+
+// NOTE: a phi whose operands are all the same value (or the
+// phi itself) is just a copy of that value
+static int c_ssa_remove_trivial_phis(c_ir_function *function,
+                                     int *replacements) {
+    int removed = 0;
+    int changed = 1;
+
+    while (changed) {
+        changed = 0;
+
+        for (int i = 0; i < arrlen(function->instructions); i++) {
+            c_ir_instruction *instruction = &function->instructions[i];
+
+            if (instruction->opcode != C_IR_PHI) {
+                continue;
+            }
+
+            int same = C_IR_NO_VALUE;
+            int trivial = 1;
+
+            for (int p = 0; p < arrlen(instruction->phi_operands); p++) {
+                int value = instruction->phi_operands[p].value;
+
+                if (value == i || value == same) {
+                    continue;
+                }
+
+                if (same != C_IR_NO_VALUE) {
+                    trivial = 0;
+                    break;
+                }
+
+                same = value;
+            }
+
+            if (!trivial || same == C_IR_NO_VALUE) {
+                continue;
+            }
+
+            replacements[i] = same;
+            c_ir_function_remove(function, i);
+            c_ssa_apply_replacements(function, replacements);
+            removed++;
+            changed = 1;
+        }
+    }
+
+    return removed;
+}
+
+int c_ssa_promote_allocas(c_ir_function *function) {
+    c_ir_function_compute_cfg(function);
+    c_ssa_compute_dominators(function);
+    c_ssa_compute_dominance_frontiers(function);
+
+    c_ssa_renamer renamer = {0};
+    renamer.function = function;
+    renamer.undefined_value = C_IR_NO_VALUE;
+
+    int *allocas = NULL;
+    int *escaped = c_ssa_escaped_values(function);
+
+    for (int i = 0; i < arrlen(function->instructions); i++) {
+        arrput(renamer.promoted_index, -1);
+
+        if (function->instructions[i].opcode == C_IR_ALLOCA && !escaped[i]) {
+            renamer.promoted_index[i] = (int)arrlen(allocas);
+            arrput(allocas, i);
+        }
+    }
+
+    free(escaped);
+
+    int promoted = (int)arrlen(allocas);
+
+    if (promoted == 0) {
+        arrfree(renamer.promoted_index);
+        return 0;
+    }
+
+    int blocks_count = (int)arrlen(function->blocks);
+    int *phi_alloca_of = NULL;
+    int *has_phi = malloc(sizeof(int) * blocks_count);
+    int *in_worklist = malloc(sizeof(int) * blocks_count);
+    int **store_blocks = calloc(promoted, sizeof(int *));
+
+    for (int i = 0; i < arrlen(function->instructions); i++) {
+        c_ir_instruction *instruction = &function->instructions[i];
+
+        if (instruction->opcode != C_IR_STORE
+            || !c_ssa_is_reachable(function, instruction->block)) {
+            continue;
+        }
+
+        int a = renamer.promoted_index[instruction->operands[0]];
+
+        if (a != -1) {
+            arrput(store_blocks[a], instruction->block);
+        }
+    }
+
+    for (int a = 0; a < promoted; a++) {
+        int *worklist = NULL;
+
+        for (int b = 0; b < blocks_count; b++) {
+            has_phi[b] = 0;
+            in_worklist[b] = 0;
+        }
+
+        for (int s = 0; s < arrlen(store_blocks[a]); s++) {
+            int block = store_blocks[a][s];
+
+            if (!in_worklist[block]) {
+                in_worklist[block] = 1;
+                arrput(worklist, block);
+            }
+        }
+
+        arrfree(store_blocks[a]);
+
+        while (arrlen(worklist) > 0) {
+            int block = arrlast(worklist);
+            arrsetlen(worklist, arrlenu(worklist) - 1);
+            int *frontier = function->blocks[block].dominance_frontier;
+
+            for (int f = 0; f < arrlen(frontier); f++) {
+                int target = frontier[f];
+
+                if (has_phi[target]) {
+                    continue;
+                }
+
+                has_phi[target] = 1;
+
+                c_ir_instruction phi_instruction =
+                    c_ir_make(C_IR_PHI, C_IR_NO_VALUE, C_IR_NO_VALUE);
+                phi_instruction.type =
+                    function->instructions[allocas[a]].type;
+
+                int phi = c_ir_function_insert(
+                    function, target, 0, phi_instruction);
+
+                while (arrlen(phi_alloca_of) <= phi) {
+                    arrput(phi_alloca_of, -1);
+                }
+                phi_alloca_of[phi] = a;
+
+                if (!in_worklist[target]) {
+                    in_worklist[target] = 1;
+                    arrput(worklist, target);
+                }
+            }
+        }
+
+        arrfree(worklist);
+    }
+
+    free(has_phi);
+    free(in_worklist);
+    free(store_blocks);
+
+    for (int i = 0; i < arrlen(function->instructions); i++) {
+        if (i >= arrlen(renamer.promoted_index)) {
+            arrput(renamer.promoted_index, -1);
+        }
+
+        arrput(renamer.phi_index,
+               i < arrlen(phi_alloca_of) ? phi_alloca_of[i] : -1);
+        arrput(renamer.replacements, C_IR_NO_VALUE);
+        arrput(renamer.removed, 0);
+    }
+
+    arrfree(phi_alloca_of);
+
+    for (int a = 0; a < promoted; a++) {
+        arrput(renamer.stacks, NULL);
+    }
+
+    c_ssa_rename_block(&renamer, 0);
+
+    // NOTE: blocks without a path from the entry never see a
+    // definition, their loads read undefined values
+    for (int i = 0; i < arrlen(function->instructions); i++) {
+        c_ir_instruction *instruction = &function->instructions[i];
+
+        if ((instruction->opcode != C_IR_LOAD
+             && instruction->opcode != C_IR_STORE)
+            || c_ssa_is_reachable(function, instruction->block)
+            || renamer.promoted_index[instruction->operands[0]] < 0) {
+            continue;
+        }
+
+        if (instruction->opcode == C_IR_LOAD) {
+            renamer.replacements[i] = c_ssa_undefined(&renamer);
+        }
+
+        renamer.removed[i] = 1;
+    }
+
+    c_ssa_apply_replacements(function, renamer.replacements);
+
+    for (int i = 0; i < arrlen(renamer.removed); i++) {
+        if (renamer.removed[i]) {
+            c_ir_function_remove(function, i);
+        }
+    }
+
+    for (int a = 0; a < promoted; a++) {
+        c_ir_function_remove(function, allocas[a]);
+        arrfree(renamer.stacks[a]);
+    }
+
+    c_ssa_remove_trivial_phis(function, renamer.replacements);
+
+    arrfree(renamer.stacks);
+    arrfree(renamer.promoted_index);
+    arrfree(renamer.phi_index);
+    arrfree(renamer.replacements);
+    arrfree(renamer.removed);
+    arrfree(allocas);
+
+    return promoted;
+}
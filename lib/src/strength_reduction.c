@@ -0,0 +1,178 @@
+#include "strength_reduction.h"
+#include <stdlib.h>
+#include "utils.h"
+
+static uint64_t c_strength_mask(int bits) {
+    if (bits != 32 && bits != 64) {
+        EXIT_WITH_ERROR("Got unsupported width for magic number: %d\n", bits);
+    }
+
+    return bits == 64 ? UINT64_MAX : (((uint64_t)1 << bits) - 1);
+}
+
+static int64_t c_strength_sign_extend(uint64_t value, int bits) {
+    uint64_t sign = (uint64_t)1 << (bits - 1);
+
+    if (bits < 64 && (value & sign)) {
+        value |= ~c_strength_mask(bits);
+    }
+
+    return (int64_t)value;
+}
+
+int c_strength_is_power_of_two(uint64_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+int c_strength_log2(uint64_t value) {
+    int result = 0;
+
+    while (value > 1) {
+        value >>= 1;
+        result++;
+    }
+
+    return result;
+}
+
+c_magic_number c_strength_signed_magic(int64_t divisor, int bits) {
+    uint64_t mask = c_strength_mask(bits);
+    uint64_t sign = (uint64_t)1 << (bits - 1);
+    uint64_t d = (uint64_t)divisor & mask;
+    uint64_t ad = divisor < 0 ? (0 - (uint64_t)divisor) & mask : d;
+
+    if (ad < 2) {
+        EXIT_WITH_ERROR("Got divisor without magic number: %lld\n",
+                        (long long)divisor);
+    }
+
+    uint64_t t = sign + (d >> (bits - 1));
+    uint64_t anc = t - 1 - t % ad;
+    int p = bits - 1;
+    uint64_t q1 = sign / anc;
+    uint64_t r1 = sign - q1 * anc;
+    uint64_t q2 = sign / ad;
+    uint64_t r2 = sign - q2 * ad;
+    uint64_t delta;
+
+    do {
+        p++;
+        q1 = (2 * q1) & mask;
+        r1 = (2 * r1) & mask;
+
+        if (r1 >= anc) {
+            q1 = (q1 + 1) & mask;
+            r1 = (r1 - anc) & mask;
+        }
+
+        q2 = (2 * q2) & mask;
+        r2 = (2 * r2) & mask;
+
+        if (r2 >= ad) {
+            q2 = (q2 + 1) & mask;
+            r2 = (r2 - ad) & mask;
+        }
+
+        delta = ad - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+
+    uint64_t multiplier = (q2 + 1) & mask;
+
+    if (divisor < 0) {
+        multiplier = (0 - multiplier) & mask;
+    }
+
+    c_magic_number magic = {
+        .multiplier = c_strength_sign_extend(multiplier, bits),
+        .shift = p - bits,
+        .add = 0,
+    };
+
+    return magic;
+}
+
+c_magic_number c_strength_unsigned_magic(uint64_t divisor, int bits) {
+    uint64_t mask = c_strength_mask(bits);
+    uint64_t sign = (uint64_t)1 << (bits - 1);
+    uint64_t max_signed = sign - 1;
+    uint64_t d = divisor & mask;
+
+    if (d < 2) {
+        EXIT_WITH_ERROR("Got divisor without magic number: %llu\n",
+                        (unsigned long long)divisor);
+    }
+
+    int add = 0;
+    int p = bits - 1;
+    uint64_t power = 0;
+    uint64_t q = max_signed / d;
+    uint64_t r = max_signed - q * d;
+    uint64_t delta;
+
+    do {
+        p++;
+        power = p == bits ? 1 : (2 * power) & mask;
+
+        if (r + 1 >= d - r) {
+            if (q >= max_signed) {
+                add = 1;
+            }
+
+            q = (2 * q + 1) & mask;
+            r = (2 * r + 1 - d) & mask;
+        } else {
+            if (q >= sign) {
+                add = 1;
+            }
+
+            q = (2 * q) & mask;
+            r = (2 * r + 1) & mask;
+        }
+
+        delta = d - 1 - r;
+    } while (p < 2 * bits && (power < delta || (power == delta && r == 0)));
+
+    c_magic_number magic = {
+        .multiplier = c_strength_sign_extend((q + 1) & mask, bits),
+        .shift = p - bits,
+        .add = add,
+    };
+
+    return magic;
+}
+
+int c_strength_decompose_multiply(int64_t factor,
+                                  int *lea_scale,
+                                  int *shift,
+                                  int *negate) {
+    if (factor == 0 || factor == INT64_MIN) {
+        return 0;
+    }
+
+    uint64_t magnitude = factor < 0 ? 0 - (uint64_t)factor : (uint64_t)factor;
+
+    *negate = factor < 0;
+    *shift = 0;
+
+    while ((magnitude & 1) == 0) {
+        magnitude >>= 1;
+        (*shift)++;
+    }
+
+    switch (magnitude) {
+        case 1:
+            *lea_scale = 0;
+            return 1;
+        case 3:
+            *lea_scale = 2;
+            return 1;
+        case 5:
+            *lea_scale = 4;
+            return 1;
+        case 9:
+            *lea_scale = 8;
+            return 1;
+        default:
+            return 0;
+    }
+}
@@ -0,0 +1,82 @@
+// NOTE: sysconf and _SC_NPROCESSORS_ONLN are not part of C11
+#define _DEFAULT_SOURCE
+
+#include "thread_pool.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "utils.h"
+
+typedef struct {
+    c_thread_pool_task task;
+    void *data;
+    int tasks_count;
+    // NOTE: next index to hand out
+    int next;
+    pthread_mutex_t lock;
+} c_thread_pool;
+
+static void *c_thread_pool_worker(void *argument) {
+    c_thread_pool *pool = argument;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        int index = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (index >= pool->tasks_count) {
+            return NULL;
+        }
+
+        pool->task(pool->data, index);
+    }
+}
+
+void c_thread_pool_run(int jobs,
+                       int tasks_count,
+                       c_thread_pool_task task,
+                       void *data) {
+    if (jobs > tasks_count) {
+        jobs = tasks_count;
+    }
+
+    if (jobs <= 1) {
+        for (int i = 0; i < tasks_count; i++) {
+            task(data, i);
+        }
+        return;
+    }
+
+    c_thread_pool pool = {
+        .task = task, .data = data, .tasks_count = tasks_count, .next = 0};
+    pthread_t *threads = malloc(jobs * sizeof(pthread_t));
+
+    if (!threads) {
+        EXIT_WITH_ERROR("Failed to allocate memory for thread pool\n");
+    }
+
+    pthread_mutex_init(&pool.lock, NULL);
+
+    // NOTE: the caller is a worker too
+    for (int i = 1; i < jobs; i++) {
+        if (pthread_create(&threads[i], NULL, c_thread_pool_worker, &pool)
+            != 0) {
+            EXIT_WITH_ERROR("Failed to start thread pool worker\n");
+        }
+    }
+
+    c_thread_pool_worker(&pool);
+
+    for (int i = 1; i < jobs; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool.lock);
+    free(threads);
+}
+
+int c_thread_pool_online_cpus(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? (int)count : 1;
+}
@@ -0,0 +1,221 @@
+#include "value_numbering.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ssa.h"
+#include "stb_ds.h"
+#include "utils.h"
+
+typedef struct {
+    c_ir_function *function;
+    // NOTE: open addressing, slots hold value ids or C_IR_NO_VALUE
+    int *slots;
+    int capacity;
+    // NOTE: filled slots in insertion order, a scope clears its
+    // own in reverse which restores the probe sequences
+    int *filled;
+    int *replacements;
+    int removed;
+} c_value_table;
+
+static int c_value_is_numbered(c_ir_opcode opcode) {
+    return c_ir_is_binary(opcode);
+}
+
+static int c_value_is_commutative(c_ir_opcode opcode) {
+    return opcode == C_IR_ADD || opcode == C_IR_MULTIPLY;
+}
+
+c_value_key c_value_key_of(c_ir_function *function, int value) {
+    c_ir_instruction *instruction = &function->instructions[value];
+    c_value_key key = {.opcode = instruction->opcode, .type = instruction->type};
+
+    for (int o = 0; o < 2; o++) {
+        int operand = instruction->operands[o];
+        c_ir_instruction *definition = &function->instructions[operand];
+
+        key.is_constant[o] = definition->opcode == C_IR_CONSTANT;
+        key.operands[o] = key.is_constant[o] ? definition->constant : operand;
+    }
+
+    // NOTE: constants sort after values, then by number
+    if (c_value_is_commutative(key.opcode)
+        && (key.is_constant[0] > key.is_constant[1]
+            || (key.is_constant[0] == key.is_constant[1]
+                && key.operands[0] > key.operands[1]))) {
+        int is_constant = key.is_constant[0];
+        int operand = key.operands[0];
+
+        key.is_constant[0] = key.is_constant[1];
+        key.operands[0] = key.operands[1];
+        key.is_constant[1] = is_constant;
+        key.operands[1] = operand;
+    }
+
+    return key;
+}
+
+int c_value_key_equal(c_value_key *a, c_value_key *b) {
+    return a->opcode == b->opcode && a->type == b->type
+           && a->is_constant[0] == b->is_constant[0]
+           && a->is_constant[1] == b->is_constant[1]
+           && a->operands[0] == b->operands[0]
+           && a->operands[1] == b->operands[1];
+}
+
+static uint32_t c_value_key_hash(c_value_key *key) {
+    uint32_t hash = 2166136261u;
+    int fields[] = {key->opcode,
+                    key->type,
+                    key->is_constant[0],
+                    key->operands[0],
+                    key->is_constant[1],
+                    key->operands[1]};
+
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        hash = (hash ^ (uint32_t)fields[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+static int c_value_resolve(c_value_table *table, int value) {
+    while (value != C_IR_NO_VALUE
+           && table->replacements[value] != C_IR_NO_VALUE) {
+        value = table->replacements[value];
+    }
+
+    return value;
+}
+
+static void c_value_rewrite_operands(c_value_table *table, int value) {
+    c_ir_instruction *instruction = &table->function->instructions[value];
+
+    if (instruction->opcode == C_IR_NOP
+        || instruction->opcode == C_IR_CONSTANT
+        || instruction->opcode == C_IR_ALLOCA
+        || instruction->opcode == C_IR_CALL) {
+        return;
+    }
+
+    // NOTE: allocas are never replaced, so load and store
+    // addresses resolve to themselves
+    for (int o = 0; o < 2; o++) {
+        instruction->operands[o] =
+            c_value_resolve(table, instruction->operands[o]);
+    }
+
+    for (int p = 0; p < arrlen(instruction->phi_operands); p++) {
+        instruction->phi_operands[p].value =
+            c_value_resolve(table, instruction->phi_operands[p].value);
+    }
+}
+
+// NOTE: returns the earlier equal value, or records this one
+static int c_value_lookup_or_insert(c_value_table *table, int value) {
+    c_value_key key = c_value_key_of(table->function, value);
+    int slot = (int)(c_value_key_hash(&key) & (uint32_t)(table->capacity - 1));
+
+    while (table->slots[slot] != C_IR_NO_VALUE) {
+        c_value_key other = c_value_key_of(table->function, table->slots[slot]);
+
+        if (c_value_key_equal(&key, &other)) {
+            return table->slots[slot];
+        }
+
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+
+    table->slots[slot] = value;
+    arrput(table->filled, slot);
+
+    return value;
+}
+
+static void c_value_number_block(c_value_table *table, int block) {
+    c_ir_function *function = table->function;
+    int scope_start = (int)arrlen(table->filled);
+    int *instructions = function->blocks[block].instructions;
+
+    for (int i = 0; i < arrlen(instructions); i++) {
+        int value = instructions[i];
+
+        c_value_rewrite_operands(table, value);
+
+        if (!c_value_is_numbered(function->instructions[value].opcode)) {
+            continue;
+        }
+
+        int existing = c_value_lookup_or_insert(table, value);
+
+        if (existing != value) {
+            table->replacements[value] = existing;
+        }
+    }
+
+    int *children = function->blocks[block].dominator_children;
+
+    for (int c = 0; c < arrlen(children); c++) {
+        c_value_number_block(table, children[c]);
+    }
+
+    for (int i = (int)arrlen(table->filled) - 1; i >= scope_start; i--) {
+        table->slots[table->filled[i]] = C_IR_NO_VALUE;
+    }
+
+    arrsetlen(table->filled, (size_t)scope_start);
+}
+
+int c_value_number_function(c_ir_function *function) {
+    int count = (int)arrlen(function->instructions);
+
+    if (arrlen(function->blocks) == 0) {
+        return 0;
+    }
+
+    c_value_table table = {.function = function, .capacity = 16};
+
+    while (table.capacity < 2 * count) {
+        table.capacity *= 2;
+    }
+
+    table.slots = malloc(table.capacity * sizeof(int));
+    table.replacements = malloc((count ? count : 1) * sizeof(int));
+
+    if (!table.slots || !table.replacements) {
+        EXIT_WITH_ERROR("Failed to allocate memory for value numbering\n");
+    }
+
+    for (int i = 0; i < table.capacity; i++) {
+        table.slots[i] = C_IR_NO_VALUE;
+    }
+
+    for (int i = 0; i < count; i++) {
+        table.replacements[i] = C_IR_NO_VALUE;
+    }
+
+    c_ssa_compute_dominators(function);
+    c_value_number_block(&table, 0);
+
+    // NOTE: phis on back edges name values of blocks visited later
+    for (int b = 0; b < arrlen(function->blocks); b++) {
+        int *instructions = function->blocks[b].instructions;
+
+        for (int i = 0; i < arrlen(instructions); i++) {
+            c_value_rewrite_operands(&table, instructions[i]);
+        }
+    }
+
+    for (int v = 0; v < count; v++) {
+        if (table.replacements[v] != C_IR_NO_VALUE) {
+            c_ir_function_remove(function, v);
+            table.removed++;
+        }
+    }
+
+    free(table.slots);
+    free(table.replacements);
+    arrfree(table.filled);
+
+    return table.removed;
+}
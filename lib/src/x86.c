@@ -0,0 +1,80 @@
+#include "x86.h"
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+const char *c_x86_register_name(c_x86_register reg) {
+    static const char *names[C_X86_REGISTERS_COUNT] = {
+        "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+        "r8",  "r9",  "r10", "r11", "r12", "r13", "r14", "r15",
+    };
+
+    if (reg < 0 || reg >= C_X86_REGISTERS_COUNT) {
+        EXIT_WITH_ERROR("Got invalid register: %d\n", reg);
+    }
+
+    return names[reg];
+}
+
+const char *c_x86_register_name32(c_x86_register reg) {
+    static const char *names[C_X86_REGISTERS_COUNT] = {
+        "eax", "ecx", "edx",  "ebx",  "esp",  "ebp",  "esi",  "edi",
+        "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d",
+    };
+
+    if (reg < 0 || reg >= C_X86_REGISTERS_COUNT) {
+        EXIT_WITH_ERROR("Got invalid register: %d\n", reg);
+    }
+
+    return names[reg];
+}
+
+const char *c_x86_register_name_sized(c_x86_register reg, int size) {
+    switch (size) {
+        case 4:
+            return c_x86_register_name32(reg);
+        case 8:
+            return c_x86_register_name(reg);
+        default:
+            EXIT_WITH_ERROR("Got unsupported register size: %d\n", size);
+    }
+}
+
+c_x86_register c_x86_register_from_name(const char *name) {
+    for (int reg = 0; reg < C_X86_REGISTERS_COUNT; reg++) {
+        if (strcmp(c_x86_register_name(reg), name) == 0
+            || strcmp(c_x86_register_name32(reg), name) == 0) {
+            return reg;
+        }
+    }
+
+    return C_X86_NO_REGISTER;
+}
+
+int c_x86_register_size(const char *name) {
+    for (int reg = 0; reg < C_X86_REGISTERS_COUNT; reg++) {
+        if (strcmp(c_x86_register_name(reg), name) == 0) {
+            return 8;
+        }
+
+        if (strcmp(c_x86_register_name32(reg), name) == 0) {
+            return 4;
+        }
+    }
+
+    return 0;
+}
+
+int c_x86_is_callee_saved(c_x86_register reg) {
+    switch (reg) {
+        case C_X86_RBX:
+        case C_X86_RBP:
+        case C_X86_R12:
+        case C_X86_R13:
+        case C_X86_R14:
+        case C_X86_R15:
+            return 1;
+        default:
+            return 0;
+    }
+}
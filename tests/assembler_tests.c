@@ -0,0 +1,371 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "assembler.h"
+#include "elf64.h"
+#include "stb_ds.h"
+#include "str.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static c_asm_object *assemble(const char **input) {
+    char **lines = NULL;
+
+    for (int i = 0; input[i]; i++) {
+        arrput(lines, strdup(input[i]));
+    }
+
+    c_asm_object *object = c_asm_assemble(lines);
+
+    for (int i = 0; i < arrlen(lines); i++) {
+        free(lines[i]);
+    }
+    arrfree(lines);
+
+    return object;
+}
+
+static void hex(uint8_t *bytes, int start, int end, char *result) {
+    result[0] = '\0';
+
+    for (int i = start; i < end; i++) {
+        sprintf(result + strlen(result), i == start ? "%02x" : " %02x", bytes[i]);
+    }
+}
+
+static void assert_encoding(const char *line, const char *expected) {
+    const char *input[] = {line, NULL};
+    char result[128];
+    c_asm_object *object = assemble(input);
+
+    hex(object->text, 0, (int)arrlen(object->text), result);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(expected, result, line);
+    c_asm_object_free(object);
+}
+
+void test_assembler_encodes_backend_subset(void) {
+    assert_encoding("    mov ecx, 2", "b9 02 00 00 00");
+    assert_encoding("    mov r12d, eax", "41 89 c4");
+    assert_encoding("    mov dword [rbp-4], 5", "c7 45 fc 05 00 00 00");
+    assert_encoding("    mov dword [rsp+4], r11d", "44 89 5c 24 04");
+    assert_encoding("    mov ecx, dword [rbp-44]", "8b 4d d4");
+    assert_encoding("    mov r8d, dword [rsp]", "44 8b 04 24");
+    assert_encoding("    mov qword [rbp-8], rax", "48 89 45 f8");
+    assert_encoding("    mov rax, -5", "48 c7 c0 fb ff ff ff");
+    assert_encoding("    mov rax, 4294967295", "b8 ff ff ff ff");
+    assert_encoding("    mov rax, 81985529216486895",
+                    "48 b8 ef cd ab 89 67 45 23 01");
+    assert_encoding("    add ecx, esi", "01 f1");
+    assert_encoding("    add esi, dword [rbp-44]", "03 75 d4");
+    assert_encoding("    add eax, 1000", "05 e8 03 00 00");
+    assert_encoding("    add r9d, 1000", "41 81 c1 e8 03 00 00");
+    assert_encoding("    sub rsp, 8", "48 83 ec 08");
+    assert_encoding("    cmp dword [rbp-4], 0", "83 7d fc 00");
+    assert_encoding("    test ecx, ecx", "85 c9");
+    assert_encoding("    xor r10d, r10d", "45 31 d2");
+    assert_encoding("    and eax, -8", "83 e0 f8");
+    assert_encoding("    imul ecx, ecx, 3", "6b c9 03");
+    assert_encoding("    imul ecx, esi, 1000", "69 ce e8 03 00 00");
+    assert_encoding("    imul ecx, esi", "0f af ce");
+    assert_encoding("    imul ecx", "f7 e9");
+    assert_encoding("    idiv r11d", "41 f7 fb");
+    assert_encoding("    neg rdx", "48 f7 da");
+    assert_encoding("    shl edi, 3", "c1 e7 03");
+    assert_encoding("    sar edx, 1", "d1 fa");
+    assert_encoding("    lea ecx, [rcx+rcx*2]", "8d 0c 49");
+    assert_encoding("    lea rsp, [rbp-40]", "48 8d 65 d8");
+    assert_encoding("    lea eax, [r13+r12*8+16]", "43 8d 44 e5 10");
+    assert_encoding("    lea ecx, [rcx*4+1]", "8d 0c 8d 01 00 00 00");
+    assert_encoding("    lea eax, [r9*8-3]", "42 8d 04 cd fd ff ff ff");
+    assert_encoding("    movsxd rcx, dword [rbp-4]", "48 63 4d fc");
+    assert_encoding("    push r15", "41 57");
+    assert_encoding("    pop r12", "41 5c");
+    assert_encoding("    cdq", "99");
+    assert_encoding("    cqo", "48 99");
+    assert_encoding("    syscall", "0f 05");
+}
+
+void test_assembler_relaxes_jumps(void) {
+    const char *input[64] = {
+        "f:",
+        "    jz .L1",
+        "    jmp .L2",
+        ".L1:",
+    };
+    int count = 4;
+
+    // NOTE: 20 ten byte stores put .L2 out of rel8 reach
+    for (int i = 0; i < 20; i++) {
+        input[count++] = "    mov dword [rbp-400], 100000";
+    }
+
+    input[count++] = ".L2:";
+    input[count++] = "    ret";
+    input[count] = NULL;
+
+    char result[128];
+    c_asm_object *object = assemble(input);
+
+    hex(object->text, 0, 2, result);
+    TEST_ASSERT_EQUAL_STRING("74 05", result);
+    hex(object->text, 2, 7, result);
+    TEST_ASSERT_EQUAL_STRING("e9 c8 00 00 00", result);
+    TEST_ASSERT_EQUAL_INT(2 + 5 + 200 + 1, arrlen(object->text));
+
+    c_asm_object_free(object);
+}
+
+void test_assembler_relocates_undefined_calls(void) {
+    const char *input[] = {
+        "global _start",
+        "section .text",
+        "_start:",
+        "    call main",
+        "main:",
+        "    call f",
+        "    ret",
+        NULL,
+    };
+    char result[128];
+    c_asm_object *object = assemble(input);
+
+    hex(object->text, 0, (int)arrlen(object->text), result);
+    TEST_ASSERT_EQUAL_STRING("e8 00 00 00 00 e8 00 00 00 00 c3", result);
+
+    TEST_ASSERT_EQUAL_INT(1, arrlen(object->relocations));
+    TEST_ASSERT_EQUAL_INT(6, object->relocations[0].offset);
+    TEST_ASSERT_EQUAL_INT(-4, object->relocations[0].addend);
+
+    c_asm_symbol *f = &object->symbols[object->relocations[0].symbol];
+    TEST_ASSERT_EQUAL_STRING("f", f->name);
+    TEST_ASSERT_FALSE(f->is_defined);
+    TEST_ASSERT_TRUE(f->is_global);
+
+    c_asm_symbol *start = &object->symbols[c_asm_find_symbol(object, "_start")];
+    TEST_ASSERT_TRUE(start->is_global);
+    TEST_ASSERT_FALSE(object->symbols[c_asm_find_symbol(object, "main")].is_global);
+
+    c_asm_object_free(object);
+}
+
+void test_assembler_relocates_undefined_jumps(void) {
+    const char *input[] = {
+        "f:",
+        "    jmp g",
+        "    jmp f",
+        NULL,
+    };
+    char result[128];
+    c_asm_object *object = assemble(input);
+
+    hex(object->text, 0, (int)arrlen(object->text), result);
+    TEST_ASSERT_EQUAL_STRING("e9 00 00 00 00 eb f9", result);
+
+    TEST_ASSERT_EQUAL_INT(1, arrlen(object->relocations));
+    TEST_ASSERT_EQUAL_INT(1, object->relocations[0].offset);
+    TEST_ASSERT_EQUAL_INT(-4, object->relocations[0].addend);
+    TEST_ASSERT_EQUAL_STRING(
+        "g", object->symbols[object->relocations[0].symbol].name);
+
+    c_asm_object_free(object);
+}
+
+void test_assembler_module_matches_printed_text(void) {
+    c_mir_module *module = calloc(1, sizeof(c_mir_module));
+    c_mir_function *start = c_mir_function_create("_start");
+    c_mir_function *main = c_mir_function_create("main");
+    char **lines = NULL;
+
+    arrput(module->globals, strdup("_start"));
+    c_mir_append(start,
+                 c_mir_make1(C_MIR_CALL,
+                             c_mir_label_operand(c_mir_label(start, "main"))));
+    c_mir_append(start, c_mir_make0(C_MIR_RET));
+
+    c_mir_operand slot =
+        c_mir_memory(C_X86_RBP, C_X86_NO_REGISTER, 1, -4, 4);
+    c_mir_append(main, c_mir_make1(C_MIR_PUSH, c_mir_register(C_X86_RBP, 8)));
+    c_mir_append(main,
+                 c_mir_make2(C_MIR_MOV,
+                             c_mir_register(C_X86_RBP, 8),
+                             c_mir_register(C_X86_RSP, 8)));
+    c_mir_append(main, c_mir_make2(C_MIR_MOV, slot, c_mir_immediate(5)));
+    c_mir_append(main,
+                 c_mir_make2(C_MIR_MOV, c_mir_register(C_X86_RAX, 4), slot));
+    c_mir_append(main,
+                 c_mir_make2(C_MIR_TEST,
+                             c_mir_register(C_X86_RAX, 4),
+                             c_mir_register(C_X86_RAX, 4)));
+    int done = c_mir_label(main, ".Lreturn");
+    c_mir_append(main, c_mir_make1(C_MIR_JZ, c_mir_label_operand(done)));
+    c_mir_append(main,
+                 c_mir_make1(C_MIR_CALL,
+                             c_mir_label_operand(c_mir_label(main, "f"))));
+    c_mir_begin_block(main, done);
+    c_mir_append(main, c_mir_make1(C_MIR_POP, c_mir_register(C_X86_RBP, 8)));
+    c_mir_append(main, c_mir_make0(C_MIR_RET));
+
+    arrput(module->functions, start);
+    arrput(module->functions, main);
+
+    c_mir_print_module(module, &lines);
+    c_asm_object *printed = c_asm_assemble(lines);
+    c_asm_object *direct = c_asm_assemble_module(module);
+
+    TEST_ASSERT_EQUAL_INT(arrlen(printed->text), arrlen(direct->text));
+    TEST_ASSERT_EQUAL_MEMORY(
+        printed->text, direct->text, arrlen(printed->text));
+    TEST_ASSERT_EQUAL_INT(arrlen(printed->relocations),
+                          arrlen(direct->relocations));
+    TEST_ASSERT_EQUAL_INT(printed->relocations[0].offset,
+                          direct->relocations[0].offset);
+    TEST_ASSERT_TRUE(
+        direct->symbols[c_asm_find_symbol(direct, "_start")].is_global);
+
+    for (int i = 0; i < arrlen(lines); i++) {
+        free(lines[i]);
+    }
+    arrfree(lines);
+    c_asm_object_free(printed);
+    c_asm_object_free(direct);
+    c_mir_module_free(module);
+}
+
+void test_elf64_writes_relocatable(void) {
+    const char *input[] = {"global _start", "_start:", "    call f", NULL};
+    c_asm_object *object = assemble(input);
+    uint8_t *bytes = c_elf64_write_relocatable(object);
+
+    TEST_ASSERT_EQUAL_MEMORY("\x7f" "ELF", bytes, 4);
+    TEST_ASSERT_EQUAL_INT(2, bytes[4]);
+    TEST_ASSERT_EQUAL_INT(C_ELF64_ET_REL, bytes[16]);
+    TEST_ASSERT_EQUAL_INT(C_ELF64_EM_X86_64, bytes[18]);
+    // NOTE: e_shnum
+    TEST_ASSERT_EQUAL_INT(6, bytes[60]);
+
+    arrfree(bytes);
+    c_asm_object_free(object);
+}
+
+static int write_file(const char *path, const char *contents, size_t size) {
+    FILE *file = fopen(path, "wb");
+
+    if (!file) {
+        return 0;
+    }
+
+    fwrite(contents, 1, size, file);
+    fclose(file);
+    return 1;
+}
+
+void test_assembler_matches_nasm_disassembly(void) {
+    if (system("nasm -v > /dev/null 2>&1") != 0
+        || system("objdump -v > /dev/null 2>&1") != 0) {
+        TEST_IGNORE_MESSAGE("nasm or objdump not found");
+    }
+
+    const char *input[64] = {
+        "global _start",
+        "section .text",
+        "_start:",
+        "    call main",
+        "    mov edi, eax",
+        "    mov eax, 60",
+        "    syscall",
+        "main:",
+        "    push rbp",
+        "    mov rbp, rsp",
+        "    push rbx",
+        "    sub rsp, 24",
+        "    call f",
+        "    mov ebx, eax",
+        "    mov eax, -1840700269",
+        "    imul ebx",
+        "    add edx, ebx",
+        "    sar edx, 2",
+        "    lea ecx, [rbx+rbx*8]",
+        "    mov dword [rbp-12], ecx",
+        "    cmp dword [rbp-12], 0",
+        "    jz .L1_else",
+        "    jmp .L2",
+        ".L1_else:",
+    };
+    int count = 24;
+
+    for (int i = 0; i < 20; i++) {
+        input[count++] = "    mov dword [rbp-400], 100000";
+    }
+
+    input[count++] = ".L2:";
+    input[count++] = "    mov eax, ecx";
+    input[count++] = "    cdq";
+    input[count++] = "    idiv dword [rbp-12]";
+    input[count++] = "    lea rsp, [rbp-8]";
+    input[count++] = "    pop rbx";
+    input[count++] = "    pop rbp";
+    input[count++] = "    ret";
+    input[count] = NULL;
+
+    char source[4096] = {0};
+
+    for (int i = 0; input[i]; i++) {
+        strcat(source, input[i]);
+        strcat(source, "\n");
+    }
+
+    c_asm_object *object = assemble(input);
+    uint8_t *bytes = c_elf64_write_relocatable(object);
+
+    TEST_ASSERT_TRUE(
+        write_file("assembler_test_ours.o", (char *)bytes, arrlen(bytes)));
+    TEST_ASSERT_TRUE(
+        write_file("assembler_test_nasm.asm", source, strlen(source)));
+    TEST_ASSERT_EQUAL_INT(
+        0,
+        system("nasm -f elf64 assembler_test_nasm.asm "
+               "-o assembler_test_nasm.o"));
+
+    // NOTE: nasm names .L labels after the function they follow,
+    // symbolic annotations are dropped before comparing
+    const char *disassemble =
+        "objdump -d -M intel --no-show-raw-insn %s.o "
+        "| grep -E '^ +[0-9a-f]+:' | sed 's/<[^>]*>//g' > %s.txt";
+    char command[256];
+
+    snprintf(command, sizeof(command), disassemble,
+             "assembler_test_ours", "assembler_test_ours");
+    TEST_ASSERT_EQUAL_INT(0, system(command));
+    snprintf(command, sizeof(command), disassemble,
+             "assembler_test_nasm", "assembler_test_nasm");
+    TEST_ASSERT_EQUAL_INT(0, system(command));
+
+    int same =
+        system("cmp -s assembler_test_ours.txt assembler_test_nasm.txt") == 0;
+
+    remove("assembler_test_ours.o");
+    remove("assembler_test_ours.txt");
+    remove("assembler_test_nasm.asm");
+    remove("assembler_test_nasm.o");
+    remove("assembler_test_nasm.txt");
+    arrfree(bytes);
+    c_asm_object_free(object);
+
+    TEST_ASSERT_TRUE_MESSAGE(same, "disassembly differs from nasm");
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_assembler_encodes_backend_subset);
+    RUN_TEST(test_assembler_relaxes_jumps);
+    RUN_TEST(test_assembler_relocates_undefined_calls);
+    RUN_TEST(test_assembler_relocates_undefined_jumps);
+    RUN_TEST(test_assembler_module_matches_printed_text);
+    RUN_TEST(test_elf64_writes_relocatable);
+    RUN_TEST(test_assembler_matches_nasm_disassembly);
+    return UNITY_END();
+}
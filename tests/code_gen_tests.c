@@ -1,9 +1,12 @@
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "code_generator.h"
 #include "unity.h"
 #include "lexer.h"
 #include "stb_ds.h"
 #include "parser.h"
+#include "test_program.h"
 
 void setUp(void) {}
 
@@ -66,9 +69,374 @@ void test_code_gen_main_function(void) {
     TEST_ASSERT_EQUAL_STRING(expected, result);
 }
 
+static void emit_source(const char *source,
+                        c_code_gen_options options,
+                        char *result) {
+    test_program fixture = test_program_parse(source);
+    char **asm_lines =
+        c_code_gen_emit_with_options(fixture.program, options);
+
+    for (int i = 0; i < arrlen(asm_lines); i++) {
+        strcat(result, asm_lines[i]);
+        strcat(result, "\n");
+        free(asm_lines[i]);
+    }
+
+    arrfree(asm_lines);
+    test_program_free(fixture);
+}
+
+void test_code_gen_promoted_locals_skip_memory(void) {
+    char result[8192] = {0};
+    c_code_gen_options options = c_code_gen_default_options();
+    options.optimization_level = 1;
+
+    emit_source(
+        "int main() {"
+        "   int x = 2;"
+        "   int y = x * 3;"
+        "   return y + 4;"
+        "}",
+        options,
+        result);
+
+    TEST_ASSERT_NULL(strstr(result, "[rbp"));
+    TEST_ASSERT_NULL(strstr(result, "sub rsp"));
+    // NOTE: every promoted value has a single known range
+    TEST_ASSERT_NOT_NULL(strstr(result, "    mov eax, 10\n"));
+}
+
+void test_code_gen_unpromoted_locals_use_stack(void) {
+    char result[8192] = {0};
+
+    emit_source(
+        "int main() {"
+        "   int x = 2;"
+        "   return x;"
+        "}",
+        c_code_gen_default_options(),
+        result);
+
+    TEST_ASSERT_NOT_NULL(strstr(result, "    mov dword [rbp-4], 2\n"
+                                        "    mov eax, dword [rbp-4]\n"));
+}
+
+void test_code_gen_values_across_calls_use_callee_saved(void) {
+    char result[8192] = {0};
+    c_code_gen_options options = c_code_gen_default_options();
+    options.optimization_level = 1;
+
+    emit_source(
+        "int f() { return 1; }"
+        "int main() {"
+        "   int a = f(); int b = f(); int c = f(); int d = f();"
+        "   int e = f(); int g = f(); int h = f();"
+        "   return a + b + c + d + e + g + h;"
+        "}",
+        options,
+        result);
+
+    TEST_ASSERT_NOT_NULL(strstr(result, "    mov rbp, rsp\n"
+                                        "    push rbx\n"
+                                        "    push r12\n"
+                                        "    push r13\n"
+                                        "    push r14\n"
+                                        "    push r15\n"
+                                        "    sub rsp, 8\n"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "    mov dword [rbp-44], eax\n"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "    lea rsp, [rbp-40]\n"
+                                        "    pop r15\n"));
+    TEST_ASSERT_NULL(strstr(result, "push rax"));
+}
+
+void test_code_gen_frame_is_laid_out_once(void) {
+    char result[8192] = {0};
+
+    emit_source(
+        "int main() {"
+        "   int a = 1;"
+        "   int b = f();"
+        "   int c = a + b;"
+        "   return c;"
+        "}",
+        c_code_gen_default_options(),
+        result);
+
+    TEST_ASSERT_NOT_NULL(strstr(result, "    mov rbp, rsp\n"
+                                        "    sub rsp, 16\n"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "dword [rbp-4]"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "dword [rbp-8]"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "dword [rbp-12]"));
+    TEST_ASSERT_NULL(strstr(result, "[rbp-16]"));
+
+    const char *first = strstr(result, "sub rsp");
+    TEST_ASSERT_NULL(strstr(first + 1, "sub rsp"));
+}
+
+void test_code_gen_omits_frame_pointer(void) {
+    char result[8192] = {0};
+    c_code_gen_options options = c_code_gen_default_options();
+    options.omit_frame_pointer = 1;
+
+    emit_source(
+        "int sq() {"
+        "   int a = 5;"
+        "   return a * a;"
+        "}"
+        "int main() {"
+        "   int x = sq();"
+        "   return x;"
+        "}",
+        options,
+        result);
+
+    TEST_ASSERT_NULL(strstr(result, "rbp"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "sq:\n"
+                                        "    mov dword [rsp-4], 5\n"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "main:\n"
+                                        "    sub rsp, 8\n"
+                                        "    call sq\n"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "dword [rsp+4]"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "    add rsp, 8\n"
+                                        "    ret\n"));
+}
+
+void test_code_gen_strength_reduces_constant_operands(void) {
+    char result[8192] = {0};
+    c_code_gen_options options = c_code_gen_default_options();
+    options.optimization_level = 1;
+
+    emit_source(
+        "int main() {"
+        "   int x = f();"
+        "   int a = x / 7;"
+        "   int b = x * 8;"
+        "   int c = x * 9;"
+        "   return a + b + c;"
+        "}",
+        options,
+        result);
+
+    TEST_ASSERT_NULL(strstr(result, "idiv"));
+    TEST_ASSERT_NULL(strstr(result, "imul ecx, ecx"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "    imul ecx\n"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "    shl "));
+    TEST_ASSERT_NOT_NULL(strstr(result, "    lea "));
+}
+
+void test_code_gen_int_arithmetic_is_32_bit(void) {
+    char result[8192] = {0};
+
+    emit_source(
+        "int main() {"
+        "   int x = f();"
+        "   int y = f();"
+        "   return x / y;"
+        "}",
+        c_code_gen_default_options(),
+        result);
+
+    TEST_ASSERT_NULL(strstr(result, "cqo"));
+    TEST_ASSERT_NULL(strstr(result, "qword"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "    mov eax, dword [rbp-4]\n"
+                                        "    cdq\n"
+                                        "    idiv dword [rbp-8]\n"));
+}
+
+void test_code_gen_tail_calls_jump(void) {
+    char result[8192] = {0};
+    c_code_gen_options options = c_code_gen_options_for_level(2);
+
+    emit_source(
+        "int g() { return 7; }"
+        "int f() { return g(); }"
+        "int main() { int x = f(); return x + 1; }",
+        options,
+        result);
+
+    TEST_ASSERT_NOT_NULL(strstr(result, "f:\n"
+                                        "\n"
+                                        "    jmp g\n"));
+    TEST_ASSERT_NULL(strstr(result, "call g"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "call f"));
+
+    memset(result, 0, sizeof(result));
+    options.tail_calls = 0;
+    emit_source("int f() { return g(); }", options, result);
+
+    TEST_ASSERT_NOT_NULL(strstr(result, "call g"));
+    TEST_ASSERT_NULL(strstr(result, "jmp g"));
+}
+
+// NOTE: b0: c = call f; br c, b1, b2
+// b1: ret 1, or t = call then_callee; ret t
+// b2: ret 2
+static c_ir_function *pick_function(const char *then_callee) {
+    c_ir_function *function = c_ir_function_create("pick");
+    int entry = c_ir_function_add_block(function);
+    int then_block = c_ir_function_add_block(function);
+    int else_block = c_ir_function_add_block(function);
+
+    int condition =
+        c_ir_function_append(function, entry, c_ir_make_call("f"));
+    c_ir_function_append(
+        function, entry, c_ir_make_branch(condition, then_block, else_block));
+
+    c_ir_instruction returned = then_callee ? c_ir_make_call(then_callee)
+                                            : c_ir_make_constant(1);
+    int one = c_ir_function_append(function, then_block, returned);
+    c_ir_function_append(
+        function, then_block, c_ir_make(C_IR_RETURN, one, C_IR_NO_VALUE));
+
+    int two = c_ir_function_append(function, else_block, c_ir_make_constant(2));
+    c_ir_function_append(
+        function, else_block, c_ir_make(C_IR_RETURN, two, C_IR_NO_VALUE));
+
+    c_ir_function_compute_cfg(function);
+
+    return function;
+}
+
+static void emit_ir_function(c_ir_function *function,
+                             c_code_gen_options options,
+                             char *result) {
+    char **lines = c_code_gen_emit_function(function, options);
+
+    for (int i = 0; i < arrlen(lines); i++) {
+        strcat(result, lines[i]);
+        strcat(result, "\n");
+        free(lines[i]);
+    }
+
+    arrfree(lines);
+    c_ir_function_free(function);
+}
+
+void test_code_gen_returns_share_epilogue(void) {
+    c_code_gen_options levels[] = {
+        c_code_gen_default_options(),
+        c_code_gen_options_for_level(2),
+    };
+
+    for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+        char result[8192] = {0};
+        emit_ir_function(pick_function(NULL), levels[l], result);
+
+        const char *first = strstr(result, "    jmp .Lreturn\n");
+        TEST_ASSERT_NOT_NULL(first);
+        TEST_ASSERT_NOT_NULL(strstr(first + 1, "    jmp .Lreturn\n"));
+        TEST_ASSERT_NOT_NULL(strstr(result, ".Lreturn:\n"));
+
+        // NOTE: the epilogue is emitted once, after the last block
+        const char *ret = strstr(result, "    ret\n");
+        TEST_ASSERT_NOT_NULL(ret);
+        TEST_ASSERT_TRUE(ret > strstr(result, ".Lreturn:\n"));
+        TEST_ASSERT_NULL(strstr(ret + 1, "    ret\n"));
+    }
+}
+
+void test_code_gen_tail_call_keeps_own_epilogue(void) {
+    char result[8192] = {0};
+    c_code_gen_options options = c_code_gen_default_options();
+    options.tail_calls = 1;
+
+    // NOTE: one plain return is left, so nothing is shared
+    emit_ir_function(pick_function("g"), options, result);
+
+    TEST_ASSERT_NULL(strstr(result, ".Lreturn"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "    jmp g\n"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "    ret\n"));
+
+    memset(result, 0, sizeof(result));
+    options.tail_calls = 0;
+    emit_ir_function(pick_function("g"), options, result);
+
+    TEST_ASSERT_NOT_NULL(strstr(result, "    call g\n"));
+    TEST_ASSERT_NOT_NULL(strstr(result, ".Lreturn:\n"));
+}
+
+void test_code_gen_skips_unreachable_functions(void) {
+    char result[8192] = {0};
+
+    emit_source(
+        "int unused() { return 5; }"
+        "int used() { return 3; }"
+        "int main() { return used(); }",
+        c_code_gen_default_options(),
+        result);
+
+    TEST_ASSERT_NULL(strstr(result, "unused"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "used:\n"));
+}
+
+void test_code_gen_parallel_output_matches_serial(void) {
+    char source[4096] = "int f0() { return 1; }";
+    static char serial[65536];
+    static char parallel[65536];
+
+    for (int i = 1; i < 24; i++) {
+        sprintf(source + strlen(source),
+                "int f%d() { int a = f%d(); int b = a * %d; return b + f0(); }",
+                i, i - 1, i);
+    }
+    strcat(source, "int main() { return f23() / 7; }");
+
+    c_code_gen_options options = c_code_gen_options_for_level(2);
+    serial[0] = '\0';
+    emit_source(source, options, serial);
+
+    options.jobs = 4;
+    parallel[0] = '\0';
+    emit_source(source, options, parallel);
+
+    TEST_ASSERT_NOT_NULL(strstr(serial, "f23:\n"));
+    TEST_ASSERT_EQUAL_STRING(serial, parallel);
+}
+
+void test_code_gen_non_negative_division_skips_sign_fix_ups(void) {
+    char result[4096] = {0};
+    char **lines = NULL;
+    c_code_gen_context context = {.machine = c_mir_function_create("f")};
+    c_mir_operand work = c_mir_register(C_X86_RCX, 4);
+
+    c_code_gen_emit_division_by_constant(&context, work, work, 3, 0, 1, 0);
+    c_code_gen_emit_division_by_constant(&context, work, work, 7, 0, 1, 0);
+    c_mir_print_function(context.machine, &lines);
+
+    for (int i = 0; i < arrlen(lines); i++) {
+        strcat(result, lines[i]);
+        strcat(result, "\n");
+        free(lines[i]);
+    }
+
+    // NOTE: 3 has an exact unsigned magic, 7 keeps the signed one
+    // without the rounding that only matters below zero
+    TEST_ASSERT_NOT_NULL(strstr(result, "    mov eax, -1431655765\n"
+                                        "    mul ecx\n"
+                                        "    shr edx, 1\n"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "    imul ecx\n"));
+    TEST_ASSERT_NULL(strstr(result, "shr eax, 31"));
+
+    arrfree(lines);
+    c_mir_function_free(context.machine);
+}
+
 int main(void) {
     UNITY_BEGIN();
 
     RUN_TEST(test_code_gen_main_function);
+    RUN_TEST(test_code_gen_promoted_locals_skip_memory);
+    RUN_TEST(test_code_gen_unpromoted_locals_use_stack);
+    RUN_TEST(test_code_gen_values_across_calls_use_callee_saved);
+    RUN_TEST(test_code_gen_frame_is_laid_out_once);
+    RUN_TEST(test_code_gen_omits_frame_pointer);
+    RUN_TEST(test_code_gen_strength_reduces_constant_operands);
+    RUN_TEST(test_code_gen_int_arithmetic_is_32_bit);
+    RUN_TEST(test_code_gen_tail_calls_jump);
+    RUN_TEST(test_code_gen_returns_share_epilogue);
+    RUN_TEST(test_code_gen_tail_call_keeps_own_epilogue);
+    RUN_TEST(test_code_gen_skips_unreachable_functions);
+    RUN_TEST(test_code_gen_parallel_output_matches_serial);
+    RUN_TEST(test_code_gen_non_negative_division_skips_sign_fix_ups);
     return UNITY_END();
 }
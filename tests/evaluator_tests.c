@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "constant_folding.h"
+#include "evaluator.h"
+#include "stb_ds.h"
+#include "test_program.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static test_program eval_source(const char *source, int *replaced) {
+    test_program fixture = test_program_parse(source);
+    *replaced = c_eval_program(fixture.program);
+
+    return fixture;
+}
+
+void test_eval_replaces_calls_with_results(void) {
+    int replaced;
+    test_program fixture = eval_source(
+        "int tablesize() { return 64 * 16; }"
+        "int scale() { int s = tablesize(); { int s = 2; } return s / 4; }"
+        "int main() { return scale() + tablesize(); }", &replaced);
+
+    // NOTE: the call in scale and both calls in main
+    TEST_ASSERT_EQUAL(3, replaced);
+
+    c_fold_program(
+        fixture.program, fixture.error_context, TEST_PROGRAM_FILENAME);
+    c_ast_expression *value = test_program_returned(fixture);
+    TEST_ASSERT_EQUAL(C_CONSTANT, value->type);
+    TEST_ASSERT_EQUAL(1280, value->constant->value);
+
+    test_program_free(fixture);
+}
+
+void test_eval_keeps_calls_that_may_not_return(void) {
+    int replaced;
+    test_program fixture =
+        eval_source("int r() { return r(); }"
+                    "int trap() { int zero = 0; return 1 / zero; }"
+                    "int outside() { return g(); }"
+                    "int nothing() { int a = 1; }"
+                    "int main() {"
+                    "   return r() + trap() + outside() + nothing();"
+                    "}", &replaced);
+
+    TEST_ASSERT_EQUAL(0, replaced);
+    TEST_ASSERT_EQUAL(C_FUNCTION_CALL,
+                      test_program_returned(fixture)->binary->rhs->type);
+
+    test_program_free(fixture);
+}
+
+void test_eval_stops_at_depth_limit(void) {
+    static char source[65536];
+    int chain = C_EVAL_MAX_DEPTH + 44;
+    int length = 0;
+
+    // NOTE: callers come first, so one evaluation walks the whole chain
+    for (int i = chain; i > 0; i--) {
+        length += snprintf(source + length,
+                           sizeof(source) - length,
+                           "int f%d() { return f%d() + 1; }",
+                           i,
+                           i - 1);
+    }
+
+    snprintf(source + length,
+             sizeof(source) - length,
+             "int f0() { return 0; } int main() { return f%d(); }",
+             chain);
+
+    int replaced;
+    test_program fixture = eval_source(source, &replaced);
+    c_ast_expression *value = test_program_returned(fixture);
+
+    TEST_ASSERT_TRUE(replaced > 0);
+    TEST_ASSERT_EQUAL(C_FUNCTION_CALL, value->type);
+
+    test_program_free(fixture);
+}
+
+void test_eval_budget_is_per_call_site(void) {
+    test_program fixture =
+        test_program_parse("int six() { int a = 2; return a * 3; }"
+                           "int main() { return six(); }");
+    c_eval_context context = {.program = fixture.program};
+    int value = 0;
+
+    for (int i = 0; i < arrlen(fixture.program->function_declarations); i++) {
+        c_eval_function function = {
+            .declaration = fixture.program->function_declarations[i],
+            .state = C_EVAL_UNKNOWN,
+        };
+        arrput(context.functions, function);
+    }
+
+    // NOTE: as if an earlier call site used up the whole budget
+    context.steps = C_EVAL_MAX_STEPS;
+
+    TEST_ASSERT_TRUE(c_eval_function_value(&context, "six", &value));
+    TEST_ASSERT_EQUAL(6, value);
+
+    arrfree(context.functions);
+    arrfree(context.locals);
+    test_program_free(fixture);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_eval_replaces_calls_with_results);
+    RUN_TEST(test_eval_keeps_calls_that_may_not_return);
+    RUN_TEST(test_eval_stops_at_depth_limit);
+    RUN_TEST(test_eval_budget_is_per_call_site);
+    return UNITY_END();
+}
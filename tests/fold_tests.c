@@ -0,0 +1,115 @@
+#include <limits.h>
+#include <string.h>
+#include "unity.h"
+#include "constant_folding.h"
+#include "stb_ds.h"
+#include "test_program.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static test_program fold_source(const char *source) {
+    test_program fixture = test_program_parse(source);
+    c_fold_program(
+        fixture.program, fixture.error_context, TEST_PROGRAM_FILENAME);
+
+    return fixture;
+}
+
+void test_fold_constant_arithmetic(void) {
+    test_program fixture = fold_source("int main() { return 2 * 3 + 4; }");
+
+    c_ast_expression *value = test_program_returned(fixture);
+    TEST_ASSERT_EQUAL(C_CONSTANT, value->type);
+    TEST_ASSERT_EQUAL(10, value->constant->value);
+
+    test_program_free(fixture);
+}
+
+void test_fold_wraps_and_truncates_like_c(void) {
+    test_program fixture = fold_source(
+        "int main() {"
+        "   int a = 2147483647 + 1;"
+        "   int b = 0 - 7 / 2;"
+        "   return 65536 * 65536;"
+        "}");
+
+    c_ast_block *body = test_program_main(fixture);
+    TEST_ASSERT_EQUAL(INT_MIN,
+                      body->statements[0]->assignment->expression->constant->value);
+    TEST_ASSERT_EQUAL(-3,
+                      body->statements[1]->assignment->expression->constant->value);
+    TEST_ASSERT_EQUAL(0, test_program_returned(fixture)->constant->value);
+
+    test_program_free(fixture);
+}
+
+void test_fold_diagnoses_division_by_zero(void) {
+    test_program fixture = fold_source("int main() {\n  return 1 / 0;\n}");
+
+    c_ast_expression *value = test_program_returned(fixture);
+    TEST_ASSERT_EQUAL(C_BINARY_EXPRESSION, value->type);
+    TEST_ASSERT_EQUAL(1, arrlen(fixture.error_context->errors));
+    TEST_ASSERT_EQUAL(C_SEVERITY_WARNING,
+                      fixture.error_context->errors[0].severity);
+    TEST_ASSERT_EQUAL(2, fixture.error_context->errors[0].line);
+    TEST_ASSERT_FALSE(c_error_context_has_errors(fixture.error_context));
+
+    test_program_free(fixture);
+}
+
+void test_fold_identities(void) {
+    test_program fixture = fold_source(
+        "int main() {"
+        "   int x = 5;"
+        "   int a = x + 0;"
+        "   int b = 1 * x;"
+        "   int c = x * 0;"
+        "   int d = x - x;"
+        "   int e = x / 1;"
+        "   return x + 1 + 2;"
+        "}");
+
+    c_ast_statement **statements =
+        test_program_main(fixture)->statements;
+
+    TEST_ASSERT_EQUAL(C_VARIABLE, statements[1]->assignment->expression->type);
+    TEST_ASSERT_EQUAL(C_VARIABLE, statements[2]->assignment->expression->type);
+    TEST_ASSERT_EQUAL(0, statements[3]->assignment->expression->constant->value);
+    TEST_ASSERT_EQUAL(0, statements[4]->assignment->expression->constant->value);
+    TEST_ASSERT_EQUAL(C_VARIABLE, statements[5]->assignment->expression->type);
+
+    c_ast_expression *value = test_program_returned(fixture);
+    TEST_ASSERT_EQUAL(C_BINARY_EXPRESSION, value->type);
+    TEST_ASSERT_EQUAL(C_VARIABLE, value->binary->lhs->type);
+    TEST_ASSERT_EQUAL(3, value->binary->rhs->constant->value);
+
+    test_program_free(fixture);
+}
+
+void test_fold_keeps_calls(void) {
+    test_program fixture = fold_source(
+        "int main() {"
+        "   return f() * 0 + f() - f();"
+        "}");
+
+    c_ast_expression *value = test_program_returned(fixture);
+    TEST_ASSERT_EQUAL(C_BINARY_EXPRESSION, value->type);
+    TEST_ASSERT_EQUAL('-', value->binary->symbol);
+    TEST_ASSERT_EQUAL(C_FUNCTION_CALL, value->binary->rhs->type);
+    TEST_ASSERT_EQUAL('*', value->binary->lhs->binary->lhs->binary->symbol);
+
+    test_program_free(fixture);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_fold_constant_arithmetic);
+    RUN_TEST(test_fold_wraps_and_truncates_like_c);
+    RUN_TEST(test_fold_diagnoses_division_by_zero);
+    RUN_TEST(test_fold_identities);
+    RUN_TEST(test_fold_keeps_calls);
+    return UNITY_END();
+}
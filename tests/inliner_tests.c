@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "constant_folding.h"
+#include "inliner.h"
+#include "interpreter.h"
+#include "stb_ds.h"
+#include "test_program.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static test_program inline_source(const char *source,
+                                  int threshold,
+                                  int *inlined) {
+    test_program fixture = test_program_parse(source);
+    *inlined = c_inline_program(fixture.program, threshold);
+    c_fold_program(
+        fixture.program, fixture.error_context, TEST_PROGRAM_FILENAME);
+
+    return fixture;
+}
+
+void test_inline_folds_constant_callees(void) {
+    int inlined;
+    test_program fixture =
+        inline_source("int one() { return 1; }"
+                      "int main() { return one() + 2; }",
+                      C_INLINE_DEFAULT_THRESHOLD,
+                      &inlined);
+
+    TEST_ASSERT_EQUAL(1, inlined);
+    c_ast_expression *value = test_program_returned(fixture);
+    TEST_ASSERT_EQUAL(C_CONSTANT, value->type);
+    TEST_ASSERT_EQUAL(3, value->constant->value);
+
+    test_program_free(fixture);
+}
+
+void test_inline_substitutes_callee_locals(void) {
+    int inlined;
+    test_program fixture = inline_source(
+        "int six() { return 6; }"
+        "int f() { int a = six(); { int a = 1; } int b = a * 7; return b; }"
+        "int main() { return f(); }",
+        C_INLINE_DEFAULT_THRESHOLD,
+        &inlined);
+
+    c_ast_expression *value = test_program_returned(fixture);
+    TEST_ASSERT_EQUAL(C_CONSTANT, value->type);
+    TEST_ASSERT_EQUAL(42, value->constant->value);
+
+    test_program_free(fixture);
+}
+
+void test_inline_skips_recursive_functions(void) {
+    int inlined;
+    test_program fixture = inline_source("int f() { return g() + 1; }"
+                                         "int g() { return f(); }"
+                                         "int main() { return f(); }",
+                                         C_INLINE_DEFAULT_THRESHOLD,
+                                         &inlined);
+
+    TEST_ASSERT_EQUAL(0, inlined);
+    c_ast_expression *value = test_program_returned(fixture);
+    TEST_ASSERT_EQUAL(C_FUNCTION_CALL, value->type);
+    TEST_ASSERT_EQUAL_STRING("f", value->function_call->function_name);
+
+    test_program_free(fixture);
+}
+
+void test_inline_follows_threshold(void) {
+    const char *source = "int r() { return r(); }"
+                         "int x() { return 3; }"
+                         "int f() { return r() + x() * 2 + x() * 3; }"
+                         "int main() { return f() + f(); }";
+
+    // NOTE: x folds to a constant and is inlined at any threshold
+    int inlined;
+    test_program small = inline_source(source, 0, &inlined);
+    TEST_ASSERT_EQUAL(2, inlined);
+    TEST_ASSERT_EQUAL(C_FUNCTION_CALL,
+                      test_program_returned(small)->binary->lhs->type);
+    test_program_free(small);
+
+    test_program large =
+        inline_source(source, C_INLINE_DEFAULT_THRESHOLD, &inlined);
+    TEST_ASSERT_EQUAL(4, inlined);
+    TEST_ASSERT_EQUAL(C_BINARY_EXPRESSION,
+                      test_program_returned(large)->binary->lhs->type);
+    test_program_free(large);
+}
+
+void test_inline_keeps_calls_evaluated_once(void) {
+    int inlined;
+    test_program fixture =
+        inline_source("int r() { return r(); }"
+                      "int once() { int a = r(); return a + 1; }"
+                      "int twice() { int a = r(); return a * a; }"
+                      "int dropped() { int a = r(); return 2; }"
+                      "int main() { return once() + twice() + dropped(); }",
+                      C_INLINE_DEFAULT_THRESHOLD,
+                      &inlined);
+
+    // NOTE: r() + 1 + twice() + dropped()
+    TEST_ASSERT_EQUAL(1, inlined);
+    c_ast_expression *value = test_program_returned(fixture);
+    c_ast_expression *lhs = value->binary->lhs->binary->lhs;
+    TEST_ASSERT_EQUAL(C_BINARY_EXPRESSION, lhs->type);
+    TEST_ASSERT_EQUAL_STRING("r",
+                             lhs->binary->lhs->function_call->function_name);
+    TEST_ASSERT_EQUAL_STRING(
+        "twice", value->binary->lhs->binary->rhs->function_call->function_name);
+    TEST_ASSERT_EQUAL_STRING("dropped",
+                             value->binary->rhs->function_call->function_name);
+
+    test_program_free(fixture);
+}
+
+void test_inline_keeps_calls_in_order(void) {
+    int inlined;
+    test_program fixture =
+        inline_source("int f() {"
+                      "   int a = exta(); int b = extb(); return b + a;"
+                      "}"
+                      "int g() { int a = exta(); return extb() + a; }"
+                      "int main() { return f() + g(); }",
+                      C_INLINE_DEFAULT_THRESHOLD,
+                      &inlined);
+
+    // NOTE: substituting either local would call extb first
+    TEST_ASSERT_EQUAL(0, inlined);
+    c_ast_expression *value = test_program_returned(fixture);
+    TEST_ASSERT_EQUAL_STRING("f",
+                             value->binary->lhs->function_call->function_name);
+    TEST_ASSERT_EQUAL_STRING("g",
+                             value->binary->rhs->function_call->function_name);
+
+    test_program_free(fixture);
+}
+
+void test_inline_bounds_repeated_locals(void) {
+    // NOTE: every local is used twice, copying doubles per line
+    char source[2048] = "int f() { int v0 = 1;";
+    for (int i = 1; i <= 40; i++) {
+        size_t length = strlen(source);
+        snprintf(source + length, sizeof(source) - length,
+                 " int v%d = v%d + v%d;", i, i - 1, i - 1);
+    }
+    strcat(source, " return v40; } int main() { return f(); }");
+
+    int inlined;
+    test_program fixture =
+        inline_source(source, C_INLINE_DEFAULT_THRESHOLD, &inlined);
+
+    TEST_ASSERT_EQUAL(0, inlined);
+    TEST_ASSERT_EQUAL(C_FUNCTION_CALL, test_program_returned(fixture)->type);
+
+    test_program_free(fixture);
+}
+
+void test_inline_warns_once_per_location(void) {
+    int inlined;
+    test_program fixture =
+        inline_source("int bad() { return 1 / 0; }"
+                      "int main() { return bad() + bad() * bad(); }",
+                      C_INLINE_DEFAULT_THRESHOLD,
+                      &inlined);
+
+    TEST_ASSERT_EQUAL(3, inlined);
+    TEST_ASSERT_EQUAL(1, arrlen(fixture.error_context->errors));
+    TEST_ASSERT_EQUAL(C_SEVERITY_WARNING,
+                      fixture.error_context->errors[0].severity);
+
+    test_program_free(fixture);
+}
+
+static int interpret(c_ast_program *program) {
+    c_bytecode_module *module = c_bytecode_compile(program);
+    int result = 0;
+
+    TEST_ASSERT_EQUAL(C_INTERPRETER_OK,
+                      c_interpreter_run(module, C_INTERPRETER_ENTRY, &result));
+    c_bytecode_module_free(module);
+
+    return result;
+}
+
+void test_inline_preserves_results(void) {
+    const char *sources[] = {
+        "int a() { int x = 7; int y = x * x; return y - x / 2; }"
+        "int b() { int x = a(); return x * 3 + a(); }"
+        "int main() { int x = b(); { int x = a(); } return x - b() / 5; }",
+        "int k() { return 0 - 17; }"
+        "int d() { int z = k() / 5; return z * k(); }"
+        "int main() { return d() + k() * 3 / 7; }",
+        "int big() { return 2147483647; }"
+        "int main() { int x = big() + big(); return x * 3 + 7; }",
+    };
+
+    for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); i++) {
+        int none;
+        int some;
+        test_program original = inline_source(sources[i], -1000, &none);
+        test_program inlined =
+            inline_source(sources[i], C_INLINE_DEFAULT_THRESHOLD, &some);
+
+        TEST_ASSERT_EQUAL(0, none);
+        TEST_ASSERT_TRUE(some > 0);
+        TEST_ASSERT_EQUAL_MESSAGE(interpret(original.program),
+                                  interpret(inlined.program),
+                                  sources[i]);
+
+        test_program_free(original);
+        test_program_free(inlined);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_inline_folds_constant_callees);
+    RUN_TEST(test_inline_substitutes_callee_locals);
+    RUN_TEST(test_inline_skips_recursive_functions);
+    RUN_TEST(test_inline_follows_threshold);
+    RUN_TEST(test_inline_keeps_calls_evaluated_once);
+    RUN_TEST(test_inline_keeps_calls_in_order);
+    RUN_TEST(test_inline_bounds_repeated_locals);
+    RUN_TEST(test_inline_warns_once_per_location);
+    RUN_TEST(test_inline_preserves_results);
+    return UNITY_END();
+}
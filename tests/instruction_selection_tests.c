@@ -0,0 +1,134 @@
+#include <string.h>
+#include "unity.h"
+#include "instruction_selection.h"
+#include "ir.h"
+#include "register_allocator.h"
+#include "ssa.h"
+#include "stb_ds.h"
+#include "test_program.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+typedef struct {
+    c_ir_module *module;
+    c_ir_function *function;
+    int *use_counts;
+    c_register_allocation *allocation;
+    c_isel_selection *selection;
+} isel_fixture;
+
+static isel_fixture select_source(const char *source, int promote) {
+    isel_fixture fixture = {0};
+    test_program parsed = test_program_parse(source);
+    fixture.module = c_ir_lower_program(parsed.program);
+    test_program_free(parsed);
+    fixture.function = fixture.module->functions[0];
+
+    if (promote) {
+        c_ssa_promote_allocas(fixture.function);
+    }
+
+    fixture.use_counts = c_ir_use_counts(fixture.function);
+    fixture.allocation = c_register_allocate(fixture.function);
+    fixture.selection = c_isel_select(
+        fixture.function, fixture.use_counts, fixture.allocation);
+
+    return fixture;
+}
+
+static void fixture_free(isel_fixture fixture) {
+    c_isel_selection_free(fixture.selection);
+    c_register_allocation_free(fixture.allocation);
+    arrfree(fixture.use_counts);
+    c_ir_module_free(fixture.module);
+}
+
+static int count_form(isel_fixture fixture, c_ir_opcode opcode,
+                      c_isel_form form) {
+    int count = 0;
+
+    for (int v = 0; v < arrlen(fixture.function->instructions); v++) {
+        count += fixture.function->instructions[v].opcode == opcode
+                 && fixture.selection->forms[v] == form;
+    }
+
+    return count;
+}
+
+// NOTE: the value returned by the function
+static int returned(isel_fixture fixture) {
+    c_ir_function *function = fixture.function;
+    int ret = c_ir_block_terminator(function, 0);
+    return function->instructions[ret].operands[0];
+}
+
+void test_isel_costs_favour_lea_over_imul(void) {
+    TEST_ASSERT_TRUE(c_isel_cost(C_ISEL_LEA) < c_isel_cost(C_ISEL_IMUL));
+    TEST_ASSERT_TRUE(c_isel_cost(C_ISEL_LEA)
+                     <= c_isel_cost(C_ISEL_LEA_COMPLEX));
+    TEST_ASSERT_TRUE(c_isel_cost(C_ISEL_LEA)
+                     < c_isel_cost(C_ISEL_MOVE) + c_isel_cost(C_ISEL_ALU));
+}
+
+void test_isel_covers_scaled_add_with_lea(void) {
+    isel_fixture fixture = select_source(
+        "int main() { int a = f(); int b = g(); return a + b * 4 + 5; }", 1);
+    int root = returned(fixture);
+    c_isel_address *address = &fixture.selection->addresses[root];
+
+    TEST_ASSERT_EQUAL(C_ISEL_ADDRESS, fixture.selection->forms[root]);
+    TEST_ASSERT_EQUAL(4, address->scale);
+    TEST_ASSERT_EQUAL(5, address->displacement);
+    TEST_ASSERT_EQUAL(C_IR_CALL,
+                      fixture.function->instructions[address->base].opcode);
+    TEST_ASSERT_EQUAL(C_IR_CALL,
+                      fixture.function->instructions[address->index].opcode);
+    TEST_ASSERT_EQUAL(1, count_form(fixture, C_IR_MULTIPLY, C_ISEL_FOLDED));
+    TEST_ASSERT_EQUAL(1, count_form(fixture, C_IR_ADD, C_ISEL_FOLDED));
+
+    fixture_free(fixture);
+}
+
+void test_isel_keeps_two_address_add_in_place(void) {
+    // NOTE: a is dead after the add, the sum reuses its register
+    isel_fixture fixture =
+        select_source("int main() { int a = f(); return a + 5; }", 1);
+
+    TEST_ASSERT_EQUAL(C_ISEL_EMIT, fixture.selection->forms[returned(fixture)]);
+
+    fixture_free(fixture);
+}
+
+void test_isel_does_not_cover_across_calls(void) {
+    isel_fixture fixture = select_source(
+        "int main() { int a = f(); int b = a * 4; int c = g(); "
+        "return b + c; }",
+        1);
+
+    TEST_ASSERT_EQUAL(0, count_form(fixture, C_IR_MULTIPLY, C_ISEL_FOLDED));
+
+    fixture_free(fixture);
+}
+
+void test_isel_folds_loads_into_their_user(void) {
+    isel_fixture fixture = select_source(
+        "int main() { int a = 2; int b = 3; int c = a * b; return c; }", 0);
+
+    // NOTE: a and b for the multiply, c for the return
+    TEST_ASSERT_EQUAL(3, count_form(fixture, C_IR_LOAD, C_ISEL_FOLDED));
+
+    fixture_free(fixture);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_isel_costs_favour_lea_over_imul);
+    RUN_TEST(test_isel_covers_scaled_add_with_lea);
+    RUN_TEST(test_isel_keeps_two_address_add_in_place);
+    RUN_TEST(test_isel_does_not_cover_across_calls);
+    RUN_TEST(test_isel_folds_loads_into_their_user);
+    return UNITY_END();
+}
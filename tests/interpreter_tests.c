@@ -0,0 +1,213 @@
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "assembler.h"
+#include "code_generator.h"
+#include "interpreter.h"
+#include "ir.h"
+#include "jit.h"
+#include "ssa.h"
+#include "stb_ds.h"
+#include "test_program.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static c_interpreter_status interpret(const char *source, int *result) {
+    test_program fixture = test_program_parse(source);
+    c_bytecode_module *module = c_bytecode_compile(fixture.program);
+    c_interpreter_status status =
+        c_interpreter_run(module, C_INTERPRETER_ENTRY, result);
+
+    c_bytecode_module_free(module);
+    test_program_free(fixture);
+
+    return status;
+}
+
+static int interpret_ok(const char *source) {
+    int result = -1;
+
+    TEST_ASSERT_EQUAL_INT(C_INTERPRETER_OK, interpret(source, &result));
+
+    return result;
+}
+
+void test_interpreter_evaluates_arithmetic(void) {
+    TEST_ASSERT_EQUAL_INT(69, interpret_ok("int main() { return 69; }"));
+    TEST_ASSERT_EQUAL_INT(
+        10, interpret_ok("int main() { return 2 * 3 + 4; }"));
+    TEST_ASSERT_EQUAL_INT(
+        -2, interpret_ok("int main() { return 0 - 7 / 3; }"));
+    TEST_ASSERT_EQUAL_INT(7, interpret_ok("int main() {"
+                                          "   int x = 5;"
+                                          "   int y = x * 2;"
+                                          "   int z = y - 3;"
+                                          "   return z;"
+                                          "}"));
+    // NOTE: 65536 * 65536 wraps to 0 in 32 bits
+    TEST_ASSERT_EQUAL_INT(
+        11, interpret_ok("int main() { return 65536 * 65536 + 11; }"));
+}
+
+void test_interpreter_calls_functions(void) {
+    TEST_ASSERT_EQUAL_INT(42, interpret_ok("int six() { return 6; }"
+                                           "int seven() {"
+                                           "   int x = six();"
+                                           "   return x + 1;"
+                                           "}"
+                                           "int main() {"
+                                           "   return six() * seven();"
+                                           "}"));
+    // NOTE: no return value reads as zero
+    TEST_ASSERT_EQUAL_INT(3, interpret_ok("int f() { int x = 1; }"
+                                          "int main() { return f() + 3; }"));
+}
+
+void test_interpreter_reports_traps(void) {
+    int result = -1;
+
+    TEST_ASSERT_EQUAL_INT(C_INTERPRETER_ARITHMETIC_ERROR,
+                          interpret("int zero() { return 0; }"
+                                    "int main() { return 1 / zero(); }",
+                                    &result));
+    TEST_ASSERT_EQUAL_INT(C_INTERPRETER_STACK_OVERFLOW,
+                          interpret("int f() { return f(); }"
+                                    "int main() { return f(); }",
+                                    &result));
+    TEST_ASSERT_EQUAL_INT(C_INTERPRETER_UNDEFINED_ENTRY,
+                          interpret("int f() { return 1; }", &result));
+    TEST_ASSERT_EQUAL_INT(-1, result);
+}
+
+// b0: i = 10; s = 0; jmp b1
+// b1: br i, b2, b3
+// b2: s = s + i; i = i - 1; jmp b1
+// b3: ret s
+static c_ir_function *build_sum_loop(void) {
+    c_ir_function *function = c_ir_function_create("main");
+    int entry = c_ir_function_add_block(function);
+    int header = c_ir_function_add_block(function);
+    int body = c_ir_function_add_block(function);
+    int exit = c_ir_function_add_block(function);
+
+    c_ir_instruction alloca_instruction =
+        c_ir_make(C_IR_ALLOCA, C_IR_NO_VALUE, C_IR_NO_VALUE);
+    int i = c_ir_function_append(function, entry, alloca_instruction);
+    int s = c_ir_function_append(function, entry, alloca_instruction);
+    int ten = c_ir_function_append(function, entry, c_ir_make_constant(10));
+    int zero = c_ir_function_append(function, entry, c_ir_make_constant(0));
+    c_ir_function_append(function, entry, c_ir_make(C_IR_STORE, i, ten));
+    c_ir_function_append(function, entry, c_ir_make(C_IR_STORE, s, zero));
+    c_ir_function_append(function, entry, c_ir_make_jump(header));
+
+    int condition = c_ir_function_append(
+        function, header, c_ir_make(C_IR_LOAD, i, C_IR_NO_VALUE));
+    c_ir_function_append(
+        function, header, c_ir_make_branch(condition, body, exit));
+
+    int old_s = c_ir_function_append(
+        function, body, c_ir_make(C_IR_LOAD, s, C_IR_NO_VALUE));
+    int old_i = c_ir_function_append(
+        function, body, c_ir_make(C_IR_LOAD, i, C_IR_NO_VALUE));
+    int sum =
+        c_ir_function_append(function, body, c_ir_make(C_IR_ADD, old_s, old_i));
+    int one = c_ir_function_append(function, body, c_ir_make_constant(1));
+    int next = c_ir_function_append(
+        function, body, c_ir_make(C_IR_SUBTRACT, old_i, one));
+    c_ir_function_append(function, body, c_ir_make(C_IR_STORE, s, sum));
+    c_ir_function_append(function, body, c_ir_make(C_IR_STORE, i, next));
+    c_ir_function_append(function, body, c_ir_make_jump(header));
+
+    int result = c_ir_function_append(
+        function, exit, c_ir_make(C_IR_LOAD, s, C_IR_NO_VALUE));
+    c_ir_function_append(
+        function, exit, c_ir_make(C_IR_RETURN, result, C_IR_NO_VALUE));
+
+    c_ir_function_compute_cfg(function);
+
+    return function;
+}
+
+static int run_function(c_ir_function *function) {
+    c_ir_module module = {0};
+    int result = -1;
+
+    arrput(module.functions, function);
+
+    c_bytecode_module *bytecode = c_bytecode_compile_module(&module);
+    TEST_ASSERT_EQUAL_INT(
+        C_INTERPRETER_OK,
+        c_interpreter_run(bytecode, C_INTERPRETER_ENTRY, &result));
+
+    c_bytecode_module_free(bytecode);
+    arrfree(module.functions);
+
+    return result;
+}
+
+void test_interpreter_runs_loops_through_memory_and_phis(void) {
+    c_ir_function *function = build_sum_loop();
+
+    TEST_ASSERT_EQUAL_INT(55, run_function(function));
+
+    TEST_ASSERT_EQUAL_INT(2, c_ssa_promote_allocas(function));
+    TEST_ASSERT_EQUAL_INT(55, run_function(function));
+
+    c_ir_function_free(function);
+}
+
+static int native(const char *source, int optimization_level) {
+    test_program fixture = test_program_parse(source);
+    c_mir_module *machine = c_code_gen_select_program(
+        fixture.program, c_code_gen_options_for_level(optimization_level));
+    c_asm_object *object = c_asm_assemble_module(machine);
+    int result = c_jit_run(object, C_JIT_ENTRY);
+
+    c_asm_object_free(object);
+    c_mir_module_free(machine);
+    test_program_free(fixture);
+
+    return result;
+}
+
+void test_interpreter_matches_native_code(void) {
+#if defined(__x86_64__) && defined(__linux__)
+    const char *sources[] = {
+        "int main() { return 1 + 2 * 3 - 4 / 2; }",
+        "int f() { return 9; }"
+        "int g() { int a = f(); int b = a * a; return b - f() / 2; }"
+        "int main() { int x = g(); { int x = 3; } return x + g(); }",
+        "int k() { return 0 - 17; }"
+        "int main() { return k() / 5 + k() * 3 / 7; }",
+        "int big() { return 2147483647; }"
+        "int main() { int x = big() + big(); return x * 3 + 7; }",
+        "int main() {"
+        "   int a = 7; int b = a * 10; int c = b / 3; return c * a;"
+        "}",
+    };
+
+    for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); i++) {
+        int expected = interpret_ok(sources[i]);
+
+        for (int level = 0; level <= 2; level++) {
+            TEST_ASSERT_EQUAL_INT_MESSAGE(
+                expected, native(sources[i], level), sources[i]);
+        }
+    }
+#else
+    TEST_IGNORE_MESSAGE("native code needs x86-64 linux");
+#endif
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_interpreter_evaluates_arithmetic);
+    RUN_TEST(test_interpreter_calls_functions);
+    RUN_TEST(test_interpreter_reports_traps);
+    RUN_TEST(test_interpreter_runs_loops_through_memory_and_phis);
+    RUN_TEST(test_interpreter_matches_native_code);
+    return UNITY_END();
+}
@@ -0,0 +1,69 @@
+#include <string.h>
+#include "unity.h"
+#include "constant_folding.h"
+#include "interprocedural.h"
+#include "stb_ds.h"
+#include "test_program.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static test_program ipa_source(const char *source, int *replaced) {
+    test_program fixture = test_program_parse(source);
+    *replaced = c_ipa_propagate_program(fixture.program);
+    c_fold_program(
+        fixture.program, fixture.error_context, TEST_PROGRAM_FILENAME);
+
+    return fixture;
+}
+
+void test_ipa_propagates_returns_past_calls(void) {
+    int replaced;
+    test_program fixture =
+        ipa_source("int setup() { int ignored = log(); return 4; }"
+                   "int twice() { int s = setup(); return s * 2; }"
+                   "int main() { return twice() + setup(); }",
+                   &replaced);
+    c_ast_block *body = test_program_main(fixture);
+
+    // NOTE: both calls in main and the one in twice
+    TEST_ASSERT_EQUAL(3, replaced);
+    TEST_ASSERT_EQUAL(3, arrlen(body->statements));
+
+    c_ast_statement *first = body->statements[0];
+    TEST_ASSERT_EQUAL(C_STATEMENT_EXPRESSION, first->type);
+    TEST_ASSERT_EQUAL_STRING("twice",
+                             first->expression->function_call->function_name);
+
+    c_ast_statement *last = body->statements[2];
+    TEST_ASSERT_EQUAL(C_STATEMENT_RETURN, last->type);
+    TEST_ASSERT_EQUAL(C_CONSTANT, last->return_statement->value->type);
+    TEST_ASSERT_EQUAL(12, last->return_statement->value->constant->value);
+
+    test_program_free(fixture);
+}
+
+void test_ipa_keeps_varying_returns(void) {
+    int replaced;
+    test_program fixture =
+        ipa_source("int outside() { return log(); }"
+                   "int loop() { return loop() + 1; }"
+                   "int trap() { int zero = 0; return 1 / zero; }"
+                   "int main() { return outside() + loop() + trap(); }",
+                   &replaced);
+    c_ast_block *body = test_program_main(fixture);
+
+    TEST_ASSERT_EQUAL(0, replaced);
+    TEST_ASSERT_EQUAL(1, arrlen(body->statements));
+
+    test_program_free(fixture);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_ipa_propagates_returns_past_calls);
+    RUN_TEST(test_ipa_keeps_varying_returns);
+    return UNITY_END();
+}
@@ -0,0 +1,533 @@
+#include <string.h>
+#include "unity.h"
+#include "dead_code.h"
+#include "ir.h"
+#include "range_analysis.h"
+#include "ssa.h"
+#include "stb_ds.h"
+#include "test_program.h"
+#include "value_numbering.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static c_ir_module *lower_source(const char *source) {
+    test_program fixture = test_program_parse(source);
+    c_ir_module *module = c_ir_lower_program(fixture.program);
+    test_program_free(fixture);
+
+    return module;
+}
+
+static void print_function(c_ir_function *function, char *result) {
+    char **lines = c_ir_print_function(function);
+
+    for (int i = 0; i < arrlen(lines); i++) {
+        strcat(result, lines[i]);
+        strcat(result, "\n");
+        free(lines[i]);
+    }
+
+    arrfree(lines);
+}
+
+static int count_opcode(c_ir_function *function, c_ir_opcode opcode) {
+    int count = 0;
+
+    for (int b = 0; b < arrlen(function->blocks); b++) {
+        for (int i = 0; i < arrlen(function->blocks[b].instructions); i++) {
+            int value = function->blocks[b].instructions[i];
+            count += function->instructions[value].opcode == opcode;
+        }
+    }
+
+    return count;
+}
+
+// b0: x = 1; br b1, b2
+// b1: x = 2; jmp b3
+// b2: jmp b3
+// b3: ret x
+static c_ir_function *build_diamond(void) {
+    c_ir_function *function = c_ir_function_create("diamond");
+    int entry = c_ir_function_add_block(function);
+    int then_block = c_ir_function_add_block(function);
+    int else_block = c_ir_function_add_block(function);
+    int join_block = c_ir_function_add_block(function);
+
+    c_ir_instruction alloca_instruction =
+        c_ir_make(C_IR_ALLOCA, C_IR_NO_VALUE, C_IR_NO_VALUE);
+    int x = c_ir_function_append(function, entry, alloca_instruction);
+    int one = c_ir_function_append(function, entry, c_ir_make_constant(1));
+    c_ir_function_append(function, entry, c_ir_make(C_IR_STORE, x, one));
+    c_ir_function_append(
+        function, entry, c_ir_make_branch(one, then_block, else_block));
+
+    int two = c_ir_function_append(function, then_block, c_ir_make_constant(2));
+    c_ir_function_append(function, then_block, c_ir_make(C_IR_STORE, x, two));
+    c_ir_function_append(function, then_block, c_ir_make_jump(join_block));
+
+    c_ir_function_append(function, else_block, c_ir_make_jump(join_block));
+
+    int loaded = c_ir_function_append(
+        function, join_block, c_ir_make(C_IR_LOAD, x, C_IR_NO_VALUE));
+    c_ir_function_append(
+        function, join_block, c_ir_make(C_IR_RETURN, loaded, C_IR_NO_VALUE));
+
+    c_ir_function_compute_cfg(function);
+
+    return function;
+}
+
+void test_ir_lower_locals_through_memory(void) {
+    char result[4096] = {0};
+    c_ir_module *module = lower_source(
+        "int main() {"
+        "   int x = 2;"
+        "   return x + 3;"
+        "}");
+
+    print_function(module->functions[0], result);
+
+    const char expected[] =
+        "main:\n"
+        ".L0:\n"
+        "    %0 = alloca x\n"
+        "    %1 = const 2\n"
+        "    store %0, %1\n"
+        "    %3 = load %0\n"
+        "    %4 = const 3\n"
+        "    %5 = add %3, %4\n"
+        "    ret %5\n";
+
+    TEST_ASSERT_EQUAL_STRING(expected, result);
+
+    c_ir_module_free(module);
+}
+
+void test_ir_lower_scopes_shadow_locals(void) {
+    c_ir_module *module = lower_source(
+        "int main() {"
+        "   int x = 1;"
+        "   { int x = 2; }"
+        "   return x;"
+        "}");
+    c_ir_function *function = module->functions[0];
+
+    int ret = c_ir_block_terminator(function, 0);
+    int loaded = function->instructions[ret].operands[0];
+
+    TEST_ASSERT_EQUAL(C_IR_LOAD, function->instructions[loaded].opcode);
+    TEST_ASSERT_EQUAL_STRING(
+        "x",
+        function->instructions[function->instructions[loaded].operands[0]]
+            .variable_name);
+    TEST_ASSERT_EQUAL(0, function->instructions[loaded].operands[0]);
+
+    c_ir_module_free(module);
+}
+
+void test_ir_lower_heavier_operand_first(void) {
+    char result[4096] = {0};
+    c_ir_module *module = lower_source(
+        "int main() {"
+        "   int a = 1;"
+        "   return a - f() * f();"
+        "}"
+        "int g() {"
+        "   int a = 1;"
+        "   return a + f() * f();"
+        "}");
+
+    print_function(module->functions[0], result);
+
+    const char expected[] =
+        "main:\n"
+        ".L0:\n"
+        "    %0 = alloca a\n"
+        "    %1 = const 1\n"
+        "    store %0, %1\n"
+        "    %3 = call f\n"
+        "    %4 = call f\n"
+        "    %5 = mul %3, %4\n"
+        "    %6 = load %0\n"
+        "    %7 = sub %6, %5\n"
+        "    ret %7\n";
+
+    TEST_ASSERT_EQUAL_STRING(expected, result);
+
+    c_ir_function *g = module->functions[1];
+    int sum = g->instructions[c_ir_block_terminator(g, 0)].operands[0];
+
+    TEST_ASSERT_EQUAL(C_IR_ADD, g->instructions[sum].opcode);
+    TEST_ASSERT_EQUAL(C_IR_MULTIPLY,
+                      g->instructions[g->instructions[sum].operands[0]].opcode);
+
+    c_ir_module_free(module);
+}
+
+void test_ssa_dominators_of_diamond(void) {
+    c_ir_function *function = build_diamond();
+
+    c_ssa_compute_dominators(function);
+    c_ssa_compute_dominance_frontiers(function);
+
+    TEST_ASSERT_EQUAL(-1, function->blocks[0].immediate_dominator);
+    TEST_ASSERT_EQUAL(0, function->blocks[1].immediate_dominator);
+    TEST_ASSERT_EQUAL(0, function->blocks[2].immediate_dominator);
+    TEST_ASSERT_EQUAL(0, function->blocks[3].immediate_dominator);
+
+    TEST_ASSERT_EQUAL(1, arrlen(function->blocks[1].dominance_frontier));
+    TEST_ASSERT_EQUAL(3, function->blocks[1].dominance_frontier[0]);
+    TEST_ASSERT_EQUAL(0, arrlen(function->blocks[0].dominance_frontier));
+
+    TEST_ASSERT_TRUE(c_ssa_dominates(function, 0, 3));
+    TEST_ASSERT_FALSE(c_ssa_dominates(function, 1, 3));
+
+    c_ir_function_free(function);
+}
+
+void test_ssa_promote_places_phi_at_join(void) {
+    c_ir_function *function = build_diamond();
+
+    TEST_ASSERT_EQUAL(1, c_ssa_promote_allocas(function));
+
+    TEST_ASSERT_EQUAL(0, count_opcode(function, C_IR_ALLOCA));
+    TEST_ASSERT_EQUAL(0, count_opcode(function, C_IR_LOAD));
+    TEST_ASSERT_EQUAL(0, count_opcode(function, C_IR_STORE));
+    TEST_ASSERT_EQUAL(1, count_opcode(function, C_IR_PHI));
+
+    int phi = function->blocks[3].instructions[0];
+    c_ir_instruction *instruction = &function->instructions[phi];
+
+    TEST_ASSERT_EQUAL(C_IR_PHI, instruction->opcode);
+    TEST_ASSERT_EQUAL(2, arrlen(instruction->phi_operands));
+
+    int ret = c_ir_block_terminator(function, 3);
+    TEST_ASSERT_EQUAL(phi, function->instructions[ret].operands[0]);
+
+    for (int p = 0; p < 2; p++) {
+        c_ir_phi_operand operand = instruction->phi_operands[p];
+        int constant = function->instructions[operand.value].constant;
+        TEST_ASSERT_EQUAL(operand.block == 1 ? 2 : 1, constant);
+    }
+
+    c_ir_function_free(function);
+}
+
+void test_ssa_promote_straight_line_code(void) {
+    char result[4096] = {0};
+    c_ir_module *module = lower_source(
+        "int main() {"
+        "   int x = 2;"
+        "   int y = x * 3;"
+        "   return y + x;"
+        "}");
+
+    TEST_ASSERT_EQUAL(2, c_ssa_promote_allocas(module->functions[0]));
+
+    print_function(module->functions[0], result);
+
+    const char expected[] =
+        "main:\n"
+        ".L0:\n"
+        "    %1 = const 2\n"
+        "    %5 = const 3\n"
+        "    %6 = mul %1, %5\n"
+        "    %10 = add %6, %1\n"
+        "    ret %10\n";
+
+    TEST_ASSERT_EQUAL_STRING(expected, result);
+
+    c_ir_module_free(module);
+}
+
+void test_ir_lower_drops_code_after_return(void) {
+    c_ir_module *module = lower_source(
+        "int main() {"
+        "   int x = 1;"
+        "   { return x; int y = f(); }"
+        "   return 2;"
+        "}");
+    c_ir_function *function = module->functions[0];
+
+    TEST_ASSERT_EQUAL(1, count_opcode(function, C_IR_ALLOCA));
+    TEST_ASSERT_EQUAL(0, count_opcode(function, C_IR_CALL));
+    TEST_ASSERT_EQUAL(1, count_opcode(function, C_IR_RETURN));
+
+    for (int b = 1; b < arrlen(function->blocks); b++) {
+        TEST_ASSERT_EQUAL(0, arrlen(function->blocks[b].instructions));
+        TEST_ASSERT_EQUAL(0, arrlen(function->blocks[b].predecessors));
+    }
+
+    c_ir_module_free(module);
+}
+
+void test_ir_lower_nested_functions_separately(void) {
+    c_ir_module *module = lower_source(
+        "int main() {"
+        "   int x = 1;"
+        "   int g() { int y = 2; return y; }"
+        "   return x + g();"
+        "}");
+
+    TEST_ASSERT_EQUAL(2, arrlen(module->functions));
+    TEST_ASSERT_EQUAL_STRING("main", module->functions[0]->name);
+    TEST_ASSERT_EQUAL_STRING("g", module->functions[1]->name);
+    TEST_ASSERT_EQUAL(1, count_opcode(module->functions[0], C_IR_ALLOCA));
+    TEST_ASSERT_EQUAL(1, count_opcode(module->functions[0], C_IR_CALL));
+    TEST_ASSERT_EQUAL(1, count_opcode(module->functions[1], C_IR_ALLOCA));
+    TEST_ASSERT_EQUAL(1, count_opcode(module->functions[1], C_IR_RETURN));
+
+    c_ir_module_free(module);
+}
+
+void test_ir_module_removes_dead_functions(void) {
+    const char *source = "int a() { return b(); }"
+                         "int b() { return 1; }"
+                         "int dead() { return a(); }"
+                         "int main() { return a(); }";
+    c_ir_module *module = lower_source(source);
+
+    TEST_ASSERT_EQUAL(1, c_ir_module_remove_dead_functions(module, "main"));
+    TEST_ASSERT_EQUAL(3, arrlen(module->functions));
+    TEST_ASSERT_EQUAL(-1, c_ir_module_find_function(module, "dead"));
+    TEST_ASSERT_EQUAL_STRING("main", module->functions[2]->name);
+
+    c_ir_module_free(module);
+
+    module = lower_source(source);
+    TEST_ASSERT_EQUAL(0, c_ir_module_remove_dead_functions(module, "start"));
+    TEST_ASSERT_EQUAL(4, arrlen(module->functions));
+
+    c_ir_module_free(module);
+}
+
+void test_value_numbering_reuses_commutative_expressions(void) {
+    c_ir_module *module = lower_source(
+        "int main() {"
+        "   int a = f(); int b = g();"
+        "   int x = a * b + b * a;"
+        "   int y = a * b + 3;"
+        "   return x - y + 3 + a * b;"
+        "}");
+    c_ir_function *function = module->functions[0];
+
+    c_ssa_promote_allocas(function);
+
+    TEST_ASSERT_EQUAL(4, count_opcode(function, C_IR_MULTIPLY));
+    TEST_ASSERT_EQUAL(3, c_value_number_function(function));
+    TEST_ASSERT_EQUAL(1, count_opcode(function, C_IR_MULTIPLY));
+
+    // NOTE: a * b + b * a is now a sum of one value with itself
+    for (int v = 0; v < arrlen(function->instructions); v++) {
+        c_ir_instruction *instruction = &function->instructions[v];
+
+        if (instruction->opcode == C_IR_ADD
+            && function->instructions[instruction->operands[0]].opcode
+                   == C_IR_MULTIPLY
+            && function->instructions[instruction->operands[1]].opcode
+                   == C_IR_MULTIPLY) {
+            TEST_ASSERT_EQUAL(instruction->operands[0],
+                              instruction->operands[1]);
+        }
+    }
+
+    c_ir_module_free(module);
+}
+
+void test_value_numbering_keeps_order_and_calls(void) {
+    c_ir_module *module = lower_source(
+        "int main() {"
+        "   int a = f();"
+        "   int x = a - 2; int y = 2 - a; int z = a - 2;"
+        "   return x + y + z + f() + f();"
+        "}");
+    c_ir_function *function = module->functions[0];
+
+    c_ssa_promote_allocas(function);
+
+    TEST_ASSERT_EQUAL(1, c_value_number_function(function));
+    TEST_ASSERT_EQUAL(2, count_opcode(function, C_IR_SUBTRACT));
+    TEST_ASSERT_EQUAL(3, count_opcode(function, C_IR_CALL));
+
+    c_ir_module_free(module);
+}
+
+// b0: a = call f; br a, b1, b2
+// b1: a * a; jmp b3
+// b2: a * a; jmp b3
+// b3: ret a * a + a * a
+void test_value_numbering_follows_dominators(void) {
+    c_ir_function *function = c_ir_function_create("square");
+    int entry = c_ir_function_add_block(function);
+    int then_block = c_ir_function_add_block(function);
+    int else_block = c_ir_function_add_block(function);
+    int join_block = c_ir_function_add_block(function);
+
+    int a = c_ir_function_append(function, entry, c_ir_make_call("f"));
+    c_ir_function_append(
+        function, entry, c_ir_make_branch(a, then_block, else_block));
+
+    int arms[] = {then_block, else_block};
+    for (int i = 0; i < 2; i++) {
+        c_ir_function_append(
+            function, arms[i], c_ir_make(C_IR_MULTIPLY, a, a));
+        c_ir_function_append(function, arms[i], c_ir_make_jump(join_block));
+    }
+
+    int first = c_ir_function_append(
+        function, join_block, c_ir_make(C_IR_MULTIPLY, a, a));
+    int second = c_ir_function_append(
+        function, join_block, c_ir_make(C_IR_MULTIPLY, a, a));
+    int sum = c_ir_function_append(
+        function, join_block, c_ir_make(C_IR_ADD, first, second));
+    c_ir_function_append(
+        function, join_block, c_ir_make(C_IR_RETURN, sum, C_IR_NO_VALUE));
+
+    c_ir_function_compute_cfg(function);
+
+    TEST_ASSERT_EQUAL(1, c_value_number_function(function));
+    TEST_ASSERT_EQUAL(3, count_opcode(function, C_IR_MULTIPLY));
+    TEST_ASSERT_EQUAL(first, function->instructions[sum].operands[0]);
+    TEST_ASSERT_EQUAL(first, function->instructions[sum].operands[1]);
+
+    c_ir_function_free(function);
+}
+
+void test_dead_store_removes_unread_locals(void) {
+    c_ir_module *module = lower_source(
+        "int f() { return 1; }"
+        "int main() { int x = f(); int y = 2 * 3; int z = 4; return z; }");
+    c_ir_function *function = module->functions[1];
+
+    TEST_ASSERT_EQUAL(2, c_dead_store_eliminate(function));
+    TEST_ASSERT_EQUAL(1, count_opcode(function, C_IR_STORE));
+
+    // NOTE: the call stays, the product and the unread locals go
+    c_dead_code_eliminate(function);
+    TEST_ASSERT_EQUAL(1, count_opcode(function, C_IR_CALL));
+    TEST_ASSERT_EQUAL(0, count_opcode(function, C_IR_MULTIPLY));
+    TEST_ASSERT_EQUAL(1, count_opcode(function, C_IR_ALLOCA));
+
+    c_ir_module_free(module);
+}
+
+void test_dead_store_follows_every_path(void) {
+    c_ir_function *function = build_diamond();
+
+    // NOTE: the else path still reads the store of the entry
+    TEST_ASSERT_EQUAL(0, c_dead_store_eliminate(function));
+
+    int x = function->blocks[0].instructions[0];
+    int three = c_ir_function_insert(function, 2, 0, c_ir_make_constant(3));
+    c_ir_function_insert(function, 2, 1, c_ir_make(C_IR_STORE, x, three));
+
+    TEST_ASSERT_EQUAL(1, c_dead_store_eliminate(function));
+    TEST_ASSERT_EQUAL(2, count_opcode(function, C_IR_STORE));
+
+    for (int i = 0; i < arrlen(function->blocks[0].instructions); i++) {
+        int value = function->blocks[0].instructions[i];
+        TEST_ASSERT_NOT_EQUAL(C_IR_STORE, function->instructions[value].opcode);
+    }
+
+    c_ir_function_free(function);
+}
+
+void test_dead_code_removes_unused_chains(void) {
+    c_ir_module *module = lower_source(
+        "int main() {"
+        "   int a = f(); int b = a * 3; int c = b + a; int d = c / 2;"
+        "   return a + 1;"
+        "}");
+    c_ir_function *function = module->functions[0];
+
+    c_ssa_promote_allocas(function);
+
+    TEST_ASSERT_EQUAL(2, count_opcode(function, C_IR_ADD));
+    TEST_ASSERT_TRUE(c_dead_code_eliminate(function) > 0);
+    TEST_ASSERT_EQUAL(0, count_opcode(function, C_IR_MULTIPLY));
+    TEST_ASSERT_EQUAL(0, count_opcode(function, C_IR_DIVIDE));
+    TEST_ASSERT_EQUAL(1, count_opcode(function, C_IR_ADD));
+    TEST_ASSERT_EQUAL(1, count_opcode(function, C_IR_CALL));
+    TEST_ASSERT_EQUAL(0, c_dead_code_eliminate(function));
+
+    c_ir_module_free(module);
+}
+
+void test_range_of_binary_bounds_arithmetic(void) {
+    c_range lhs = {.min = -4, .max = 10};
+    c_range rhs = {.min = 2, .max = 3};
+
+    c_range sum = c_range_of_binary(C_IR_ADD, C_IR_TYPE_I32, lhs, rhs);
+    TEST_ASSERT_EQUAL_INT64(-2, sum.min);
+    TEST_ASSERT_EQUAL_INT64(13, sum.max);
+
+    c_range product =
+        c_range_of_binary(C_IR_MULTIPLY, C_IR_TYPE_I32, lhs, rhs);
+    TEST_ASSERT_EQUAL_INT64(-12, product.min);
+    TEST_ASSERT_EQUAL_INT64(30, product.max);
+
+    c_range quotient =
+        c_range_of_binary(C_IR_DIVIDE, C_IR_TYPE_I32, lhs, rhs);
+    TEST_ASSERT_EQUAL_INT64(-2, quotient.min);
+    TEST_ASSERT_EQUAL_INT64(5, quotient.max);
+
+    // NOTE: a product past 32 bits may wrap, so nothing is known
+    c_range large = {.min = 0, .max = INT32_MAX};
+    c_range wrapped =
+        c_range_of_binary(C_IR_MULTIPLY, C_IR_TYPE_I32, large, rhs);
+    TEST_ASSERT_EQUAL_INT64(INT32_MIN, wrapped.min);
+    TEST_ASSERT_EQUAL_INT64(INT32_MAX, wrapped.max);
+}
+
+void test_range_simplify_folds_single_values(void) {
+    c_ir_module *module = lower_source(
+        "int main() {"
+        "   int a = 7; int b = a * 3; int z = 0;"
+        "   return b / 2 + f() / z;"
+        "}");
+    c_ir_function *function = module->functions[0];
+
+    c_ssa_promote_allocas(function);
+
+    TEST_ASSERT_EQUAL(2, c_range_simplify_function(function));
+    TEST_ASSERT_EQUAL(0, count_opcode(function, C_IR_MULTIPLY));
+    TEST_ASSERT_EQUAL(1, count_opcode(function, C_IR_DIVIDE));
+    TEST_ASSERT_EQUAL(1, count_opcode(function, C_IR_ADD));
+
+    c_range *ranges = c_range_analyze(function);
+
+    for (int v = 0; v < arrlen(function->instructions); v++) {
+        if (function->instructions[v].opcode == C_IR_CALL) {
+            TEST_ASSERT_FALSE(c_range_is_non_negative(ranges[v]));
+        }
+    }
+
+    arrfree(ranges);
+    c_ir_module_free(module);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_ir_lower_locals_through_memory);
+    RUN_TEST(test_ir_lower_scopes_shadow_locals);
+    RUN_TEST(test_ir_lower_heavier_operand_first);
+    RUN_TEST(test_ir_lower_drops_code_after_return);
+    RUN_TEST(test_ir_lower_nested_functions_separately);
+    RUN_TEST(test_ir_module_removes_dead_functions);
+    RUN_TEST(test_ssa_dominators_of_diamond);
+    RUN_TEST(test_ssa_promote_places_phi_at_join);
+    RUN_TEST(test_ssa_promote_straight_line_code);
+    RUN_TEST(test_value_numbering_reuses_commutative_expressions);
+    RUN_TEST(test_value_numbering_keeps_order_and_calls);
+    RUN_TEST(test_value_numbering_follows_dominators);
+    RUN_TEST(test_dead_store_removes_unread_locals);
+    RUN_TEST(test_dead_store_follows_every_path);
+    RUN_TEST(test_dead_code_removes_unused_chains);
+    RUN_TEST(test_range_of_binary_bounds_arithmetic);
+    RUN_TEST(test_range_simplify_folds_single_values);
+    return UNITY_END();
+}
@@ -0,0 +1,86 @@
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "assembler.h"
+#include "jit.h"
+#include "stb_ds.h"
+#include "str.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static int run(const char **input) {
+    char **lines = NULL;
+
+    for (int i = 0; input[i]; i++) {
+        arrput(lines, strdup(input[i]));
+    }
+
+    c_asm_object *object = c_asm_assemble(lines);
+    int result = c_jit_run(object, C_JIT_ENTRY);
+
+    for (int i = 0; i < arrlen(lines); i++) {
+        free(lines[i]);
+    }
+    arrfree(lines);
+    c_asm_object_free(object);
+
+    return result;
+}
+
+void test_jit_returns_main_result(void) {
+#if defined(__x86_64__) && defined(__linux__)
+    const char *input[] = {
+        "main:",
+        "    mov eax, 42",
+        "    ret",
+        NULL,
+    };
+
+    TEST_ASSERT_EQUAL_INT(42, run(input));
+#else
+    TEST_IGNORE_MESSAGE("jit needs x86-64 linux");
+#endif
+}
+
+void test_jit_calls_between_functions(void) {
+#if defined(__x86_64__) && defined(__linux__)
+    const char *input[] = {
+        "global _start",
+        "section .text",
+        "_start:",
+        "    call main",
+        "    mov edi, eax",
+        "    mov eax, 60",
+        "    syscall",
+        "",
+        "seven:",
+        "    mov eax, 7",
+        "    ret",
+        "",
+        "main:",
+        "    push rbx",
+        "    call seven",
+        "    mov ebx, eax",
+        "    call seven",
+        "    imul eax, ebx",
+        "    neg eax",
+        "    pop rbx",
+        "    ret",
+        NULL,
+    };
+
+    TEST_ASSERT_EQUAL_INT(-49, run(input));
+#else
+    TEST_IGNORE_MESSAGE("jit needs x86-64 linux");
+#endif
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_jit_returns_main_result);
+    RUN_TEST(test_jit_calls_between_functions);
+    return UNITY_END();
+}
@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "unity.h"
+#include "assembler.h"
+#include "elf64.h"
+#include "linker.h"
+#include "stb_ds.h"
+#include "str.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static uint64_t read64(uint8_t *bytes, int offset) {
+    uint64_t value = 0;
+
+    for (int i = 7; i >= 0; i--) {
+        value = value << 8 | bytes[offset + i];
+    }
+
+    return value;
+}
+
+static c_asm_object *assemble(const char **input) {
+    char **lines = NULL;
+
+    for (int i = 0; input[i]; i++) {
+        arrput(lines, strdup(input[i]));
+    }
+
+    c_asm_object *object = c_asm_assemble(lines);
+
+    for (int i = 0; i < arrlen(lines); i++) {
+        free(lines[i]);
+    }
+    arrfree(lines);
+
+    return object;
+}
+
+void test_linker_writes_static_executable(void) {
+    const char *input[] = {
+        "global _start",
+        "section .text",
+        "_start:",
+        "    mov edi, 42",
+        "    mov eax, 60",
+        "    syscall",
+        NULL,
+    };
+    c_asm_object *object = assemble(input);
+    uint8_t *bytes = c_link_executable(object);
+    uint64_t text_offset = c_elf64_executable_text_offset();
+
+    TEST_ASSERT_EQUAL_MEMORY("\x7f" "ELF", bytes, 4);
+    TEST_ASSERT_EQUAL_INT(C_ELF64_ET_EXEC, bytes[16]);
+    TEST_ASSERT_EQUAL_UINT64(C_LINK_BASE_ADDRESS + text_offset, read64(bytes, 24));
+    // NOTE: e_phoff and e_phnum
+    TEST_ASSERT_EQUAL_UINT64(C_ELF64_HEADER_SIZE, read64(bytes, 32));
+    TEST_ASSERT_EQUAL_INT(1, bytes[56]);
+    TEST_ASSERT_EQUAL_INT(text_offset + arrlen(object->text), arrlen(bytes));
+    TEST_ASSERT_EQUAL_MEMORY(
+        object->text, bytes + text_offset, arrlen(object->text));
+
+#if defined(__x86_64__) && defined(__linux__)
+    FILE *file = fopen("linker_test_exit", "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    fwrite(bytes, 1, arrlen(bytes), file);
+    fclose(file);
+    chmod("linker_test_exit", 0755);
+
+    int status = system("./linker_test_exit");
+    remove("linker_test_exit");
+
+    TEST_ASSERT_TRUE(WIFEXITED(status));
+    TEST_ASSERT_EQUAL_INT(42, WEXITSTATUS(status));
+#endif
+
+    arrfree(bytes);
+    c_asm_object_free(object);
+}
+
+void test_linker_applies_relocations(void) {
+    static const uint8_t text[] = {
+        0xe8, 0, 0, 0, 0, 0x90, 0x90, 0x90, 0xc3,
+    };
+    c_asm_object object = {0};
+
+    for (size_t i = 0; i < sizeof(text); i++) {
+        arrput(object.text, text[i]);
+    }
+
+    c_asm_symbol start = {
+        .name = strdup("_start"), .offset = 0, .is_defined = 1, .is_global = 1};
+    c_asm_symbol g = {
+        .name = strdup("g"), .offset = 8, .is_defined = 1, .is_global = 1};
+    c_asm_relocation relocation = {.offset = 1, .symbol = 1, .addend = -4};
+
+    arrput(object.symbols, start);
+    arrput(object.symbols, g);
+    arrput(object.relocations, relocation);
+
+    uint8_t *bytes = c_link_executable(&object);
+    uint8_t *call = bytes + c_elf64_executable_text_offset();
+
+    // NOTE: g - (call + 5) == 3
+    TEST_ASSERT_EQUAL_HEX8(0xe8, call[0]);
+    TEST_ASSERT_EQUAL_HEX8(3, call[1]);
+    TEST_ASSERT_EQUAL_HEX8(0, call[2]);
+
+    arrfree(bytes);
+    free(start.name);
+    free(g.name);
+    arrfree(object.text);
+    arrfree(object.symbols);
+    arrfree(object.relocations);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_linker_writes_static_executable);
+    RUN_TEST(test_linker_applies_relocations);
+    return UNITY_END();
+}
@@ -0,0 +1,128 @@
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "machine_ir.h"
+#include "stb_ds.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static void print(c_mir_function *function, char *result) {
+    char **lines = NULL;
+
+    c_mir_print_function(function, &lines);
+
+    for (int i = 0; i < arrlen(lines); i++) {
+        strcat(result, lines[i]);
+        strcat(result, "\n");
+        free(lines[i]);
+    }
+
+    arrfree(lines);
+}
+
+void test_mir_prints_operands(void) {
+    c_mir_function *function = c_mir_function_create("f");
+    char buffer[C_MIR_MAX_OPERAND_LENGTH];
+
+    TEST_ASSERT_EQUAL_STRING(
+        "ecx", c_mir_print_operand(function, c_mir_register(C_X86_RCX, 4),
+                                   buffer));
+    TEST_ASSERT_EQUAL_STRING(
+        "r11", c_mir_print_operand(function, c_mir_register(C_X86_R11, 8),
+                                   buffer));
+    TEST_ASSERT_EQUAL_STRING(
+        "-7", c_mir_print_operand(function, c_mir_immediate(-7), buffer));
+    TEST_ASSERT_EQUAL_STRING(
+        "dword [rbp-4]",
+        c_mir_print_operand(
+            function,
+            c_mir_memory(C_X86_RBP, C_X86_NO_REGISTER, 1, -4, 4),
+            buffer));
+    TEST_ASSERT_EQUAL_STRING(
+        "qword [rsp]",
+        c_mir_print_operand(
+            function,
+            c_mir_memory(C_X86_RSP, C_X86_NO_REGISTER, 1, 0, 8),
+            buffer));
+    TEST_ASSERT_EQUAL_STRING(
+        "[rbx+rcx*4+5]",
+        c_mir_print_operand(
+            function, c_mir_memory(C_X86_RBX, C_X86_RCX, 4, 5, 0), buffer));
+    TEST_ASSERT_EQUAL_STRING(
+        "[r9*8-3]",
+        c_mir_print_operand(
+            function,
+            c_mir_memory(C_X86_NO_REGISTER, C_X86_R9, 8, -3, 0),
+            buffer));
+    TEST_ASSERT_EQUAL_STRING(
+        "f",
+        c_mir_print_operand(function, c_mir_label_operand(0), buffer));
+
+    c_mir_function_free(function);
+}
+
+void test_mir_labels_are_shared(void) {
+    c_mir_function *function = c_mir_function_create("main");
+
+    int block = c_mir_label(function, ".L%d", 3);
+    TEST_ASSERT_EQUAL(block, c_mir_label(function, ".L3"));
+    TEST_ASSERT_EQUAL(0, c_mir_label(function, "main"));
+    TEST_ASSERT_NOT_EQUAL(block, c_mir_label(function, ".L3_else"));
+    TEST_ASSERT_EQUAL(3, arrlen(function->labels));
+
+    TEST_ASSERT_TRUE(c_mir_operand_equal(c_mir_register(C_X86_RAX, 8),
+                                         c_mir_register(C_X86_RAX, 8)));
+    TEST_ASSERT_FALSE(c_mir_operand_equal(c_mir_register(C_X86_RAX, 8),
+                                          c_mir_register(C_X86_RAX, 4)));
+    TEST_ASSERT_FALSE(c_mir_operand_equal(
+        c_mir_memory(C_X86_RBP, C_X86_NO_REGISTER, 1, -4, 4),
+        c_mir_memory(C_X86_RBP, C_X86_NO_REGISTER, 1, -8, 4)));
+
+    c_mir_function_free(function);
+}
+
+void test_mir_prints_blocks(void) {
+    char result[1024] = {0};
+    c_mir_function *function = c_mir_function_create("main");
+    c_mir_operand eax = c_mir_register(C_X86_RAX, 4);
+    c_mir_operand rbp = c_mir_register(C_X86_RBP, 8);
+    int label = c_mir_label(function, ".L1");
+
+    c_mir_append(function, c_mir_make1(C_MIR_PUSH, rbp));
+    c_mir_append(function,
+                 c_mir_make1(C_MIR_JMP, c_mir_label_operand(label)));
+    c_mir_begin_block(function, label);
+    c_mir_append(function,
+                 c_mir_make3(C_MIR_IMUL, eax, eax, c_mir_immediate(10)));
+    c_mir_append(function, c_mir_make0(C_MIR_CDQ));
+    c_mir_begin_block(function, C_MIR_NO_LABEL);
+    c_mir_append(function, c_mir_make1(C_MIR_POP, rbp));
+    c_mir_append(function, c_mir_make0(C_MIR_RET));
+
+    print(function, result);
+
+    TEST_ASSERT_EQUAL_STRING("main:\n"
+                             "    push rbp\n"
+                             "    jmp .L1\n"
+                             ".L1:\n"
+                             "    imul eax, eax, 10\n"
+                             "    cdq\n"
+                             "\n"
+                             "    pop rbp\n"
+                             "    ret\n"
+                             "\n",
+                             result);
+
+    c_mir_function_free(function);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_mir_prints_operands);
+    RUN_TEST(test_mir_labels_are_shared);
+    RUN_TEST(test_mir_prints_blocks);
+    return UNITY_END();
+}
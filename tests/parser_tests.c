@@ -41,11 +41,56 @@ void test_parse_function_declaration(void) {
     c_ast_free_function_declaration(func);
     c_parser_free(parser);
     c_lexer_free(lexer);
+    c_error_context_free(error_context);
+}
+
+// NOTE: only the second declaration of g is reported, at line
+static void assert_redefinition(const char *source, int line) {
+    c_error_context *error_context = c_error_context_create();
+    c_lexer *lexer = c_lexer_create(source);
+    c_token *tokens = c_lexer_lex(lexer);
+    c_lexer_free(lexer);
+    c_parser *parser =
+        c_parser_create(tokens, error_context, "test_filename.c");
+    c_ast_program *program = c_parser_parse(parser);
+
+    TEST_ASSERT_EQUAL_MESSAGE(1, arrlen(error_context->errors), source);
+    TEST_ASSERT_EQUAL_STRING("Redefinition of function 'g'",
+                             error_context->errors[0].message);
+    TEST_ASSERT_EQUAL(line, error_context->errors[0].line);
+
+    c_parser_free_program(program);
+    c_parser_free(parser);
+    c_error_context_free(error_context);
+}
+
+void test_parse_rejects_redefined_function(void) {
+    assert_redefinition("int g() { return 1; }\n"
+                        "int g() { return 2; }\n"
+                        "int main() { return g(); }",
+                        2);
+}
+
+void test_parse_rejects_shadowing_nested_function(void) {
+    assert_redefinition("int g() { return 1; }\n"
+                        "int main() {\n"
+                        "   int g() { return 2; }\n"
+                        "   return g();\n"
+                        "}",
+                        3);
+    assert_redefinition("int main() {\n"
+                        "   int g() { return 2; }\n"
+                        "   return g();\n"
+                        "}\n"
+                        "int f() { int g() { return 3; } return g(); }",
+                        5);
 }
 
 int main(void) {
     UNITY_BEGIN();
 
     RUN_TEST(test_parse_function_declaration);
+    RUN_TEST(test_parse_rejects_redefined_function);
+    RUN_TEST(test_parse_rejects_shadowing_nested_function);
     return UNITY_END();
 }
@@ -0,0 +1,100 @@
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "code_generator.h"
+#include "machine_ir.h"
+#include "peephole.h"
+#include "stb_ds.h"
+#include "test_program.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static int rule_index(const char *name) {
+    for (int i = 0; i < c_peephole_rules_count(); i++) {
+        if (strcmp(c_peephole_rule_at(i)->name, name) == 0) {
+            return i;
+        }
+    }
+
+    TEST_FAIL_MESSAGE("Unknown peephole rule");
+    return -1;
+}
+
+// NOTE: selects source at -O1 and prints main, the last function
+static void compile(const char *source, int *fires, char *result) {
+    test_program fixture = test_program_parse(source);
+    c_code_gen_options options = c_code_gen_options_for_level(1);
+    options.peephole_fires = fires;
+    c_mir_module *module = c_code_gen_select_program(fixture.program, options);
+    char **lines = NULL;
+
+    c_mir_print_function(module->functions[arrlen(module->functions) - 1],
+                         &lines);
+
+    for (int i = 0; i < arrlen(lines); i++) {
+        strcat(result, lines[i]);
+        strcat(result, "\n");
+        free(lines[i]);
+    }
+
+    arrfree(lines);
+    c_mir_module_free(module);
+    test_program_free(fixture);
+}
+
+void test_peephole_zero_idiom(void) {
+    char result[1024] = {0};
+    int *fires = calloc(c_peephole_rules_count(), sizeof(int));
+
+    compile("int main() { return 0; }", fires, result);
+
+    TEST_ASSERT_EQUAL_STRING("main:\n"
+                             "    push rbp\n"
+                             "    mov rbp, rsp\n"
+                             "    xor eax, eax\n"
+                             "\n"
+                             "    pop rbp\n"
+                             "    ret\n"
+                             "\n",
+                             result);
+    TEST_ASSERT_EQUAL(1, fires[rule_index("zero-idiom")]);
+
+    free(fires);
+}
+
+// NOTE: x + z with z = 0 is selected as a copy back into eax and an
+// add of zero, the local keeps the call result in ecx
+void test_peephole_move_back_and_add_zero(void) {
+    char result[1024] = {0};
+    int *fires = calloc(c_peephole_rules_count(), sizeof(int));
+
+    compile("int n() { return 5; }\n"
+            "int main() { int x = n(); int z = 0; return x + z; }",
+            fires,
+            result);
+
+    TEST_ASSERT_EQUAL_STRING("main:\n"
+                             "    push rbp\n"
+                             "    mov rbp, rsp\n"
+                             "    call n\n"
+                             "    mov ecx, eax\n"
+                             "\n"
+                             "    pop rbp\n"
+                             "    ret\n"
+                             "\n",
+                             result);
+    TEST_ASSERT_EQUAL(1, fires[rule_index("move-back")]);
+    TEST_ASSERT_EQUAL(1, fires[rule_index("add-zero")]);
+
+    free(fires);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_peephole_zero_idiom);
+    RUN_TEST(test_peephole_move_back_and_add_zero);
+    return UNITY_END();
+}
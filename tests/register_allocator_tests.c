@@ -0,0 +1,92 @@
+#include <string.h>
+#include "unity.h"
+#include "ir.h"
+#include "register_allocator.h"
+#include "ssa.h"
+#include "stb_ds.h"
+#include "test_program.h"
+#include "x86.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static c_ir_module *lower_promoted(const char *source) {
+    test_program fixture = test_program_parse(source);
+    c_ir_module *module = c_ir_lower_program(fixture.program);
+    test_program_free(fixture);
+
+    for (int i = 0; i < arrlen(module->functions); i++) {
+        c_ssa_promote_allocas(module->functions[i]);
+    }
+
+    return module;
+}
+
+void test_register_overlapping_intervals_get_different_registers(void) {
+    c_ir_module *module = lower_promoted(
+        "int main() {"
+        "   int a = f();"
+        "   int b = a * 2;"
+        "   int c = a + b;"
+        "   int d = c - b;"
+        "   return a + b + c + d;"
+        "}");
+
+    c_register_allocation *allocation =
+        c_register_allocate(module->functions[0]);
+    c_live_interval *intervals = allocation->intervals;
+
+    TEST_ASSERT_EQUAL(0, allocation->spilled_count);
+    TEST_ASSERT_EQUAL(0, arrlen(allocation->saved_registers));
+
+    for (int i = 0; i < arrlen(intervals); i++) {
+        TEST_ASSERT_NOT_EQUAL(C_X86_NO_REGISTER, intervals[i].reg);
+
+        for (int j = i + 1; j < arrlen(intervals); j++) {
+            int disjoint = intervals[i].end <= intervals[j].start
+                           || intervals[j].end <= intervals[i].start;
+
+            if (!disjoint) {
+                TEST_ASSERT_NOT_EQUAL(intervals[i].reg, intervals[j].reg);
+            }
+        }
+    }
+
+    c_register_allocation_free(allocation);
+    c_ir_module_free(module);
+}
+
+void test_register_values_across_calls_spill_past_callee_saved(void) {
+    c_ir_module *module = lower_promoted(
+        "int main() {"
+        "   int a = f(); int b = f(); int c = f(); int d = f();"
+        "   int e = f(); int g = f(); int h = f(); int i = f();"
+        "   return a + b + c + d + e + g + h + i;"
+        "}");
+
+    c_register_allocation *allocation =
+        c_register_allocate(module->functions[0]);
+    c_live_interval *intervals = allocation->intervals;
+
+    for (int i = 0; i < arrlen(intervals); i++) {
+        if (intervals[i].crosses_call
+            && intervals[i].reg != C_X86_NO_REGISTER) {
+            TEST_ASSERT_TRUE(c_x86_is_callee_saved(intervals[i].reg));
+        }
+    }
+
+    TEST_ASSERT_EQUAL(5, arrlen(allocation->saved_registers));
+    TEST_ASSERT_EQUAL(2, allocation->spilled_count);
+
+    c_register_allocation_free(allocation);
+    c_ir_module_free(module);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_register_overlapping_intervals_get_different_registers);
+    RUN_TEST(test_register_values_across_calls_spill_past_callee_saved);
+    return UNITY_END();
+}
@@ -0,0 +1,116 @@
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "machine_ir.h"
+#include "scheduler.h"
+#include "stb_ds.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static void print(c_mir_function *function, char *result) {
+    char **lines = NULL;
+
+    c_mir_print_function(function, &lines);
+
+    for (int i = 0; i < arrlen(lines); i++) {
+        strcat(result, lines[i]);
+        strcat(result, "\n");
+        free(lines[i]);
+    }
+
+    arrfree(lines);
+}
+
+static c_mir_operand reg(c_x86_register reg) {
+    return c_mir_register(reg, 4);
+}
+
+static c_mir_operand slot(int displacement) {
+    return c_mir_memory(C_X86_RBP, C_X86_NO_REGISTER, 1, displacement, 4);
+}
+
+static void emit2(c_mir_function *function,
+                  c_mir_opcode opcode,
+                  c_mir_operand destination,
+                  c_mir_operand source) {
+    c_mir_append(function, c_mir_make2(opcode, destination, source));
+}
+
+static int position(const char *result, const char *line) {
+    const char *found = strstr(result, line);
+
+    TEST_ASSERT_NOT_NULL_MESSAGE(found, line);
+    return (int)(found - result);
+}
+
+void test_schedule_models_by_name(void) {
+    TEST_ASSERT_NOT_NULL(c_schedule_model_for("generic"));
+    TEST_ASSERT_NOT_NULL(c_schedule_model_for("skylake"));
+    TEST_ASSERT_NOT_NULL(c_schedule_model_for("znver3"));
+    TEST_ASSERT_NULL(c_schedule_model_for("i386"));
+}
+
+void test_schedule_starts_loads_before_division(void) {
+    char result[4096] = {0};
+    c_mir_function *function = c_mir_function_create("f");
+
+    emit2(function, C_MIR_MOV, reg(C_X86_RAX), reg(C_X86_RCX));
+    c_mir_append(function, c_mir_make0(C_MIR_CDQ));
+    c_mir_append(function, c_mir_make1(C_MIR_IDIV, reg(C_X86_R8)));
+    emit2(function, C_MIR_MOV, reg(C_X86_R9), reg(C_X86_RAX));
+    emit2(function, C_MIR_MOV, reg(C_X86_R10), slot(-4));
+    emit2(function, C_MIR_ADD, reg(C_X86_R10), reg(C_X86_R9));
+    c_mir_append(function, c_mir_make0(C_MIR_RET));
+
+    c_schedule_function(function, c_schedule_model_for("skylake"));
+    print(function, result);
+
+    TEST_ASSERT_TRUE(position(result, "    mov r10d, dword [rbp-4]\n")
+                     < position(result, "    idiv r8d\n"));
+    TEST_ASSERT_TRUE(position(result, "    cdq\n")
+                     < position(result, "    idiv r8d\n"));
+    TEST_ASSERT_TRUE(position(result, "    idiv r8d\n")
+                     < position(result, "    mov r9d, eax\n"));
+    TEST_ASSERT_TRUE(position(result, "    mov r9d, eax\n")
+                     < position(result, "    add r10d, r9d\n"));
+    TEST_ASSERT_TRUE(position(result, "    add r10d, r9d\n")
+                     < position(result, "    ret\n"));
+
+    c_mir_function_free(function);
+}
+
+void test_schedule_keeps_memory_and_flag_order(void) {
+    char result[4096] = {0};
+    c_mir_function *function = c_mir_function_create("f");
+
+    emit2(function, C_MIR_IMUL, reg(C_X86_RCX), reg(C_X86_RCX));
+    emit2(function, C_MIR_MOV, slot(-4), reg(C_X86_RCX));
+    emit2(function, C_MIR_MOV, reg(C_X86_RDX), slot(-4));
+    emit2(function, C_MIR_MOV, reg(C_X86_RSI), slot(-8));
+    emit2(function, C_MIR_TEST, reg(C_X86_RDX), reg(C_X86_RDX));
+    c_mir_append(function, c_mir_make1(C_MIR_JZ, c_mir_label_operand(0)));
+
+    c_schedule_function(function, c_schedule_model_for("generic"));
+    print(function, result);
+
+    // NOTE: the other slot does not wait for the store
+    TEST_ASSERT_TRUE(position(result, "    mov esi, dword [rbp-8]\n")
+                     < position(result, "    mov dword [rbp-4], ecx\n"));
+    TEST_ASSERT_TRUE(position(result, "    mov dword [rbp-4], ecx\n")
+                     < position(result, "    mov edx, dword [rbp-4]\n"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "    test edx, edx\n"
+                                        "    jz f\n"));
+
+    c_mir_function_free(function);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_schedule_models_by_name);
+    RUN_TEST(test_schedule_starts_loads_before_division);
+    RUN_TEST(test_schedule_keeps_memory_and_flag_order);
+    return UNITY_END();
+}
@@ -0,0 +1,159 @@
+#include <limits.h>
+#include <stdint.h>
+#include "unity.h"
+#include "strength_reduction.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static uint64_t multiply_high_unsigned(uint64_t a, uint64_t b) {
+    uint64_t a_low = a & 0xffffffff;
+    uint64_t a_high = a >> 32;
+    uint64_t b_low = b & 0xffffffff;
+    uint64_t b_high = b >> 32;
+
+    uint64_t low = a_low * b_low;
+    uint64_t middle = a_high * b_low + (low >> 32);
+    uint64_t carry = (middle & 0xffffffff) + a_low * b_high;
+
+    return a_high * b_high + (middle >> 32) + (carry >> 32);
+}
+
+static int64_t multiply_high_signed(int64_t a, int64_t b) {
+    uint64_t high = multiply_high_unsigned((uint64_t)a, (uint64_t)b);
+
+    if (a < 0) {
+        high -= (uint64_t)b;
+    }
+    if (b < 0) {
+        high -= (uint64_t)a;
+    }
+
+    return (int64_t)high;
+}
+
+// NOTE: mirrors the instruction sequence the backend emits
+static int64_t signed_divide(int64_t n, int64_t d, int bits) {
+    c_magic_number magic = c_strength_signed_magic(d, bits);
+    int64_t q;
+
+    if (bits == 32) {
+        q = (magic.multiplier * n) >> 32;
+    } else {
+        q = multiply_high_signed(magic.multiplier, n);
+    }
+
+    if (d > 0 && magic.multiplier < 0) {
+        q += n;
+    } else if (d < 0 && magic.multiplier > 0) {
+        q -= n;
+    }
+
+    q >>= magic.shift;
+
+    return q + (q < 0);
+}
+
+static uint64_t unsigned_divide(uint64_t n, uint64_t d, int bits) {
+    c_magic_number magic = c_strength_unsigned_magic(d, bits);
+    uint64_t m = (uint64_t)magic.multiplier;
+    uint64_t t;
+
+    if (bits == 32) {
+        t = ((m & 0xffffffff) * n) >> 32;
+    } else {
+        t = multiply_high_unsigned(m, n);
+    }
+
+    if (magic.add) {
+        return (((n - t) >> 1) + t) >> (magic.shift - 1);
+    }
+
+    return t >> magic.shift;
+}
+
+static const int64_t divisors[] = {
+    2, 3, 5, 6, 7, 9, 10, 11, 12, 25, 100, 125, 641, 1000, 65537,
+    1000000007, INT_MAX, -2, -3, -5, -7, -10, -641, -1000, INT_MIN + 1,
+};
+
+static const int64_t dividends[] = {
+    0, 1, -1, 2, -2, 3, -3, 6, -6, 7, -7, 99, -99, 100, -100, 101, -101,
+    12345, -12345, 1000000006, -1000000006, INT_MAX, INT_MIN, INT_MAX - 1,
+    INT_MIN + 1,
+};
+
+#define COUNT(array) (int)(sizeof(array) / sizeof(array[0]))
+
+void test_strength_signed_magic_is_exact(void) {
+    for (int i = 0; i < COUNT(divisors); i++) {
+        int64_t d = divisors[i];
+
+        if (d > 0 && c_strength_is_power_of_two((uint64_t)d)) {
+            continue;
+        }
+
+        for (int j = 0; j < COUNT(dividends); j++) {
+            int64_t n = dividends[j];
+
+            TEST_ASSERT_EQUAL_INT64(n / d, signed_divide(n, d, 32));
+            TEST_ASSERT_EQUAL_INT64(n / d, signed_divide(n, d, 64));
+
+            int64_t wide = n * 1000003;
+            TEST_ASSERT_EQUAL_INT64(wide / d, signed_divide(wide, d, 64));
+        }
+    }
+}
+
+void test_strength_unsigned_magic_is_exact(void) {
+    for (int i = 0; i < COUNT(divisors); i++) {
+        if (divisors[i] < 2 || c_strength_is_power_of_two(divisors[i])) {
+            continue;
+        }
+
+        uint64_t d = (uint64_t)divisors[i];
+
+        for (int j = 0; j < COUNT(dividends); j++) {
+            uint64_t n = (uint32_t)dividends[j];
+
+            TEST_ASSERT_EQUAL_UINT64(n / d, unsigned_divide(n, d, 32));
+            TEST_ASSERT_EQUAL_UINT64(n / d, unsigned_divide(n, d, 64));
+
+            uint64_t wide = (uint64_t)dividends[j];
+            TEST_ASSERT_EQUAL_UINT64(wide / d, unsigned_divide(wide, d, 64));
+        }
+    }
+}
+
+void test_strength_decompose_multiply(void) {
+    int lea_scale;
+    int shift;
+    int negate;
+
+    TEST_ASSERT_TRUE(c_strength_decompose_multiply(8, &lea_scale, &shift, &negate));
+    TEST_ASSERT_EQUAL(0, lea_scale);
+    TEST_ASSERT_EQUAL(3, shift);
+    TEST_ASSERT_FALSE(negate);
+
+    TEST_ASSERT_TRUE(c_strength_decompose_multiply(-20, &lea_scale, &shift, &negate));
+    TEST_ASSERT_EQUAL(4, lea_scale);
+    TEST_ASSERT_EQUAL(2, shift);
+    TEST_ASSERT_TRUE(negate);
+
+    TEST_ASSERT_TRUE(c_strength_decompose_multiply(9, &lea_scale, &shift, &negate));
+    TEST_ASSERT_EQUAL(8, lea_scale);
+    TEST_ASSERT_EQUAL(0, shift);
+
+    TEST_ASSERT_FALSE(c_strength_decompose_multiply(7, &lea_scale, &shift, &negate));
+    TEST_ASSERT_FALSE(c_strength_decompose_multiply(0, &lea_scale, &shift, &negate));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_strength_signed_magic_is_exact);
+    RUN_TEST(test_strength_unsigned_magic_is_exact);
+    RUN_TEST(test_strength_decompose_multiply);
+    return UNITY_END();
+}
@@ -0,0 +1,38 @@
+#include "test_program.h"
+#include "unity.h"
+#include "lexer.h"
+#include "stb_ds.h"
+
+test_program test_program_parse(const char *source) {
+    test_program fixture = {0};
+    fixture.error_context = c_error_context_create();
+    c_lexer *lexer = c_lexer_create(source);
+    c_token *tokens = c_lexer_lex(lexer);
+    c_lexer_free(lexer);
+    fixture.parser =
+        c_parser_create(tokens, fixture.error_context, TEST_PROGRAM_FILENAME);
+    fixture.program = c_parser_parse(fixture.parser);
+
+    TEST_ASSERT_FALSE(c_error_context_has_errors(fixture.error_context));
+
+    return fixture;
+}
+
+void test_program_free(test_program fixture) {
+    c_parser_free_program(fixture.program);
+    c_parser_free(fixture.parser);
+    c_error_context_free(fixture.error_context);
+}
+
+c_ast_block *test_program_main(test_program fixture) {
+    c_ast_function_declaration **functions =
+        fixture.program->function_declarations;
+    return functions[arrlen(functions) - 1]->body;
+}
+
+c_ast_expression *test_program_returned(test_program fixture) {
+    c_ast_block *body = test_program_main(fixture);
+    c_ast_statement *last = body->statements[arrlen(body->statements) - 1];
+    TEST_ASSERT_EQUAL(C_STATEMENT_RETURN, last->type);
+    return last->return_statement->value;
+}
@@ -0,0 +1,25 @@
+#ifndef TEST_PROGRAM_H
+#define TEST_PROGRAM_H
+
+#include "parser.h"
+
+#define TEST_PROGRAM_FILENAME "test_filename.c"
+
+// NOTE: a parsed source, the error context collects what the passes
+// under test report
+typedef struct {
+    c_error_context *error_context;
+    c_parser *parser;
+    c_ast_program *program;
+} test_program;
+
+// NOTE: fails the running test when the source does not parse
+test_program test_program_parse(const char *source);
+void test_program_free(test_program fixture);
+
+// NOTE: main is the last function in every test source
+c_ast_block *test_program_main(test_program fixture);
+// NOTE: the value of the return that ends main
+c_ast_expression *test_program_returned(test_program fixture);
+
+#endif  // !TEST_PROGRAM_H